@@ -38,6 +38,7 @@
 #include "FeatureOptions.h"
 #include "FieldInformation.h"
 #include "ImageOptions.h"
+#include "LandmarkStatistics.h"
 #include "vtkMaptkCamera.h"
 #include "vtkMaptkFeatureTrackRepresentation.h"
 
@@ -48,6 +49,7 @@
 #include <vtkCamera.h>
 #include <vtkCellArray.h>
 #include <vtkDoubleArray.h>
+#include <vtkIdTypeArray.h>
 #include <vtkImageActor.h>
 #include <vtkImageData.h>
 #include <vtkInteractorStyleRubberBand2D.h>
@@ -59,6 +61,8 @@
 #include <vtkProperty.h>
 #include <vtkRenderer.h>
 #include <vtkRenderWindow.h>
+#include <vtkSMPThreadLocal.h>
+#include <vtkSMPTools.h>
 #include <vtkUnsignedCharArray.h>
 #include <vtkUnsignedIntArray.h>
 
@@ -70,6 +74,8 @@
 #include <QtGui/QToolButton>
 #include <QtGui/QWidgetAction>
 
+#include <algorithm>
+
 QTE_IMPLEMENT_D_FUNC(CameraView)
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -144,6 +150,7 @@ public:
     VertexCloud();
 
     void clear();
+    void setCells(vtkIdType count, vtkIdType size);
 
     vtkNew<vtkPoints> points;
     vtkNew<vtkCellArray> verts;
@@ -158,6 +165,7 @@ public:
     PointCloud();
 
     void addPoint(double x, double y, double z);
+    void setPoints(double const* xy, vtkIdType count, double z);
   };
 
   struct SegmentCloud : VertexCloud
@@ -166,6 +174,7 @@ public:
 
     void addSegment(double x1, double y1, double z1,
                     double x2, double y2, double z2);
+    void setSegments(double const* xyxy, vtkIdType count, double z);
   };
 
   struct LandmarkCloud : PointCloud
@@ -173,6 +182,8 @@ public:
     LandmarkCloud();
 
     void addPoint(double x, double y, double z, LandmarkData const& data);
+    void setPoints(double const* xy, vtkIdType count, double z,
+                   LandmarkData const* data);
 
     void clear();
 
@@ -190,6 +201,8 @@ public:
 
   void updateFeatures(CameraView* q);
 
+  LandmarkData landmarkDataFor(kwiver::vital::landmark_id_t id) const;
+
   Ui::CameraView UI;
   Am::CameraView AM;
 
@@ -204,7 +217,9 @@ public:
   LandmarkCloud landmarks;
   SegmentCloud residuals;
 
-  QHash<kwiver::vital::landmark_id_t, LandmarkData> landmarkData;
+  // Landmark data, sorted by landmark ID
+  std::vector<kwiver::vital::landmark_id_t> landmarkIds;
+  std::vector<LandmarkData> landmarkData;
 
   PointOptions* landmarkOptions;
 
@@ -239,6 +254,27 @@ void CameraViewPrivate::VertexCloud::clear()
   this->verts->Modified();
 }
 
+//-----------------------------------------------------------------------------
+void CameraViewPrivate::VertexCloud::setCells(vtkIdType count, vtkIdType size)
+{
+  // Build all cells at once; each uses the next 'size' points in order
+  vtkNew<vtkIdTypeArray> cells;
+  cells->SetNumberOfValues(count * (size + 1));
+
+  auto* out = cells->GetPointer(0);
+  for (vtkIdType i = 0, id = 0; i < count; ++i)
+  {
+    *out++ = size;
+    for (vtkIdType k = 0; k < size; ++k)
+    {
+      *out++ = id++;
+    }
+  }
+
+  this->verts->SetCells(count, cells.GetPointer());
+  this->verts->Modified();
+}
+
 //-----------------------------------------------------------------------------
 CameraViewPrivate::PointCloud::PointCloud()
 {
@@ -257,6 +293,20 @@ void CameraViewPrivate::PointCloud::addPoint(double x, double y, double z)
   this->verts->Modified();
 }
 
+//-----------------------------------------------------------------------------
+void CameraViewPrivate::PointCloud::setPoints(
+  double const* xy, vtkIdType count, double z)
+{
+  this->points->SetNumberOfPoints(count);
+  for (vtkIdType i = 0; i < count; ++i)
+  {
+    this->points->SetPoint(i, xy[2 * i], xy[2 * i + 1], z);
+  }
+  this->points->Modified();
+
+  this->setCells(count, 1);
+}
+
 //-----------------------------------------------------------------------------
 CameraViewPrivate::SegmentCloud::SegmentCloud()
 {
@@ -280,6 +330,20 @@ void CameraViewPrivate::SegmentCloud::addSegment(
   this->verts->Modified();
 }
 
+//-----------------------------------------------------------------------------
+void CameraViewPrivate::SegmentCloud::setSegments(
+  double const* xyxy, vtkIdType count, double z)
+{
+  this->points->SetNumberOfPoints(2 * count);
+  for (vtkIdType i = 0; i < 2 * count; ++i)
+  {
+    this->points->SetPoint(i, xyxy[2 * i], xyxy[2 * i + 1], z);
+  }
+  this->points->Modified();
+
+  this->setCells(count, 2);
+}
+
 //-----------------------------------------------------------------------------
 CameraViewPrivate::LandmarkCloud::LandmarkCloud()
 {
@@ -330,6 +394,33 @@ void CameraViewPrivate::LandmarkCloud::addPoint(
   this->elevations->Modified();
 }
 
+//-----------------------------------------------------------------------------
+void CameraViewPrivate::LandmarkCloud::setPoints(
+  double const* xy, vtkIdType count, double z, LandmarkData const* data)
+{
+  this->PointCloud::setPoints(xy, count, z);
+
+  this->colors->SetNumberOfTuples(count);
+  this->observations->SetNumberOfTuples(count);
+  this->elevations->SetNumberOfTuples(count);
+
+  auto* const colors = this->colors->GetPointer(0);
+  auto* const observations = this->observations->GetPointer(0);
+  auto* const elevations = this->elevations->GetPointer(0);
+  for (vtkIdType i = 0; i < count; ++i)
+  {
+    colors[3 * i + 0] = data[i].color.r;
+    colors[3 * i + 1] = data[i].color.g;
+    colors[3 * i + 2] = data[i].color.b;
+    observations[i] = data[i].observations;
+    elevations[i] = data[i].elevation;
+  }
+
+  this->colors->Modified();
+  this->observations->Modified();
+  this->elevations->Modified();
+}
+
 //END geometry helpers
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -388,6 +479,19 @@ void CameraViewPrivate::updateFeatures(CameraView* q)
   }
 }
 
+//-----------------------------------------------------------------------------
+LandmarkData CameraViewPrivate::landmarkDataFor(
+  kwiver::vital::landmark_id_t id) const
+{
+  auto const iter =
+    std::lower_bound(this->landmarkIds.begin(), this->landmarkIds.end(), id);
+  if (iter == this->landmarkIds.end() || *iter != id)
+  {
+    return LandmarkData{};
+  }
+  return this->landmarkData[iter - this->landmarkIds.begin()];
+}
+
 //END CameraViewPrivate implementation
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -562,56 +666,75 @@ void CameraView::setLandmarksData(kwiver::vital::landmark_map const& lm)
   QTE_D();
 
   auto const& landmarks = lm.landmarks();
+  auto const size = landmarks.size();
+
+  // Gather the landmarks (in order of ID) so they can be visited in parallel
+  auto landmarkPtrs = std::vector<kwiver::vital::landmark const*>{};
+  landmarkPtrs.reserve(size);
+  d->landmarkIds.clear();
+  d->landmarkIds.reserve(size);
+  for (auto const& lmi : landmarks)
+  {
+    d->landmarkIds.push_back(lmi.first);
+    landmarkPtrs.push_back(lmi.second.get());
+  }
 
-  auto const defaultColor = kwiver::vital::rgb_color{};
-  auto haveColor = false;
-  auto maxObservations = unsigned{0};
-  auto minZ = qInf(), maxZ = -qInf();
+  // Extract landmark data and compute statistics in parallel
+  d->landmarkData.resize(size);
 
-  foreach (auto const& lmi, landmarks)
-  {
-    auto const z = lmi.second->loc()[2];
-    auto const& color = lmi.second->color();
-    auto const observations = lmi.second->observations();
-    auto const ld = LandmarkData{color, z, observations};
+  auto* const out = d->landmarkData.data();
+  vtkSMPThreadLocal<LandmarkStatistics> localStatistics;
 
-    d->landmarkData.insert(lmi.first, ld);
+  auto extract = [&](vtkIdType begin, vtkIdType end){
+    auto& stats = localStatistics.Local();
+    for (auto i = begin; i < end; ++i)
+    {
+      auto const& lm = *landmarkPtrs[i];
+      auto const z = lm.loc()[2];
+      auto const& color = lm.color();
+      auto const observations = lm.observations();
 
-    haveColor = haveColor || (color != defaultColor);
-    maxObservations = qMax(maxObservations, observations);
-    minZ = qMin(minZ, z);
-    maxZ = qMax(maxZ, z);
-  }
+      out[i] = LandmarkData{color, z, observations};
+      stats.add(color, z, observations);
+    }
+  };
+  vtkSMPTools::For(0, static_cast<vtkIdType>(size), extract);
+
+  auto const stats = LandmarkStatistics::combine(localStatistics);
 
   auto fields = QHash<QString, FieldInformation>{};
-  fields.insert("Elevation", FieldInformation{Elevation, {minZ, maxZ}});
-  if (maxObservations)
+  fields.insert("Elevation",
+                FieldInformation{Elevation, {stats.minZ, stats.maxZ}});
+  if (stats.maxObservations)
   {
-    auto const upper = static_cast<double>(maxObservations);
+    auto const upper = static_cast<double>(stats.maxObservations);
     fields.insert("Observations", FieldInformation{Observations, {0.0, upper}});
   }
 
-  d->landmarkOptions->setTrueColorAvailable(haveColor);
+  d->landmarkOptions->setTrueColorAvailable(stats.haveColor);
   d->landmarkOptions->setDataFields(fields);
 }
 
 //-----------------------------------------------------------------------------
-void CameraView::addFeatureTrack(kwiver::vital::track const& track)
+void CameraView::addFeatureTrack(kwiver::vital::track const& track,
+                                 kwiver::vital::frame_id_t firstFrame)
 {
   QTE_D();
 
-  auto const id = track.id();
+  auto const minFrame = qMax(firstFrame, kwiver::vital::frame_id_t{0});
+  d->featureRep->AddTrack(track, static_cast<unsigned>(minFrame));
 
-  foreach (auto const& state, track)
-  {
-    auto const& fts = std::dynamic_pointer_cast<kwiver::vital::feature_track_state>(state);
-    if ( !fts )
-    {
-      continue;
-    }
-    auto const& loc = fts->feature->loc();
-    d->featureRep->AddTrackPoint(id, state->frame(), loc[0], loc[1]);
-  }
+  d->updateFeatures(this);
+}
+
+//-----------------------------------------------------------------------------
+void CameraView::setFeatureTracks(
+  kwiver::vital::feature_track_set const& tracks)
+{
+  QTE_D();
+
+  d->featureRep->ClearTrackData();
+  d->featureRep->AddTracks(tracks);
 
   d->updateFeatures(this);
 }
@@ -622,7 +745,7 @@ void CameraView::addLandmark(
 {
   QTE_D();
 
-  d->landmarks.addPoint(x, y, 0.0, d->landmarkData.value(id));
+  d->landmarks.addPoint(x, y, 0.0, d->landmarkDataFor(id));
 
   d->UI.renderWidget->update();
 }
@@ -640,6 +763,38 @@ void CameraView::addResidual(
   d->UI.renderWidget->update();
 }
 
+//-----------------------------------------------------------------------------
+void CameraView::setLandmarks(
+  std::vector<kwiver::vital::landmark_id_t> const& ids,
+  std::vector<double> const& points)
+{
+  QTE_D();
+
+  auto const count = static_cast<vtkIdType>(ids.size());
+
+  auto data = std::vector<LandmarkData>{};
+  data.reserve(ids.size());
+  for (auto const id : ids)
+  {
+    data.push_back(d->landmarkDataFor(id));
+  }
+
+  d->landmarks.setPoints(points.data(), count, 0.0, data.data());
+
+  d->UI.renderWidget->update();
+}
+
+//-----------------------------------------------------------------------------
+void CameraView::setResiduals(std::vector<double> const& segments)
+{
+  QTE_D();
+
+  auto const count = static_cast<vtkIdType>(segments.size() / 4);
+  d->residuals.setSegments(segments.data(), count, -0.2);
+
+  d->UI.renderWidget->update();
+}
+
 //-----------------------------------------------------------------------------
 void CameraView::clearLandmarks()
 {
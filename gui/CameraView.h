@@ -37,8 +37,11 @@
 
 #include <QtGui/QWidget>
 
+#include <vector>
+
 class vtkImageData;
 
+namespace kwiver { namespace vital { class feature_track_set; } }
 namespace kwiver { namespace vital { class landmark_map; } }
 namespace kwiver { namespace vital { class track; } }
 
@@ -54,7 +57,22 @@ public:
   explicit CameraView(QWidget* parent = 0, Qt::WindowFlags flags = 0);
   virtual ~CameraView();
 
-  void addFeatureTrack(kwiver::vital::track const&);
+  void addFeatureTrack(kwiver::vital::track const&,
+                       kwiver::vital::frame_id_t firstFrame = 0);
+  void setFeatureTracks(kwiver::vital::feature_track_set const&);
+
+  /// Replace the displayed landmarks.
+  ///
+  /// The image coordinates of the landmarks are given in \p points as
+  /// interleaved (x, y) pairs, in the same order as \p ids.
+  void setLandmarks(std::vector<kwiver::vital::landmark_id_t> const& ids,
+                    std::vector<double> const& points);
+
+  /// Replace the displayed residuals.
+  ///
+  /// Each residual is given in \p segments as four values: the feature
+  /// location (x, y) followed by the projected landmark location (x, y).
+  void setResiduals(std::vector<double> const& segments);
 
 public slots:
   void setBackgroundColor(QColor const&);
@@ -0,0 +1,444 @@
+/*ckwg +29
+ * Copyright 2017 by Kitware, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ *  * Neither name of Kitware, Inc. nor the names of any contributors may be used
+ *    to endorse or promote products derived from this software without specific
+ *    prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "ImageCache.h"
+
+#include <vtkImageData.h>
+#include <vtkImageReader2.h>
+#include <vtkImageReader2Collection.h>
+#include <vtkImageReader2Factory.h>
+#include <vtkNew.h>
+
+#include <QtCore/QDateTime>
+#include <QtCore/QDebug>
+#include <QtCore/QFileInfo>
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <QtCore/QRunnable>
+#include <QtCore/QSet>
+#include <QtCore/QStringList>
+#include <QtCore/QThread>
+#include <QtCore/QThreadPool>
+
+///////////////////////////////////////////////////////////////////////////////
+
+//BEGIN helper functions
+
+namespace // anonymous
+{
+
+//-----------------------------------------------------------------------------
+QDateTime lastModified(QString const& path)
+{
+  // Invalid if the file does not exist, so that a file which is created later
+  // does not match
+  return QFileInfo(path).lastModified();
+}
+
+//-----------------------------------------------------------------------------
+vtkSmartPointer<vtkImageData> decodeImage(QString const& path)
+{
+  // Create a reader capable of reading the image file
+  auto const reader = vtkSmartPointer<vtkImageReader2>::Take(
+    vtkImageReader2Factory::CreateImageReader2(qPrintable(path)));
+  if (!reader)
+  {
+    qWarning() << "Failed to create image reader for image" << path;
+    return 0;
+  }
+
+  // Load the image
+  reader->SetFileName(qPrintable(path));
+  reader->Update();
+
+  // Test for errors
+  auto const data = reader->GetOutput();
+  int dimensions[3];
+  data->GetDimensions(dimensions);
+
+  if (dimensions[0] < 2 || dimensions[1] < 2)
+  {
+    qWarning() << "Failed to read image" << path;
+    return 0;
+  }
+
+  return data;
+}
+
+} // namespace <anonymous>
+
+//END helper functions
+
+///////////////////////////////////////////////////////////////////////////////
+
+//BEGIN ImageCachePrivate
+
+//-----------------------------------------------------------------------------
+class ImageCachePrivate
+{
+public:
+  struct Entry
+  {
+    vtkSmartPointer<vtkImageData> data;
+    qint64 size;
+    QDateTime modified; // Of the file when it was decoded
+  };
+
+  ImageCachePrivate(ImageCache* q)
+    : memoryBudget(0), memoryUsed(0), activeLoaders(0), q_ptr(q) {}
+
+  int rank(QString const& path) const;
+
+  void startLoaders();
+  void insert(QString const& path, vtkSmartPointer<vtkImageData> const& data,
+              QDateTime const& modified);
+  void remove(QString const& path);
+  void evict();
+
+  void notify(QString const& path);
+
+  QThreadPool loaders;
+
+  // All members below are protected by the mutex
+  mutable QMutex mutex;
+
+  QHash<QString, Entry> entries;
+  QStringList recentlyUsed; // Least recently used first
+
+  qint64 memoryBudget;
+  qint64 memoryUsed;
+
+  QString requested;
+  QHash<QString, int> prefetchRanks;
+
+  QStringList queue;
+  QSet<QString> decoding;
+  int activeLoaders;
+
+protected:
+  QTE_DECLARE_PUBLIC_PTR(ImageCache)
+  QTE_DECLARE_PUBLIC(ImageCache)
+};
+
+QTE_IMPLEMENT_D_FUNC(ImageCache)
+
+//-----------------------------------------------------------------------------
+class ImageCacheLoader : public QRunnable
+{
+public:
+  ImageCacheLoader(ImageCachePrivate* d) : d(d) {}
+
+  virtual void run() QTE_OVERRIDE;
+
+protected:
+  ImageCachePrivate* const d;
+};
+
+//-----------------------------------------------------------------------------
+void ImageCacheLoader::run()
+{
+  QMutexLocker locker(&d->mutex);
+
+  while (!d->queue.isEmpty())
+  {
+    auto const path = d->queue.takeFirst();
+    d->decoding.insert(path);
+    locker.unlock();
+
+    // Get the modification time first, so that if the file is rewritten while
+    // it is being decoded, the entry is seen as stale
+    auto const modified = lastModified(path);
+    auto const data = decodeImage(path);
+
+    locker.relock();
+    d->decoding.remove(path);
+    d->insert(path, data, modified);
+
+    d->notify(path);
+  }
+
+  --d->activeLoaders;
+}
+
+//-----------------------------------------------------------------------------
+void ImageCachePrivate::notify(QString const& path)
+{
+  QTE_Q();
+
+  // Emit on the thread that owns the cache, not the loader thread
+  QMetaObject::invokeMethod(q, "imageReady", Qt::QueuedConnection,
+                            Q_ARG(QString, path));
+}
+
+//-----------------------------------------------------------------------------
+int ImageCachePrivate::rank(QString const& path) const
+{
+  // Lower rank means more important to keep; -1 means not wanted
+  return (path == this->requested ? 0 : this->prefetchRanks.value(path, -1));
+}
+
+//-----------------------------------------------------------------------------
+void ImageCachePrivate::startLoaders()
+{
+  auto const maxLoaders = this->loaders.maxThreadCount();
+  while (this->activeLoaders < qMin(maxLoaders, this->queue.count()))
+  {
+    ++this->activeLoaders;
+    this->loaders.start(new ImageCacheLoader(this));
+  }
+}
+
+//-----------------------------------------------------------------------------
+void ImageCachePrivate::insert(
+  QString const& path, vtkSmartPointer<vtkImageData> const& data,
+  QDateTime const& modified)
+{
+  // VTK reports memory size in KiB
+  auto const size =
+    (data ? static_cast<qint64>(data->GetActualMemorySize()) << 10 : 0);
+
+  this->remove(path);
+  this->entries.insert(path, Entry{data, size, modified});
+  this->recentlyUsed.append(path);
+  this->memoryUsed += size;
+
+  this->evict();
+}
+
+//-----------------------------------------------------------------------------
+void ImageCachePrivate::remove(QString const& path)
+{
+  auto const i = this->entries.find(path);
+  if (i != this->entries.end())
+  {
+    this->memoryUsed -= i->size;
+    this->entries.erase(i);
+    this->recentlyUsed.removeOne(path);
+  }
+}
+
+//-----------------------------------------------------------------------------
+void ImageCachePrivate::evict()
+{
+  while (this->memoryUsed > this->memoryBudget)
+  {
+    // Prefer to evict the least recently used image that is not wanted
+    auto victim = QString{};
+    foreach (auto const& path, this->recentlyUsed)
+    {
+      if (this->rank(path) < 0)
+      {
+        victim = path;
+        break;
+      }
+    }
+
+    // Otherwise, evict the wanted image that is least important, unless that
+    // is the requested image
+    if (victim.isEmpty())
+    {
+      auto victimRank = 0;
+      foreach (auto const& path, this->recentlyUsed)
+      {
+        auto const r = this->rank(path);
+        if (r > victimRank)
+        {
+          victim = path;
+          victimRank = r;
+        }
+      }
+
+      if (victim.isEmpty())
+      {
+        return;
+      }
+
+      // Any queued prefetches that are even less important would just be
+      // evicted again; don't bother decoding them
+      foreach (auto const& path, this->queue)
+      {
+        if (this->rank(path) > victimRank)
+        {
+          this->queue.removeOne(path);
+        }
+      }
+    }
+
+    this->remove(victim);
+  }
+}
+
+//END ImageCachePrivate
+
+///////////////////////////////////////////////////////////////////////////////
+
+//BEGIN ImageCache
+
+//-----------------------------------------------------------------------------
+ImageCache::ImageCache(QObject* parent)
+  : QObject(parent), d_ptr(new ImageCachePrivate(this))
+{
+  QTE_D();
+
+  // Ensure the reader factory is initialized before it is used from the
+  // loader threads
+  vtkNew<vtkImageReader2Collection> readers;
+  vtkImageReader2Factory::GetRegisteredReaders(readers.GetPointer());
+
+  // Leave a core for the UI; decoding is mostly I/O bound past a few threads
+  d->loaders.setMaxThreadCount(qBound(1, QThread::idealThreadCount() - 1, 4));
+}
+
+//-----------------------------------------------------------------------------
+ImageCache::~ImageCache()
+{
+  QTE_D();
+
+  d->mutex.lock();
+  d->queue.clear();
+  d->mutex.unlock();
+
+  d->loaders.waitForDone();
+}
+
+//-----------------------------------------------------------------------------
+bool ImageCache::image(QString const& path, vtkSmartPointer<vtkImageData>& data)
+{
+  QTE_D();
+
+  auto const modified = lastModified(path);
+
+  QMutexLocker locker(&d->mutex);
+
+  d->requested = path;
+
+  // Entries (including failures) are only used if the file has not changed
+  // since it was decoded; otherwise the image is decoded again
+  auto const i = d->entries.constFind(path);
+  if (i != d->entries.constEnd())
+  {
+    if (i->modified == modified)
+    {
+      d->recentlyUsed.removeOne(path);
+      d->recentlyUsed.append(path);
+
+      data = i->data;
+      return true;
+    }
+
+    d->remove(path);
+  }
+
+  if (!d->decoding.contains(path))
+  {
+    d->queue.removeOne(path);
+    d->queue.prepend(path);
+    d->startLoaders();
+  }
+
+  return false;
+}
+
+//-----------------------------------------------------------------------------
+void ImageCache::prefetch(QStringList const& paths)
+{
+  QTE_D();
+
+  // Get modification times before locking, as the loaders must wait for the
+  // lock
+  auto modified = QHash<QString, QDateTime>{};
+  foreach (auto const& path, paths)
+  {
+    if (!path.isEmpty() && !modified.contains(path))
+    {
+      modified.insert(path, lastModified(path));
+    }
+  }
+
+  QMutexLocker locker(&d->mutex);
+
+  // Keep the requested image at the front of the queue
+  auto const requestQueued = d->queue.contains(d->requested);
+  d->queue.clear();
+  d->prefetchRanks.clear();
+
+  if (requestQueued)
+  {
+    d->queue.append(d->requested);
+  }
+
+  foreach (auto const& path, paths)
+  {
+    if (path.isEmpty() || d->prefetchRanks.contains(path))
+    {
+      continue;
+    }
+
+    d->prefetchRanks.insert(path, d->prefetchRanks.count() + 1);
+    if (path == d->requested || d->decoding.contains(path))
+    {
+      continue;
+    }
+
+    auto const i = d->entries.constFind(path);
+    if (i != d->entries.constEnd())
+    {
+      if (i->modified == modified.value(path))
+      {
+        continue;
+      }
+      d->remove(path);
+    }
+
+    d->queue.append(path);
+  }
+
+  d->startLoaders();
+}
+
+//-----------------------------------------------------------------------------
+qint64 ImageCache::memoryBudget() const
+{
+  QTE_D();
+  QMutexLocker locker(&d->mutex);
+  return d->memoryBudget;
+}
+
+//-----------------------------------------------------------------------------
+void ImageCache::setMemoryBudget(qint64 bytes)
+{
+  QTE_D();
+  QMutexLocker locker(&d->mutex);
+
+  d->memoryBudget = bytes;
+  d->evict();
+}
+
+//END ImageCache
@@ -0,0 +1,95 @@
+/*ckwg +29
+ * Copyright 2017 by Kitware, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ *  * Neither name of Kitware, Inc. nor the names of any contributors may be used
+ *    to endorse or promote products derived from this software without specific
+ *    prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef MAPTK_IMAGECACHE_H_
+#define MAPTK_IMAGECACHE_H_
+
+#include <qtGlobal.h>
+
+#include <QtCore/QObject>
+
+#include <vtkSmartPointer.h>
+
+class vtkImageData;
+
+class ImageCachePrivate;
+
+/// Memory-bounded cache of decoded images.
+///
+/// Images are decoded on background threads and kept in a least recently used
+/// cache whose total size is limited by the memory budget. Images that have
+/// not been decoded yet are never waited for; instead, #imageReady is emitted
+/// once they become available.
+class ImageCache : public QObject
+{
+  Q_OBJECT
+
+public:
+  explicit ImageCache(QObject* parent = 0);
+  virtual ~ImageCache();
+
+  /// Get the decoded image for \p path.
+  ///
+  /// If the image has been decoded, this sets \p data and returns \c true.
+  /// (\p data is null if the image could not be read.) Otherwise, the image is
+  /// scheduled for decoding ahead of any prefetch requests, and \c false is
+  /// returned. The most recently requested image is never evicted.
+  ///
+  /// An image whose file has been modified since it was decoded is decoded
+  /// again rather than returning the old result. This includes images that
+  /// could not be read, so that a file which is replaced or created later
+  /// will be shown.
+  bool image(QString const& path, vtkSmartPointer<vtkImageData>& data);
+
+  /// Set the images to decode in the background.
+  ///
+  /// This replaces any previous prefetch requests that have not yet started.
+  /// Images are decoded in the order given; when the cache is full, images
+  /// earlier in the list are kept in preference to later ones.
+  void prefetch(QStringList const& paths);
+
+  /// Get the maximum memory, in bytes, used by cached images.
+  qint64 memoryBudget() const;
+
+  /// Set the maximum memory, in bytes, used by cached images.
+  void setMemoryBudget(qint64 bytes);
+
+signals:
+  /// Emitted when a requested or prefetched image has finished decoding.
+  void imageReady(QString const& path);
+
+private:
+  QTE_DECLARE_PRIVATE_RPTR(ImageCache)
+  QTE_DECLARE_PRIVATE(ImageCache)
+
+  QTE_DISABLE_COPY(ImageCache)
+};
+
+#endif
@@ -0,0 +1,302 @@
+/*ckwg +29
+ * Copyright 2017 by Kitware, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ *  * Neither name of Kitware, Inc. nor the names of any contributors may be used
+ *    to endorse or promote products derived from this software without specific
+ *    prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "LandmarkIndex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace kv = kwiver::vital;
+
+namespace // anonymous
+{
+
+// Target average number of landmarks per grid cell
+static auto const LandmarksPerCell = 64.0;
+
+// Maximum number of grid cells along any axis
+static auto const MaxGridSize = 256;
+
+} // namespace <anonymous>
+
+//-----------------------------------------------------------------------------
+void LandmarkIndex::clear()
+{
+  this->ids.clear();
+  this->locations.clear();
+  this->cellOffsets.clear();
+  this->sortedIds.clear();
+  this->sortedSlots.clear();
+}
+
+//-----------------------------------------------------------------------------
+void LandmarkIndex::build(kv::landmark_map const& landmarks)
+{
+  this->clear();
+
+  auto const& lm = landmarks.landmarks();
+  auto const n = lm.size();
+  if (!n)
+  {
+    return;
+  }
+
+  // Gather landmark locations (in order of ID) and compute their bounds
+  auto const inf = std::numeric_limits<double>::infinity();
+  double lower[3] = { +inf, +inf, +inf };
+  double upper[3] = { -inf, -inf, -inf };
+
+  auto gathered = std::vector<double>{};
+  gathered.reserve(3 * n);
+  this->sortedIds.reserve(n);
+
+  for (auto const& lmi : lm)
+  {
+    auto const& loc = lmi.second->loc();
+    this->sortedIds.push_back(lmi.first);
+    for (int k = 0; k < 3; ++k)
+    {
+      gathered.push_back(loc[k]);
+      lower[k] = std::min(lower[k], loc[k]);
+      upper[k] = std::max(upper[k], loc[k]);
+    }
+  }
+
+  // Choose cells that are roughly cubic; flat axes (e.g. the elevation of an
+  // aerial scene) get proportionally fewer cells
+  double extent[3];
+  for (int k = 0; k < 3; ++k)
+  {
+    extent[k] = upper[k] - lower[k];
+  }
+
+  auto const maxExtent = std::max({extent[0], extent[1], extent[2]});
+  auto const minExtent = 1e-3 * maxExtent;
+  auto const cells = std::max(1.0, static_cast<double>(n) / LandmarksPerCell);
+  auto const volume = std::max(extent[0], minExtent) *
+                      std::max(extent[1], minExtent) *
+                      std::max(extent[2], minExtent);
+  auto const edge = std::cbrt(volume / cells);
+
+  for (int k = 0; k < 3; ++k)
+  {
+    this->gridOrigin[k] = lower[k];
+    if (edge > 0.0 && extent[k] > 0.0)
+    {
+      auto const size = static_cast<int>(std::ceil(extent[k] / edge));
+      this->gridSize[k] = std::max(1, std::min(size, MaxGridSize));
+      this->cellSize[k] = extent[k] / this->gridSize[k];
+    }
+    else
+    {
+      this->gridSize[k] = 1;
+      this->cellSize[k] = 1.0;
+    }
+  }
+
+  // Assign landmarks to cells
+  auto const cellCount =
+    static_cast<size_t>(this->gridSize[0]) * this->gridSize[1] *
+    this->gridSize[2];
+
+  auto cellIndices = std::vector<size_t>(n);
+  this->cellOffsets.assign(cellCount + 1, 0);
+  for (size_t i = 0; i < n; ++i)
+  {
+    size_t index[3];
+    for (int k = 0; k < 3; ++k)
+    {
+      auto const t = (gathered[3 * i + k] - lower[k]) / this->cellSize[k];
+      auto const c = static_cast<int>(t);
+      index[k] = static_cast<size_t>(
+        std::max(0, std::min(c, this->gridSize[k] - 1)));
+    }
+
+    auto const cell =
+      (index[2] * this->gridSize[1] + index[1]) * this->gridSize[0] + index[0];
+    cellIndices[i] = cell;
+    ++this->cellOffsets[cell + 1];
+  }
+
+  // Sort landmarks by cell (counting sort, stable in ID order)
+  std::partial_sum(this->cellOffsets.begin(), this->cellOffsets.end(),
+                   this->cellOffsets.begin());
+
+  auto next = std::vector<size_t>(this->cellOffsets.begin(),
+                                  this->cellOffsets.end() - 1);
+  this->ids.resize(n);
+  this->locations.resize(3 * n);
+  this->sortedSlots.resize(n);
+  for (size_t i = 0; i < n; ++i)
+  {
+    auto const slot = next[cellIndices[i]]++;
+    this->ids[slot] = this->sortedIds[i];
+    std::copy(&gathered[3 * i], &gathered[3 * i] + 3,
+              &this->locations[3 * slot]);
+    this->sortedSlots[i] = slot;
+  }
+}
+
+//-----------------------------------------------------------------------------
+bool LandmarkIndex::find(
+  kv::landmark_id_t id, kv::vector_3d& location) const
+{
+  auto const iter =
+    std::lower_bound(this->sortedIds.begin(), this->sortedIds.end(), id);
+  if (iter == this->sortedIds.end() || *iter != id)
+  {
+    return false;
+  }
+
+  auto const slot = this->sortedSlots[iter - this->sortedIds.begin()];
+  auto const* const p = &this->locations[3 * slot];
+  location = kv::vector_3d{p[0], p[1], p[2]};
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+void LandmarkIndex::project(
+  kv::camera const& camera, int width, int height,
+  std::vector<kv::landmark_id_t>& outIds, std::vector<double>& outPoints) const
+{
+  outIds.clear();
+  outPoints.clear();
+
+  if (this->ids.empty())
+  {
+    return;
+  }
+
+  // Build the projection matrix; its last row gives the depth of a point
+  auto const& intrinsics = camera.intrinsics();
+  Eigen::Matrix3d const KR =
+    intrinsics->as_matrix() * camera.rotation().matrix();
+
+  Eigen::Matrix<double, 3, 4> P;
+  P.leftCols<3>() = KR;
+  P.col(3) = -(KR * camera.center());
+
+  auto const& dist = intrinsics->dist_coeffs();
+  auto const distorted =
+    std::any_of(dist.begin(), dist.end(), [](double k){ return k != 0.0; });
+
+  // Build the planes bounding the view frustum; with lens distortion, the
+  // planes are only used to reject cells, so widen them to allow for points
+  // that distortion moves into the image
+  auto const clip = (width > 0 && height > 0);
+  auto const mu = (distorted ? 0.25 * width : 0.0);
+  auto const mv = (distorted ? 0.25 * height : 0.0);
+
+  std::vector<Eigen::Vector4d> planes;
+  planes.push_back(P.row(2).transpose());
+  if (clip)
+  {
+    planes.push_back((P.row(0) + mu * P.row(2)).transpose());
+    planes.push_back(((width + mu) * P.row(2) - P.row(0)).transpose());
+    planes.push_back((P.row(1) + mv * P.row(2)).transpose());
+    planes.push_back(((height + mv) * P.row(2) - P.row(1)).transpose());
+  }
+
+  auto const gx = this->gridSize[0];
+  auto const gy = this->gridSize[1];
+  auto const gz = this->gridSize[2];
+
+  auto cell = size_t{0};
+  for (int iz = 0; iz < gz; ++iz)
+  {
+    for (int iy = 0; iy < gy; ++iy)
+    {
+      for (int ix = 0; ix < gx; ++ix, ++cell)
+      {
+        auto const first = this->cellOffsets[cell];
+        auto const last = this->cellOffsets[cell + 1];
+        if (first == last)
+        {
+          continue;
+        }
+
+        // Reject the cell if it lies entirely outside any frustum plane
+        double lower[3], upper[3];
+        int const index[3] = { ix, iy, iz };
+        for (int k = 0; k < 3; ++k)
+        {
+          auto const pad = 1e-6 * this->cellSize[k];
+          lower[k] = this->gridOrigin[k] + index[k] * this->cellSize[k] - pad;
+          upper[k] = lower[k] + this->cellSize[k] + 2.0 * pad;
+        }
+
+        auto const outside = std::any_of(
+          planes.begin(), planes.end(), [&](Eigen::Vector4d const& plane){
+            auto d = plane[3];
+            for (int k = 0; k < 3; ++k)
+            {
+              d += std::max(plane[k] * lower[k], plane[k] * upper[k]);
+            }
+            return d < 0.0;
+          });
+        if (outside)
+        {
+          continue;
+        }
+
+        // Project the landmarks in the cell
+        for (auto i = first; i < last; ++i)
+        {
+          auto const* const p = &this->locations[3 * i];
+          auto const h = (P * Eigen::Vector4d{p[0], p[1], p[2], 1.0}).eval();
+          if (h[2] <= 0.0)
+          {
+            continue;
+          }
+
+          auto u = h[0] / h[2];
+          auto v = h[1] / h[2];
+          if (distorted)
+          {
+            auto const& q = camera.project(kv::vector_3d{p[0], p[1], p[2]});
+            u = q[0];
+            v = q[1];
+          }
+
+          if (clip && (u < 0.0 || u > width || v < 0.0 || v > height))
+          {
+            continue;
+          }
+
+          outIds.push_back(this->ids[i]);
+          outPoints.push_back(u);
+          outPoints.push_back(v);
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,90 @@
+/*ckwg +29
+ * Copyright 2017 by Kitware, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ *  * Neither name of Kitware, Inc. nor the names of any contributors may be used
+ *    to endorse or promote products derived from this software without specific
+ *    prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef MAPTK_LANDMARKINDEX_H_
+#define MAPTK_LANDMARKINDEX_H_
+
+#include <vital/types/camera.h>
+#include <vital/types/landmark_map.h>
+
+#include <vector>
+
+/// Spatial index of landmark locations for projection into cameras.
+///
+/// Landmarks are bucketed into a uniform grid over their bounding box, so
+/// that cells which lie outside a camera's view frustum can be rejected
+/// without touching the landmarks inside them.
+class LandmarkIndex
+{
+public:
+  LandmarkIndex() {}
+
+  /// Rebuild the index from \p landmarks.
+  void build(kwiver::vital::landmark_map const& landmarks);
+  void clear();
+
+  bool isEmpty() const { return this->ids.empty(); }
+
+  /// Get the location of the landmark with the given \p id.
+  ///
+  /// \return \c false if the landmark is not in the index.
+  bool find(kwiver::vital::landmark_id_t id,
+            kwiver::vital::vector_3d& location) const;
+
+  /// Project landmarks that are visible in a camera.
+  ///
+  /// This finds the landmarks which are in front of \p camera and project to
+  /// within an image of size \p width by \p height. If either dimension is not
+  /// positive, all landmarks in front of the camera are returned. The IDs of
+  /// the landmarks are written to \p outIds, and their image coordinates are
+  /// written to \p outPoints as interleaved (x, y) pairs.
+  void project(kwiver::vital::camera const& camera, int width, int height,
+               std::vector<kwiver::vital::landmark_id_t>& outIds,
+               std::vector<double>& outPoints) const;
+
+protected:
+  // Landmarks sorted by grid cell
+  std::vector<kwiver::vital::landmark_id_t> ids;
+  std::vector<double> locations; // Interleaved (x, y, z)
+
+  // Offset of the first landmark in each cell, plus a final end offset
+  std::vector<size_t> cellOffsets;
+
+  // Grid geometry
+  int gridSize[3];
+  double gridOrigin[3];
+  double cellSize[3];
+
+  // Position in the sorted arrays of each landmark, in order of ID
+  std::vector<kwiver::vital::landmark_id_t> sortedIds;
+  std::vector<size_t> sortedSlots;
+};
+
+#endif
@@ -0,0 +1,69 @@
+/*ckwg +29
+ * Copyright 2017 by Kitware, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ *  * Neither name of Kitware, Inc. nor the names of any contributors may be used
+ *    to endorse or promote products derived from this software without specific
+ *    prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "LandmarkStatistics.h"
+
+#include <qtMath.h>
+
+//-----------------------------------------------------------------------------
+LandmarkStatistics::LandmarkStatistics()
+  : haveColor(false), maxObservations(0), minZ(qInf()), maxZ(-qInf())
+{
+}
+
+//-----------------------------------------------------------------------------
+void LandmarkStatistics::add(
+  kwiver::vital::rgb_color const& color, double elevation,
+  unsigned observations)
+{
+  static auto const defaultColor = kwiver::vital::rgb_color{};
+
+  this->haveColor = this->haveColor || (color != defaultColor);
+  this->maxObservations = qMax(this->maxObservations, observations);
+  this->minZ = qMin(this->minZ, elevation);
+  this->maxZ = qMax(this->maxZ, elevation);
+}
+
+//-----------------------------------------------------------------------------
+LandmarkStatistics LandmarkStatistics::combine(
+  vtkSMPThreadLocal<LandmarkStatistics>& localStatistics)
+{
+  auto result = LandmarkStatistics{};
+  for (auto iter = localStatistics.begin();
+       iter != localStatistics.end(); ++iter)
+  {
+    result.haveColor = result.haveColor || iter->haveColor;
+    result.maxObservations =
+      qMax(result.maxObservations, iter->maxObservations);
+    result.minZ = qMin(result.minZ, iter->minZ);
+    result.maxZ = qMax(result.maxZ, iter->maxZ);
+  }
+  return result;
+}
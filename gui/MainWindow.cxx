@@ -41,18 +41,23 @@
 #include "tools/TrackFilterTool.h"
 
 #include "AboutDialog.h"
+#include "ImageCache.h"
+#include "LandmarkIndex.h"
 #include "MatchMatrixWindow.h"
 #include "Project.h"
 #include "vtkMaptkImageDataGeometryFilter.h"
 #include "vtkMaptkImageUnprojectDepth.h"
 #include "vtkMaptkCamera.h"
 
+#include <maptk/camera_io.h>
+#include <maptk/feature_track_io.h>
+#include <maptk/match_matrix.h>
 #include <maptk/version.h>
 
 #include <vital/io/camera_io.h>
 #include <vital/io/landmark_map_io.h>
 #include <vital/io/track_set_io.h>
-#include <arrows/core/match_matrix.h>
+#include <vital/types/feature_track_set.h>
 
 #include <vtksys/SystemTools.hxx>
 
@@ -78,12 +83,21 @@
 #include <QtGui/QFileDialog>
 #include <QtGui/QMessageBox>
 
+#include <QtCore/QCryptographicHash>
 #include <QtCore/QDebug>
+#include <QtCore/QDir>
+#include <QtCore/QElapsedTimer>
 #include <QtCore/QQueue>
 #include <QtCore/QSignalMapper>
 #include <QtCore/QTimer>
 #include <QtCore/QUrl>
 
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <unordered_map>
+#include <vector>
+
 ///////////////////////////////////////////////////////////////////////////////
 
 //BEGIN miscellaneous helpers
@@ -91,12 +105,35 @@
 namespace // anonymous
 {
 
+// Bounds (in ms) of the interval at which intermediate tool results are shown;
+// the lower bound is about one frame at 30 Hz
+static auto const MinimumToolUpdateInterval = 33;
+static auto const MaximumToolUpdateInterval = 1000;
+
 //-----------------------------------------------------------------------------
 kwiver::vital::path_t kvPath(QString const& s)
 {
   return stdString(s);
 }
 
+//-----------------------------------------------------------------------------
+QString krtdCacheFile(QString const& cameraPath)
+{
+  // Keep the cache in the user's cache location rather than the project's
+  // camera directory, named for the absolute path of the camera directory
+  auto const base =
+    QDesktopServices::storageLocation(QDesktopServices::CacheLocation);
+  if (base.isEmpty() || !QDir().mkpath(base + "/cameras"))
+  {
+    return QString();
+  }
+
+  auto const dir = QFileInfo(cameraPath).absoluteFilePath();
+  auto const hash =
+    QCryptographicHash::hash(dir.toUtf8(), QCryptographicHash::Md5);
+  return QString("%1/cameras/%2.krtdcache").arg(base, hash.toHex());
+}
+
 //-----------------------------------------------------------------------------
 QString cameraName(QString const& imagePath, int cameraIndex)
 {
@@ -212,6 +249,214 @@ protected:
   T data;
 };
 
+//-----------------------------------------------------------------------------
+class FeatureObservationIndex
+{
+public:
+  struct Observation
+  {
+    kwiver::vital::track_id_t track;
+    double x, y; // NaN if the track state has no feature
+  };
+
+  typedef std::vector<Observation>::const_iterator Iterator;
+
+  FeatureObservationIndex() : firstFrame(0) {}
+
+  void build(kwiver::vital::feature_track_set const& tracks);
+
+  Iterator begin(kwiver::vital::frame_id_t frame) const;
+  Iterator end(kwiver::vital::frame_id_t frame) const;
+
+protected:
+  bool contains(kwiver::vital::frame_id_t frame) const;
+  size_t offset(kwiver::vital::frame_id_t frame) const;
+
+  kwiver::vital::frame_id_t firstFrame;
+  std::vector<size_t> frameOffsets;
+  std::vector<Observation> observations;
+};
+
+//-----------------------------------------------------------------------------
+void FeatureObservationIndex::build(
+  kwiver::vital::feature_track_set const& tracks)
+{
+  this->frameOffsets.clear();
+  this->observations.clear();
+
+  auto const& allTracks = tracks.tracks();
+
+  // Find the range of frames
+  auto firstFrame = std::numeric_limits<kwiver::vital::frame_id_t>::max();
+  auto lastFrame = std::numeric_limits<kwiver::vital::frame_id_t>::min();
+  for (auto const& track : allTracks)
+  {
+    if (!track->empty())
+    {
+      firstFrame = qMin(firstFrame, track->first_frame());
+      lastFrame = qMax(lastFrame, track->last_frame());
+    }
+  }
+
+  if (firstFrame > lastFrame)
+  {
+    return;
+  }
+
+  this->firstFrame = firstFrame;
+  auto const frameCount = static_cast<size_t>(lastFrame - firstFrame) + 1;
+  this->frameOffsets.assign(frameCount + 1, 0);
+
+  // Count observations per frame, then fill them in frame order
+  for (auto const& track : allTracks)
+  {
+    for (auto const& state : *track)
+    {
+      ++this->frameOffsets[this->offset(state->frame()) + 1];
+    }
+  }
+
+  std::partial_sum(this->frameOffsets.begin(), this->frameOffsets.end(),
+                   this->frameOffsets.begin());
+
+  auto next = std::vector<size_t>(this->frameOffsets.begin(),
+                                  this->frameOffsets.end() - 1);
+  this->observations.resize(this->frameOffsets.back());
+  for (auto const& track : allTracks)
+  {
+    auto const id = track->id();
+    for (auto const& state : *track)
+    {
+      auto const& fts =
+        std::dynamic_pointer_cast<kwiver::vital::feature_track_state>(state);
+      auto const slot = next[this->offset(state->frame())]++;
+      if (fts && fts->feature)
+      {
+        auto const& loc = fts->feature->loc();
+        this->observations[slot] = Observation{id, loc[0], loc[1]};
+      }
+      else
+      {
+        this->observations[slot] = Observation{id, qQNaN(), qQNaN()};
+      }
+    }
+  }
+}
+
+//-----------------------------------------------------------------------------
+bool FeatureObservationIndex::contains(kwiver::vital::frame_id_t frame) const
+{
+  return !this->frameOffsets.empty() && frame >= this->firstFrame &&
+         this->offset(frame) + 1 < this->frameOffsets.size();
+}
+
+//-----------------------------------------------------------------------------
+size_t FeatureObservationIndex::offset(kwiver::vital::frame_id_t frame) const
+{
+  return static_cast<size_t>(frame - this->firstFrame);
+}
+
+//-----------------------------------------------------------------------------
+FeatureObservationIndex::Iterator FeatureObservationIndex::begin(
+  kwiver::vital::frame_id_t frame) const
+{
+  auto const first = (this->contains(frame)
+                      ? this->frameOffsets[this->offset(frame)]
+                      : this->observations.size());
+  return this->observations.begin() + first;
+}
+
+//-----------------------------------------------------------------------------
+FeatureObservationIndex::Iterator FeatureObservationIndex::end(
+  kwiver::vital::frame_id_t frame) const
+{
+  auto const last = (this->contains(frame)
+                     ? this->frameOffsets[this->offset(frame) + 1]
+                     : this->observations.size());
+  return this->observations.begin() + last;
+}
+
+//-----------------------------------------------------------------------------
+struct TrackExtension
+{
+  kwiver::vital::track_sptr track;
+  kwiver::vital::frame_id_t firstFrame; // First frame with new states
+};
+
+//-----------------------------------------------------------------------------
+// Find the tracks in a track set that have been added or extended relative to
+// an earlier version of the same set; returns false if the earlier set cannot
+// be turned into the later one just by adding states (e.g. if tracks were
+// removed). Successive results of a tool share the tracks that did not change,
+// so only an identical track is taken as unchanged.
+bool findTrackExtensions(kwiver::vital::feature_track_set const& before,
+                         kwiver::vital::feature_track_set const& after,
+                         std::vector<TrackExtension>& extensions)
+{
+  auto earlierTracks =
+    std::unordered_map<kwiver::vital::track_id_t,
+                       kwiver::vital::track_sptr>{};
+  for (auto const& track : before.tracks())
+  {
+    earlierTracks.emplace(track->id(), track);
+  }
+
+  auto matched = size_t{0};
+  for (auto const& track : after.tracks())
+  {
+    auto const iter = earlierTracks.find(track->id());
+    if (iter == earlierTracks.end())
+    {
+      if (!track->empty())
+      {
+        extensions.push_back({track, track->first_frame()});
+      }
+      continue;
+    }
+
+    ++matched;
+    auto const& earlier = iter->second;
+    if (earlier == track)
+    {
+      continue;
+    }
+    if (earlier->empty())
+    {
+      if (!track->empty())
+      {
+        extensions.push_back({track, track->first_frame()});
+      }
+      continue;
+    }
+
+    // Otherwise the track must have grown, and the earlier states must be a
+    // prefix of it, with the same first frame and the same frame at the end of
+    // the prefix; if not, the ID has been reused for a different track
+    auto const earlierSize = static_cast<ptrdiff_t>(earlier->size());
+    if (track->size() <= earlier->size() ||
+        track->first_frame() != earlier->first_frame() ||
+        (*(track->begin() + earlierSize - 1))->frame() !=
+          earlier->last_frame())
+    {
+      return false;
+    }
+    extensions.push_back({track, earlier->last_frame() + 1});
+  }
+
+  return matched == earlierTracks.size();
+}
+
+//-----------------------------------------------------------------------------
+bool isSameLandmarks(kwiver::vital::landmark_map const& a,
+                     kwiver::vital::landmark_map const& b)
+{
+  // Compares landmark identity, not value; tool updates share landmarks that
+  // have not changed
+  auto const& al = a.landmarks();
+  auto const& bl = b.landmarks();
+  return al.size() == bl.size() && std::equal(al.begin(), al.end(), bl.begin());
+}
+
 } // namespace <anonymous>
 
 //END miscellaneous helpers
@@ -238,6 +483,8 @@ public:
   MainWindowPrivate()
     : activeTool(0)
     , toolUpdateActiveFrame(-1)
+    , toolTracksShown(false)
+    , toolUpdateInterval(MinimumToolUpdateInterval)
     , activeCameraIndex(-1) {}
 
   void addTool(AbstractTool* tool, MainWindow* mainWindow);
@@ -250,12 +497,17 @@ public:
 
   std::vector<std::string> imagePaths() const;
   kwiver::vital::camera_map_sptr cameraMap() const;
-  void updateCameras(kwiver::vital::camera_map_sptr const&);
+  bool updateCameras(kwiver::vital::camera_map_sptr const&);
+  void updateTracks(kwiver::vital::feature_track_set_sptr const&,
+                    bool incremental);
+  void scheduleToolUpdate();
 
   void setActiveCamera(int);
   void updateCameraView();
+  void updateIndices();
 
   void loadImage(QString const& path, vtkMaptkCamera* camera);
+  void prefetchImages(int step);
 
   void loadDepthMap(QString const& imagePath);
 
@@ -267,6 +519,8 @@ public:
   qtUiState uiState;
 
   StateValue<QColor>* viewBackgroundColor;
+  StateValue<int>* imageCacheSize; // MiB
+  StateValue<int>* imagePrefetchCount;
 
   QTimer slideTimer;
   QSignalMapper toolDispatcher;
@@ -278,13 +532,33 @@ public:
   kwiver::vital::camera_map_sptr toolUpdateCameras;
   kwiver::vital::landmark_map_sptr toolUpdateLandmarks;
   kwiver::vital::feature_track_set_sptr toolUpdateTracks;
+  bool toolTracksShown; // Whether the active tool's tracks have been shown
+
+  // Tool results are shown at most once per interval, which adapts to the
+  // time taken to show them
+  QTimer toolUpdateTimer;
+  QElapsedTimer toolUpdateClock; // Started when results were last shown
+  int toolUpdateInterval; // ms
 
   QList<CameraData> cameras;
   kwiver::vital::feature_track_set_sptr tracks;
   kwiver::vital::landmark_map_sptr landmarks;
 
+  // Spatial index of landmarks and per-frame index of feature observations,
+  // rebuilt on demand when the landmarks or tracks are replaced
+  LandmarkIndex landmarkIndex;
+  kwiver::vital::landmark_map_sptr indexedLandmarks;
+  FeatureObservationIndex observationIndex;
+  kwiver::vital::feature_track_set_sptr indexedTracks;
+
+  // Match matrix of the tracks, updated incrementally as tracks change
+  kwiver::maptk::match_matrix_builder matchMatrix;
+
   int activeCameraIndex;
 
+  ImageCache imageCache;
+  QString pendingImagePath; // Image to show when it has been decoded
+
   QQueue<int> orphanImages;
   QQueue<int> orphanCameras;
 
@@ -433,45 +707,116 @@ kwiver::vital::camera_map_sptr MainWindowPrivate::cameraMap() const
 }
 
 //-----------------------------------------------------------------------------
-void MainWindowPrivate::updateCameras(
+bool MainWindowPrivate::updateCameras(
   kwiver::vital::camera_map_sptr const& cameras)
 {
   auto const cameraCount = this->cameras.count();
   auto allowExport = false;
+  auto activeCameraChanged = false;
 
   foreach (auto const& iter, cameras->cameras())
   {
     auto const index = static_cast<int>(iter.first);
     if (index >= 0 && index < cameraCount && iter.second)
     {
+      allowExport = true;
+
       auto& cd = this->cameras[index];
       if (!cd.camera)
       {
         cd.camera = vtkSmartPointer<vtkMaptkCamera>::New();
         this->UI.worldView->addCamera(cd.id, cd.camera);
       }
+      else if (cd.camera->GetCamera() == iter.second)
+      {
+        // Camera is unchanged
+        continue;
+      }
       cd.camera->SetCamera(iter.second);
       cd.camera->Update();
 
       if (cd.id == this->activeCameraIndex)
       {
         this->UI.worldView->setActiveCamera(cd.id);
-        this->updateCameraView();
+        activeCameraChanged = true;
       }
-
-      allowExport = allowExport || iter.second;
     }
   }
 
   this->UI.actionExportCameras->setEnabled(allowExport);
+  return activeCameraChanged;
+}
+
+//-----------------------------------------------------------------------------
+void MainWindowPrivate::updateTracks(
+  kwiver::vital::feature_track_set_sptr const& tracks, bool incremental)
+{
+  auto const previousTracks = this->tracks;
+  this->tracks = tracks;
+
+  // If the tracks have only been added to, show just the new track states,
+  // rather than rebuilding the feature track display
+  auto extensions = std::vector<TrackExtension>{};
+  if (incremental && previousTracks && tracks &&
+      findTrackExtensions(*previousTracks, *tracks, extensions))
+  {
+    for (auto const& extension : extensions)
+    {
+      this->UI.cameraView->addFeatureTrack(*extension.track,
+                                           extension.firstFrame);
+    }
+  }
+  else if (tracks)
+  {
+    this->UI.cameraView->setFeatureTracks(*tracks);
+  }
+  else
+  {
+    this->UI.cameraView->clearFeatureTracks();
+  }
+
+  auto const haveTracks = tracks && tracks->size();
+  this->UI.actionExportTracks->setEnabled(haveTracks);
+  this->UI.actionShowMatchMatrix->setEnabled(haveTracks);
+
+  // Keep the match matrix current once it has been computed; only the states
+  // of tracks that changed are processed
+  if (tracks && this->matchMatrix.num_tracks())
+  {
+    this->matchMatrix.update(tracks);
+  }
+}
+
+//-----------------------------------------------------------------------------
+void MainWindowPrivate::scheduleToolUpdate()
+{
+  if (this->toolUpdateTimer.isActive())
+  {
+    // An update is already scheduled, and will show the latest results
+    return;
+  }
+
+  // Show the results once the update interval has passed since results were
+  // last shown (or right away, if it already has)
+  auto const elapsed =
+    (this->toolUpdateClock.isValid()
+     ? this->toolUpdateClock.elapsed()
+     : static_cast<qint64>(this->toolUpdateInterval));
+  auto const delay = this->toolUpdateInterval - elapsed;
+  this->toolUpdateTimer.start(static_cast<int>(qMax(delay, qint64{0})));
 }
 
 //-----------------------------------------------------------------------------
 void MainWindowPrivate::setActiveCamera(int id)
 {
+  // The slideshow always moves forward, even when it loops back to the start
+  auto const step =
+    (this->slideTimer.isActive() || id >= this->activeCameraIndex ? +1 : -1);
+
   this->activeCameraIndex = id;
   this->UI.worldView->setActiveCamera(id);
   this->updateCameraView();
+  this->prefetchImages(step);
 
   auto& cd = this->cameras[id];
   if (!cd.depthMapPath.isEmpty())
@@ -496,8 +841,6 @@ void MainWindowPrivate::updateCameraView()
   this->UI.cameraView->setActiveFrame(
     static_cast<unsigned>(this->activeCameraIndex));
 
-  QHash<kwiver::vital::track_id_t, kwiver::vital::vector_2d> landmarkPoints;
-
   auto const& cd = this->cameras[this->activeCameraIndex];
 
   // Show camera image
@@ -512,55 +855,68 @@ void MainWindowPrivate::updateCameraView()
     return;
   }
 
-  // Show landmarks
-  this->UI.cameraView->clearLandmarks();
-  if (this->landmarks)
+  this->updateIndices();
+
+  // Show landmarks that are visible in the image
+  int w, h;
+  cd.camera->GetImageDimensions(w, h);
+
+  auto landmarkIds = std::vector<kwiver::vital::landmark_id_t>{};
+  auto landmarkPoints = std::vector<double>{};
+  this->landmarkIndex.project(*cd.camera->GetCamera(), w, h,
+                              landmarkIds, landmarkPoints);
+  this->UI.cameraView->setLandmarks(landmarkIds, landmarkPoints);
+
+  // Show residuals of the features observed on this frame
+  auto residuals = std::vector<double>{};
+  auto const frame = this->activeCameraIndex;
+  auto const end = this->observationIndex.end(frame);
+  for (auto o = this->observationIndex.begin(frame); o != end; ++o)
   {
-    // Map landmarks to camera space
-    auto const& landmarks = this->landmarks->landmarks();
-    foreach (auto const& lm, landmarks)
+    auto landmark = kwiver::vital::vector_3d{};
+    double pp[2];
+    if (!qIsNaN(o->x) &&
+        this->landmarkIndex.find(o->track, landmark) &&
+        cd.camera->ProjectPoint(landmark, pp))
     {
-      double pp[2];
-      if (cd.camera->ProjectPoint(lm.second->loc(), pp))
-      {
-        // Add projected landmark to camera view
-        auto const id = lm.first;
-        this->UI.cameraView->addLandmark(id, pp[0], pp[1]);
-        landmarkPoints.insert(id, kwiver::vital::vector_2d(pp[0], pp[1]));
-      }
+      residuals.push_back(o->x);
+      residuals.push_back(o->y);
+      residuals.push_back(pp[0]);
+      residuals.push_back(pp[1]);
     }
   }
+  this->UI.cameraView->setResiduals(residuals);
+}
 
-  // Show residuals
-  this->UI.cameraView->clearResiduals();
-  if (this->tracks)
+//-----------------------------------------------------------------------------
+void MainWindowPrivate::updateIndices()
+{
+  if (this->indexedLandmarks != this->landmarks)
   {
-    auto const& tracks = this->tracks->tracks();
-    foreach (auto const& track, tracks)
+    this->indexedLandmarks = this->landmarks;
+    if (this->landmarks)
     {
-      auto const& state = track->find(this->activeCameraIndex);
-      if ( state == track->end() )
-      {
-        continue;
-      }
-      auto fts = std::dynamic_pointer_cast<kwiver::vital::feature_track_state>(*state);
-      if ( fts && fts->feature)
-      {
-        auto const id = track->id();
-        if (landmarkPoints.contains(id))
-        {
-          auto const& fp = fts->feature->loc();
-          auto const& lp = landmarkPoints[id];
-          this->UI.cameraView->addResidual(id, fp[0], fp[1], lp[0], lp[1]);
-        }
-      }
+      this->landmarkIndex.build(*this->landmarks);
+    }
+    else
+    {
+      this->landmarkIndex.clear();
     }
   }
+
+  if (this->indexedTracks != this->tracks)
+  {
+    this->indexedTracks = this->tracks;
+    this->observationIndex.build(
+      this->tracks ? *this->tracks : kwiver::vital::feature_track_set{});
+  }
 }
 
 //-----------------------------------------------------------------------------
 void MainWindowPrivate::loadImage(QString const& path, vtkMaptkCamera* camera)
 {
+  this->pendingImagePath.clear();
+
   if (path.isEmpty())
   {
     auto imageDimensions = QSize(1, 1);
@@ -576,50 +932,72 @@ void MainWindowPrivate::loadImage(QString const& path, vtkMaptkCamera* camera)
   }
   else
   {
-    // Create a reader capable of reading the image file
-    auto const reader =
-      vtkImageReader2Factory::CreateImageReader2(qPrintable(path));
-    if (!reader)
+    // Get the decoded image; if it is not ready yet, keep showing the current
+    // image until the cache reports that the new one has arrived
+    auto data = vtkSmartPointer<vtkImageData>{};
+    if (!this->imageCache.image(path, data))
     {
-      qWarning() << "Failed to create image reader for image" << path;
-      this->loadImage(QString(), camera);
+      this->pendingImagePath = path;
       return;
     }
 
-    // Load the image
-    reader->SetFileName(qPrintable(path));
-    reader->Update();
+    if (!data)
+    {
+      // Image could not be read; the cache has already issued a warning
+      this->loadImage(QString(), camera);
+      return;
+    }
 
     // Get dimensions
-    auto const data = reader->GetOutput();
     int dimensions[3];
     data->GetDimensions(dimensions);
 
-    // Test for errors
-    if (dimensions[0] < 2 || dimensions[1] < 2)
+    // Update camera image dimensions
+    if (camera)
     {
-      qWarning() << "Failed to read image" << path;
-      this->loadImage(QString(), camera);
+      camera->SetImageDimensions(dimensions);
     }
-    else
-    {
-      // If successful, update camera image dimensions
-      if (camera)
-      {
-        camera->SetImageDimensions(dimensions);
-      }
 
-      // Set image on views
-      auto const size = QSize(dimensions[0], dimensions[1]);
-      this->UI.cameraView->setImageData(data, size);
-      this->UI.worldView->setImageData(data, size);
+    // Set image on views
+    auto const size = QSize(dimensions[0], dimensions[1]);
+    this->UI.cameraView->setImageData(data, size);
+    this->UI.worldView->setImageData(data, size);
+  }
+}
+
+//-----------------------------------------------------------------------------
+void MainWindowPrivate::prefetchImages(int step)
+{
+  auto const count = this->cameras.count();
+  auto const n = qMin(static_cast<int>(*this->imagePrefetchCount), count - 1);
+  auto const playing = this->slideTimer.isActive();
+  auto const wrap = playing && this->UI.actionSlideshowLoop->isChecked();
+
+  auto paths = QStringList{};
+  auto addPath = [&](int index){
+    if (wrap)
+    {
+      index = (index + count) % count;
     }
+    if (index >= 0 && index < count)
+    {
+      paths.append(this->cameras[index].imagePath);
+    }
+  };
 
-    // Delete the reader
-    reader->Delete();
+  // Fetch frames in the direction of travel first; while the slideshow is
+  // playing, frames behind have just been shown and need not be fetched
+  for (auto i = 1; i <= n; ++i)
+  {
+    addPath(this->activeCameraIndex + (i * step));
+    if (!playing)
+    {
+      addPath(this->activeCameraIndex - (i * step));
+    }
   }
-}
 
+  this->imageCache.prefetch(paths);
+}
 
 //-----------------------------------------------------------------------------
 void MainWindowPrivate::loadDepthMap(QString const& imagePath)
@@ -747,6 +1125,10 @@ MainWindow::MainWindow(QWidget* parent, Qt::WindowFlags flags)
           this, SLOT(showUserManual()));
 
   connect(&d->slideTimer, SIGNAL(timeout()), this, SLOT(nextSlide()));
+
+  d->toolUpdateTimer.setSingleShot(true);
+  connect(&d->toolUpdateTimer, SIGNAL(timeout()),
+          this, SLOT(updateToolResults()));
   connect(d->UI.actionSlideshowPlay, SIGNAL(toggled(bool)),
           this, SLOT(setSlideshowPlaying(bool)));
   connect(d->UI.slideDelay, SIGNAL(valueChanged(int)),
@@ -755,6 +1137,9 @@ MainWindow::MainWindow(QWidget* parent, Qt::WindowFlags flags)
   connect(d->UI.camera, SIGNAL(valueChanged(int)),
           this, SLOT(setActiveCamera(int)));
 
+  connect(&d->imageCache, SIGNAL(imageReady(QString)),
+          this, SLOT(acceptImage(QString)));
+
   connect(d->UI.worldView, SIGNAL(meshEnabled(bool)),
           this, SLOT(enableSaveMesh(bool)));
 
@@ -783,6 +1168,11 @@ MainWindow::MainWindow(QWidget* parent, Qt::WindowFlags flags)
   d->viewBackgroundColor = new StateValue<QColor>{Qt::black},
   d->uiState.map("ViewBackground", d->viewBackgroundColor);
 
+  d->imageCacheSize = new StateValue<int>{1024},
+  d->uiState.map("ImageCache/Size", d->imageCacheSize);
+  d->imagePrefetchCount = new StateValue<int>{8},
+  d->uiState.map("ImageCache/Prefetch", d->imagePrefetchCount);
+
   d->uiState.mapChecked("WorldView/Axes", d->UI.actionShowWorldAxes);
 
   d->uiState.mapState("Window/state", this);
@@ -793,6 +1183,8 @@ MainWindow::MainWindow(QWidget* parent, Qt::WindowFlags flags)
   d->UI.cameraView->setBackgroundColor(*d->viewBackgroundColor);
   d->UI.depthMapView->setBackgroundColor(*d->viewBackgroundColor);
 
+  d->imageCache.setMemoryBudget(static_cast<qint64>(*d->imageCacheSize) << 20);
+
   // Hookup basic depth pipeline and pass geometry filter to relevant views
   d->depthFilter->SetInputConnection(d->depthReader->GetOutputPort());
   d->depthGeometryFilter->SetInputConnection(d->depthFilter->GetOutputPort());
@@ -817,9 +1209,9 @@ void MainWindow::openFile()
 
   auto const paths = QFileDialog::getOpenFileNames(
     this, "Open File", QString(),
-    "All Supported Files (*.conf *.txt *.ply *.krtd " + imageFilters + ");;"
+    "All Supported Files (*.conf *.txt *.kwbt *.ply *.krtd " + imageFilters + ");;"
     "Project configuration file (*.conf);;"
-    "Track file (*.txt);;"
+    "Track file (*.txt *.kwbt);;"
     "Landmark file (*.ply);;"
     "Camera file (*.krtd);;"
     "All Files (*)");
@@ -840,7 +1232,8 @@ void MainWindow::openFile(QString const& path)
   {
     this->loadProject(path);
   }
-  else if (fi.suffix().toLower() == "txt")
+  else if (fi.suffix().toLower() == "txt" ||
+           fi.suffix().toLower() == "kwbt")
   {
     this->loadTracks(path);
   }
@@ -904,25 +1297,62 @@ void MainWindow::loadProject(QString const& path)
       d->addImage(ip);
     }
   }
-  else
+  else if (QFileInfo(project.cameraPath).isFile() &&
+           kwiver::maptk::is_camera_archive(kvPath(project.cameraPath)))
   {
-    auto const cameraDir = kwiver::vital::path_t(kvPath(project.cameraPath));
+    // Load all cameras from a packed camera archive, matched by image name
+    std::map<std::string, kwiver::vital::camera_sptr> archive;
+    try
+    {
+      archive = kwiver::maptk::read_camera_archive(kvPath(project.cameraPath));
+    }
+    catch (...)
+    {
+      qWarning() << "failed to read camera archive" << project.cameraPath;
+    }
     foreach (auto const& ip, project.images)
     {
-      try
+      auto const iter =
+        archive.find(stdString(QFileInfo(ip).completeBaseName()));
+      if (iter == archive.end())
       {
-        auto const& camera =
-          kwiver::vital::read_krtd_file(kvPath(ip), cameraDir);
-
-        // Add camera to scene
-        d->addFrame(camera, ip);
+        qWarning() << "failed to read camera for" << ip
+                   << "from" << project.cameraPath;
+        d->addFrame(kwiver::vital::camera_sptr(), ip);
+      }
+      else
+      {
+        d->addFrame(iter->second, ip);
       }
-      catch (...)
+    }
+  }
+  else
+  {
+    // Load the cameras for all images at once, in parallel
+    std::vector<std::string> names;
+    foreach (auto const& ip, project.images)
+    {
+      names.push_back(stdString(QFileInfo(ip).completeBaseName()));
+    }
+    auto const& cameras = kwiver::maptk::read_krtd_directory(
+      kvPath(project.cameraPath), names,
+      kvPath(krtdCacheFile(project.cameraPath)));
+
+    foreach (auto const i, qtIndexRange(project.images.count()))
+    {
+      auto const& ip = project.images[i];
+      auto const iter = cameras.find(names[i]);
+      if (iter == cameras.end())
       {
         qWarning() << "failed to read camera for" << ip
                    << "from" << project.cameraPath;
         d->addFrame(kwiver::vital::camera_sptr(), ip);
       }
+      else
+      {
+        // Add camera to scene
+        d->addFrame(iter->second, ip);
+      }
     }
   }
 
@@ -986,16 +1416,13 @@ void MainWindow::loadTracks(QString const& path)
 
   try
   {
-    auto const& tracks = kwiver::vital::read_feature_track_file(kvPath(path));
+    auto const& tracks = kwiver::maptk::read_feature_track_file(kvPath(path));
     if (tracks)
     {
       d->tracks = tracks;
       d->updateCameraView();
 
-      foreach (auto const& track, tracks->tracks())
-      {
-        d->UI.cameraView->addFeatureTrack(*track);
-      }
+      d->UI.cameraView->setFeatureTracks(*tracks);
 
       d->UI.actionExportTracks->setEnabled(
           d->tracks && d->tracks->size());
@@ -1073,6 +1500,7 @@ void MainWindow::saveTracks()
   auto const path = QFileDialog::getSaveFileName(
     this, "Export Tracks", QString(),
     "Track file (*.txt);;"
+    "Binary track file (*.kwbt);;"
     "All Files (*)");
 
   if (!path.isEmpty())
@@ -1088,7 +1516,7 @@ void MainWindow::saveTracks(QString const& path)
 
   try
   {
-    kwiver::vital::write_feature_track_file(d->tracks, kvPath(path));
+    kwiver::maptk::write_feature_track_file(d->tracks, kvPath(path));
   }
   catch (...)
   {
@@ -1361,6 +1789,12 @@ void MainWindow::nextSlide()
 {
   QTE_D();
 
+  // Hold the current frame until its image has been shown
+  if (!d->pendingImagePath.isEmpty())
+  {
+    return;
+  }
+
   if (d->UI.camera->value() == d->UI.camera->maximum())
   {
     if (d->UI.actionSlideshowLoop->isChecked())
@@ -1393,6 +1827,19 @@ void MainWindow::setActiveCamera(int id)
   d->setActiveCamera(id);
 }
 
+//-----------------------------------------------------------------------------
+void MainWindow::acceptImage(QString const& path)
+{
+  QTE_D();
+
+  if (d->activeCameraIndex >= 0 && path == d->pendingImagePath &&
+      !path.isEmpty())
+  {
+    // Update the whole view, as landmark culling depends on the image size
+    d->updateCameraView();
+  }
+}
+
 //-----------------------------------------------------------------------------
 void MainWindow::executeTool(QObject* object)
 {
@@ -1402,6 +1849,7 @@ void MainWindow::executeTool(QObject* object)
   if (tool && !d->activeTool)
   {
     d->setActiveTool(tool);
+    d->toolTracksShown = false;
     tool->setActiveFrame(d->activeCameraIndex);
     tool->setImagePaths(d->imagePaths());
     tool->setTracks(d->tracks);
@@ -1422,6 +1870,11 @@ void MainWindow::acceptToolFinalResults()
   if (d->activeTool)
   {
     acceptToolResults(d->activeTool->data());
+
+    // Show the final results right away, so that they are current before
+    // another tool can be run
+    d->toolUpdateTimer.stop();
+    this->updateToolResults();
   }
   d->setActiveTool(0);
 }
@@ -1430,43 +1883,39 @@ void MainWindow::acceptToolFinalResults()
 void MainWindow::acceptToolResults(std::shared_ptr<ToolData> data)
 {
   QTE_D();
-  // if all the update variables are Null then trigger a GUI update after
-  // extracting the data otherwise we've already triggered an update that
-  // hasn't happened yet, so don't trigger another
-  bool updateNeeded = !d->toolUpdateCameras &&
-                      !d->toolUpdateLandmarks &&
-                      !d->toolUpdateTracks &&
-                      d->toolUpdateActiveFrame < 0;
 
+  // Results are coalesced; each category keeps only the latest results that
+  // differ from what is shown, and an update is scheduled to show them
   if (d->activeTool)
   {
     auto const outputs = d->activeTool->outputs();
 
-    d->toolUpdateCameras = NULL;
-    d->toolUpdateLandmarks = NULL;
-    d->toolUpdateTracks = NULL;
-    d->toolUpdateActiveFrame = -1;
     if (outputs.testFlag(AbstractTool::Cameras))
     {
       d->toolUpdateCameras = data->cameras;
     }
     if (outputs.testFlag(AbstractTool::Landmarks))
     {
-      d->toolUpdateLandmarks = data->landmarks;
+      d->toolUpdateLandmarks =
+        (data->landmarks != d->landmarks ? data->landmarks : NULL);
     }
     if (outputs.testFlag(AbstractTool::Tracks))
     {
-      d->toolUpdateTracks = data->tracks;
+      d->toolUpdateTracks =
+        (data->tracks != d->tracks ? data->tracks : NULL);
     }
     if (outputs.testFlag(AbstractTool::ActiveFrame))
     {
-      d->toolUpdateActiveFrame = static_cast<int>(data->activeFrame);
+      auto const frame = static_cast<int>(data->activeFrame);
+      d->toolUpdateActiveFrame =
+        (frame != d->activeCameraIndex ? frame : -1);
     }
   }
 
-  if(updateNeeded)
+  if (d->toolUpdateCameras || d->toolUpdateLandmarks ||
+      d->toolUpdateTracks || d->toolUpdateActiveFrame >= 0)
   {
-    QTimer::singleShot(1000, this, SLOT(updateToolResults()));
+    d->scheduleToolUpdate();
   }
 }
 
@@ -1475,47 +1924,60 @@ void MainWindow::updateToolResults()
 {
   QTE_D();
 
+  QElapsedTimer timer;
+  timer.start();
+
+  // Apply only what has changed, and refresh the camera view at most once
+  auto cameraViewChanged = false;
+
   if (d->toolUpdateCameras)
   {
-    d->updateCameras(d->toolUpdateCameras);
+    cameraViewChanged = d->updateCameras(d->toolUpdateCameras);
     d->toolUpdateCameras = NULL;
   }
   if (d->toolUpdateLandmarks)
   {
-    d->landmarks = d->toolUpdateLandmarks;
-    d->UI.worldView->setLandmarks(*d->landmarks);
+    if (!d->landmarks ||
+        !isSameLandmarks(*d->landmarks, *d->toolUpdateLandmarks))
+    {
+      d->landmarks = d->toolUpdateLandmarks;
+      d->UI.worldView->setLandmarks(*d->landmarks);
+      d->UI.cameraView->setLandmarksData(*d->landmarks);
 
-    d->UI.actionExportLandmarks->setEnabled(
-      d->landmarks && d->landmarks->size());
+      d->UI.actionExportLandmarks->setEnabled(
+        d->landmarks && d->landmarks->size());
+      cameraViewChanged = true;
+    }
     d->toolUpdateLandmarks = NULL;
   }
   if (d->toolUpdateTracks)
   {
-    d->tracks = d->toolUpdateTracks;
-    d->UI.cameraView->clearFeatureTracks();
-    d->updateCameraView();
-
-    foreach (auto const& track, d->tracks->tracks())
-    {
-      d->UI.cameraView->addFeatureTrack(*track);
-    }
-    d->UI.actionExportTracks->setEnabled(
-        d->tracks && d->tracks->size());
-
-    d->UI.actionShowMatchMatrix->setEnabled(!d->tracks->tracks().empty());
+    // The first results of a tool run do not share tracks with what is shown,
+    // so tracks with the same ID cannot be assumed to be the same track
+    d->updateTracks(d->toolUpdateTracks, d->toolTracksShown);
     d->toolUpdateTracks = NULL;
+    d->toolTracksShown = true;
+    cameraViewChanged = true;
   }
+
   if (d->toolUpdateActiveFrame >= 0)
   {
     d->UI.camera->setValue(d->toolUpdateActiveFrame);
     this->setActiveCamera(d->toolUpdateActiveFrame);
     d->toolUpdateActiveFrame = -1;
   }
-
-  if (!d->cameras.isEmpty())
+  else if (cameraViewChanged && d->activeCameraIndex >= 0)
   {
-    d->setActiveCamera(d->activeCameraIndex);
+    d->updateCameraView();
   }
+
+  // Keep the time spent showing results to a fraction of the time between
+  // updates, so that the application stays responsive while the views follow
+  // the tool as closely as they can
+  auto const cost = static_cast<int>(timer.elapsed());
+  d->toolUpdateInterval =
+    qBound(MinimumToolUpdateInterval, 4 * cost, MaximumToolUpdateInterval);
+  d->toolUpdateClock.start();
 }
 
 //-----------------------------------------------------------------------------
@@ -1527,7 +1989,8 @@ void MainWindow::showMatchMatrix()
   {
     // Get matrix
     auto frames = std::vector<kwiver::vital::frame_id_t>();
-    auto const mm = kwiver::arrows::match_matrix(d->tracks, frames);
+    d->matchMatrix.update(d->tracks);
+    auto const mm = d->matchMatrix.matrix(frames);
 
     // Show window
     auto window = new MatchMatrixWindow();
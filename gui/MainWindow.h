@@ -93,6 +93,8 @@ protected slots:
   void setSlideshowPlaying(bool);
   void nextSlide();
 
+  void acceptImage(QString const& path);
+
   void executeTool(QObject*);
   void acceptToolFinalResults();
   void acceptToolResults(std::shared_ptr<ToolData> data);
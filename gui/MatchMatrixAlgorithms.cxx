@@ -30,11 +30,85 @@
 
 #include "MatchMatrixAlgorithms.h"
 
+#include <qtGradient.h>
+
+#include <algorithm>
 #include <cmath>
+#include <cstring>
 
 using std::log;
 using std::pow;
 
+namespace // anonymous
+{
+
+//BEGIN batch math helpers
+
+// The batch kernels below are written as straight-line loops over flat
+// arrays, without calls into libm, so that the compiler can vectorize them.
+// The approximations are accurate to well within the resolution of the
+// gradient lookup table.
+
+//-----------------------------------------------------------------------------
+inline float fastLog2(float x)
+{
+  // Split x into exponent and mantissa in [1, 2)
+  qint32 bits;
+  std::memcpy(&bits, &x, sizeof(bits));
+  auto const e = static_cast<float>(((bits >> 23) & 0xff) - 127);
+  bits = (bits & 0x007fffff) | 0x3f800000;
+
+  float m;
+  std::memcpy(&m, &bits, sizeof(m));
+
+  // Approximate log2(1 + t) for t in [0, 1) (max error ~1.5e-5)
+  auto const t = m - 1.0f;
+  auto const p =
+    1.44196592f + t * (-0.70967124f + t * (0.41763606f +
+    t * (-0.19633388f + t * 0.04641800f)));
+  return e + (t * p);
+}
+
+//-----------------------------------------------------------------------------
+inline float fastExp2(float x)
+{
+  // Split x into integer and fractional parts; the exponent is clamped in
+  // the integer domain (2^-127 flushes to zero), which unlike a floating
+  // point comparison does not prevent vectorization
+  auto i = static_cast<qint32>(x);
+  i -= static_cast<qint32>(x < static_cast<float>(i));
+  auto const f = x - static_cast<float>(i);
+  i = (i < -127 ? -127 : (i > 127 ? 127 : i));
+
+  // Approximate 2^f for f in [0, 1) (max error ~1.2e-7)
+  auto const p =
+    0.69315246f + f * (0.24015299f + f * (0.05583524f +
+    f * (0.00897433f + f * 0.00188486f)));
+
+  qint32 bits = (i + 127) << 23;
+  float s;
+  std::memcpy(&s, &bits, sizeof(s));
+  return s * (1.0f + (f * p));
+}
+
+//-----------------------------------------------------------------------------
+inline float selectPositive(float x, float value)
+{
+  // Return value if x > 0, otherwise 0, without branching
+  qint32 xb, vb;
+  std::memcpy(&xb, &x, sizeof(xb));
+  std::memcpy(&vb, &value, sizeof(vb));
+  vb &= -static_cast<qint32>(xb > 0);
+  std::memcpy(&value, &vb, sizeof(value));
+  return value;
+}
+
+//END batch math helpers
+
+} // namespace <anonymous>
+
+///////////////////////////////////////////////////////////////////////////////
+
 //BEGIN value algorithms
 
 //-----------------------------------------------------------------------------
@@ -44,6 +118,17 @@ double AbsoluteValueAlgorithm::operator()(
   return iter.value();
 }
 
+//-----------------------------------------------------------------------------
+void AbsoluteValueAlgorithm::operator()(
+  Matrix const& /*unused*/, Triplet const* entries,
+  size_t count, float* out) const
+{
+  for (size_t i = 0; i < count; ++i)
+  {
+    out[i] = static_cast<float>(entries[i].value());
+  }
+}
+
 //-----------------------------------------------------------------------------
 double AbsoluteValueAlgorithm::max(double maxRawValue) const
 {
@@ -56,6 +141,21 @@ double AbstractRelativeValueAlgorithm::max(double /*maxRawValue*/) const
   return 1.0;
 }
 
+//-----------------------------------------------------------------------------
+std::vector<float> AbstractRelativeValueAlgorithm::diagonal(
+  Matrix const& matrix)
+{
+  auto const k = std::min(matrix.rows(), matrix.cols());
+
+  std::vector<float> result(static_cast<size_t>(k));
+  for (auto i = decltype(k){0}; i < k; ++i)
+  {
+    result[i] = static_cast<float>(matrix.coeff(i, i));
+  }
+
+  return result;
+}
+
 //-----------------------------------------------------------------------------
 double RelativeXValueAlgorithm::operator()(
   Matrix const& matrix, MatrixIterator const& iter) const
@@ -66,6 +166,19 @@ double RelativeXValueAlgorithm::operator()(
   return n / d;
 }
 
+//-----------------------------------------------------------------------------
+void RelativeXValueAlgorithm::operator()(
+  Matrix const& matrix, Triplet const* entries,
+  size_t count, float* out) const
+{
+  auto const d = diagonal(matrix);
+  for (size_t i = 0; i < count; ++i)
+  {
+    auto const& e = entries[i];
+    out[i] = static_cast<float>(e.value()) / d[e.row()];
+  }
+}
+
 //-----------------------------------------------------------------------------
 double RelativeYValueAlgorithm::operator()(
   Matrix const& matrix, MatrixIterator const& iter) const
@@ -76,6 +189,19 @@ double RelativeYValueAlgorithm::operator()(
   return n / d;
 }
 
+//-----------------------------------------------------------------------------
+void RelativeYValueAlgorithm::operator()(
+  Matrix const& matrix, Triplet const* entries,
+  size_t count, float* out) const
+{
+  auto const d = diagonal(matrix);
+  for (size_t i = 0; i < count; ++i)
+  {
+    auto const& e = entries[i];
+    out[i] = static_cast<float>(e.value()) / d[e.col()];
+  }
+}
+
 //-----------------------------------------------------------------------------
 double RelativeXYValueAlgorithm::operator()(
   Matrix const& matrix, MatrixIterator const& iter) const
@@ -88,6 +214,20 @@ double RelativeXYValueAlgorithm::operator()(
   return nc / (ni + nj - nc);
 }
 
+//-----------------------------------------------------------------------------
+void RelativeXYValueAlgorithm::operator()(
+  Matrix const& matrix, Triplet const* entries,
+  size_t count, float* out) const
+{
+  auto const d = diagonal(matrix);
+  for (size_t i = 0; i < count; ++i)
+  {
+    auto const& e = entries[i];
+    auto const nc = static_cast<float>(e.value());
+    out[i] = nc / (d[e.row()] + d[e.col()] - nc);
+  }
+}
+
 //END value algorithms
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -106,6 +246,17 @@ double LinearScaleAlgorithm::operator()(double rawValue) const
   return rawValue * this->scale;
 }
 
+//-----------------------------------------------------------------------------
+void LinearScaleAlgorithm::operator()(
+  float const* in, float* out, size_t count) const
+{
+  auto const scale = static_cast<float>(this->scale);
+  for (size_t i = 0; i < count; ++i)
+  {
+    out[i] = in[i] * scale;
+  }
+}
+
 //-----------------------------------------------------------------------------
 LogarithmicScaleAlgorithm::LogarithmicScaleAlgorithm(
   double maxRawValue, double rangeScale)
@@ -120,6 +271,19 @@ double LogarithmicScaleAlgorithm::operator()(double rawValue) const
   return log((rawValue * this->preScale) + 1.0) * this->postScale;
 }
 
+//-----------------------------------------------------------------------------
+void LogarithmicScaleAlgorithm::operator()(
+  float const* in, float* out, size_t count) const
+{
+  // log(x) == log2(x) * log(2)
+  auto const preScale = static_cast<float>(this->preScale);
+  auto const postScale = static_cast<float>(this->postScale * log(2.0));
+  for (size_t i = 0; i < count; ++i)
+  {
+    out[i] = fastLog2((in[i] * preScale) + 1.0f) * postScale;
+  }
+}
+
 //-----------------------------------------------------------------------------
 ExponentialScaleAlgorithm::ExponentialScaleAlgorithm(
   double maxRawValue, double exponent)
@@ -133,4 +297,57 @@ double ExponentialScaleAlgorithm::operator()(double rawValue) const
   return pow(rawValue * this->scale, this->exponent);
 }
 
+//-----------------------------------------------------------------------------
+void ExponentialScaleAlgorithm::operator()(
+  float const* in, float* out, size_t count) const
+{
+  // pow(x, e) == exp2(e * log2(x)) for x > 0
+  auto const scale = static_cast<float>(this->scale);
+  auto const exponent = static_cast<float>(this->exponent);
+  for (size_t i = 0; i < count; ++i)
+  {
+    auto const x = in[i] * scale;
+    out[i] = selectPositive(x, fastExp2(exponent * fastLog2(x)));
+  }
+}
+
 //END scale algorithms
+
+///////////////////////////////////////////////////////////////////////////////
+
+//BEGIN color mapping
+
+//-----------------------------------------------------------------------------
+GradientLookupTable::GradientLookupTable(qtGradient const& gradient, int size)
+  : table(static_cast<size_t>(qMax(size, 2))),
+    scale(static_cast<float>(qMax(size, 2) - 1))
+{
+  auto const n = this->table.size();
+  for (size_t i = 0; i < n; ++i)
+  {
+    auto const a = static_cast<double>(i) / static_cast<double>(n - 1);
+    this->table[i] = gradient.at(a).rgba();
+  }
+}
+
+//-----------------------------------------------------------------------------
+QRgb GradientLookupTable::operator()(float value) const
+{
+  // Written so that NaN maps to the start of the gradient
+  auto const a = std::min(1.0f, std::max(0.0f, value));
+  return this->table[static_cast<size_t>((a * this->scale) + 0.5f)];
+}
+
+//-----------------------------------------------------------------------------
+void GradientLookupTable::operator()(
+  float const* values, QRgb* out, size_t count) const
+{
+  auto const* const table = this->table.data();
+  for (size_t i = 0; i < count; ++i)
+  {
+    auto const a = std::min(1.0f, std::max(0.0f, values[i]));
+    out[i] = table[static_cast<size_t>((a * this->scale) + 0.5f)];
+  }
+}
+
+//END color mapping
@@ -34,8 +34,14 @@
 #include <qtGlobal.h>
 #include <vital/vital_config.h>
 
+#include <QtGui/QColor>
+
 #include <Eigen/SparseCore>
 
+#include <vector>
+
+class qtGradient;
+
 //BEGIN value algorithms
 
 //-----------------------------------------------------------------------------
@@ -44,11 +50,16 @@ class AbstractValueAlgorithm
 public:
   typedef Eigen::SparseMatrix<uint> Matrix;
   typedef Matrix::InnerIterator MatrixIterator;
+  typedef Eigen::Triplet<uint> Triplet;
 
   virtual ~AbstractValueAlgorithm() VITAL_DEFAULT_DTOR;
 
   virtual double operator()(Matrix const&, MatrixIterator const&) const = 0;
   virtual double max(double maxRawValue) const = 0;
+
+  // Compute values of a batch of entries of the matrix
+  virtual void operator()(Matrix const&, Triplet const* entries,
+                          size_t count, float* out) const = 0;
 };
 
 //-----------------------------------------------------------------------------
@@ -56,6 +67,8 @@ class AbsoluteValueAlgorithm : public AbstractValueAlgorithm
 {
   virtual double operator()(Matrix const&,
                             MatrixIterator const&) const QTE_OVERRIDE;
+  virtual void operator()(Matrix const&, Triplet const* entries,
+                          size_t count, float* out) const QTE_OVERRIDE;
   virtual double max(double maxRawValue) const QTE_OVERRIDE;
 };
 
@@ -63,6 +76,9 @@ class AbsoluteValueAlgorithm : public AbstractValueAlgorithm
 class AbstractRelativeValueAlgorithm : public AbstractValueAlgorithm
 {
   virtual double max(double maxRawValue) const QTE_OVERRIDE;
+
+protected:
+  static std::vector<float> diagonal(Matrix const&);
 };
 
 //-----------------------------------------------------------------------------
@@ -70,6 +86,8 @@ class RelativeXValueAlgorithm : public AbstractRelativeValueAlgorithm
 {
   virtual double operator()(Matrix const&,
                             MatrixIterator const&) const QTE_OVERRIDE;
+  virtual void operator()(Matrix const&, Triplet const* entries,
+                          size_t count, float* out) const QTE_OVERRIDE;
 };
 
 //-----------------------------------------------------------------------------
@@ -77,6 +95,8 @@ class RelativeYValueAlgorithm : public AbstractRelativeValueAlgorithm
 {
   virtual double operator()(Matrix const&,
                             MatrixIterator const&) const QTE_OVERRIDE;
+  virtual void operator()(Matrix const&, Triplet const* entries,
+                          size_t count, float* out) const QTE_OVERRIDE;
 };
 
 //-----------------------------------------------------------------------------
@@ -84,6 +104,8 @@ class RelativeXYValueAlgorithm : public AbstractRelativeValueAlgorithm
 {
   virtual double operator()(Matrix const&,
                             MatrixIterator const&) const QTE_OVERRIDE;
+  virtual void operator()(Matrix const&, Triplet const* entries,
+                          size_t count, float* out) const QTE_OVERRIDE;
 };
 
 //END value algorithms
@@ -99,6 +121,10 @@ public:
   virtual ~AbstractScaleAlgorithm() VITAL_DEFAULT_DTOR
 
   virtual double operator()(double rawValue) const = 0;
+
+  // Scale a batch of values; in and out may be the same array
+  virtual void operator()(float const* in, float* out,
+                          size_t count) const = 0;
 };
 
 //-----------------------------------------------------------------------------
@@ -108,6 +134,8 @@ public:
   LinearScaleAlgorithm(double maxRawValue);
 
   virtual double operator()(double rawValue) const QTE_OVERRIDE;
+  virtual void operator()(float const* in, float* out,
+                          size_t count) const QTE_OVERRIDE;
 
 protected:
   double const scale;
@@ -120,6 +148,8 @@ public:
   LogarithmicScaleAlgorithm(double maxRawValue, double rangeScale = 1.0);
 
   virtual double operator()(double rawValue) const QTE_OVERRIDE;
+  virtual void operator()(float const* in, float* out,
+                          size_t count) const QTE_OVERRIDE;
 
 protected:
   double const preScale;
@@ -133,6 +163,8 @@ public:
   ExponentialScaleAlgorithm(double maxRawValue, double exponent);
 
   virtual double operator()(double rawValue) const QTE_OVERRIDE;
+  virtual void operator()(float const* in, float* out,
+                          size_t count) const QTE_OVERRIDE;
 
 protected:
   double const scale;
@@ -141,4 +173,24 @@ protected:
 
 //END scale algorithms
 
+///////////////////////////////////////////////////////////////////////////////
+
+//BEGIN color mapping
+
+//-----------------------------------------------------------------------------
+class GradientLookupTable
+{
+public:
+  explicit GradientLookupTable(qtGradient const& gradient, int size = 4096);
+
+  QRgb operator()(float value) const;
+  void operator()(float const* values, QRgb* out, size_t count) const;
+
+protected:
+  std::vector<QRgb> table;
+  float const scale;
+};
+
+//END color mapping
+
 #endif
@@ -44,10 +44,16 @@
 
 #include <QtGui/QFileDialog>
 #include <QtGui/QGraphicsSceneHoverEvent>
-#include <QtGui/QGraphicsPixmapItem>
+#include <QtGui/QGraphicsItem>
 #include <QtGui/QImageWriter>
 #include <QtGui/QMessageBox>
+#include <QtGui/QPainter>
+#include <QtGui/QStyleOptionGraphicsItem>
 
+#include <QtCore/QCache>
+#include <QtCore/QHash>
+
+#include <algorithm>
 #include <cmath>
 
 using std::floor;
@@ -75,6 +81,13 @@ enum Orientation
   Graph,
 };
 
+//-----------------------------------------------------------------------------
+enum Pooling
+{
+  MaximumPooling,
+  SumPooling,
+};
+
 //-----------------------------------------------------------------------------
 enum valueAlgorithm
 {
@@ -96,6 +109,45 @@ enum ScaleAlgorithm
 
 ///////////////////////////////////////////////////////////////////////////////
 
+//BEGIN tiling
+
+// Edge length, in pixels, of a rendered tile at any pyramid level
+int const TileSize = 256;
+int const TileShift = 8;
+
+// Maximum number of rendered tiles kept in memory (256 KiB each)
+int const TileCacheSize = 256;
+
+double const ZoomStep = 1.25;
+
+//-----------------------------------------------------------------------------
+struct MatrixEntry
+{
+  int x;
+  int y;
+  int index;
+};
+
+//-----------------------------------------------------------------------------
+quint64 tileKey(int level, int tx, int ty)
+{
+  return (static_cast<quint64>(level) << 48) |
+         (static_cast<quint64>(ty) << 24) |
+         static_cast<quint64>(tx);
+}
+
+//-----------------------------------------------------------------------------
+bool operator<(MatrixEntry const& a, MatrixEntry const& b)
+{
+  auto const ta = tileKey(0, a.x >> TileShift, a.y >> TileShift);
+  auto const tb = tileKey(0, b.x >> TileShift, b.y >> TileShift);
+  return ta < tb;
+}
+
+//END tiling
+
+///////////////////////////////////////////////////////////////////////////////
+
 //BEGIN miscellaneous helpers
 
 //-----------------------------------------------------------------------------
@@ -147,33 +199,49 @@ QString supportedImageFilter()
 class MatchMatrixWindowPrivate
 {
 public:
+  MatchMatrixWindowPrivate() : maxValue(0), offset(0), zoom(1.0)
+  { this->tiles.setMaxCost(TileCacheSize); }
+
   void persist(QString const& key, QComboBox* widget);
   void persist(QString const& key, qtDoubleSlider* widget);
 
-  void buildHorizontalImage(
-    qtGradient const& gradient,
-    AbstractValueAlgorithm const& valueAlgorithm,
-    AbstractScaleAlgorithm const& scaleAlgorithm);
-  void buildVerticalImage(
-    qtGradient const& gradient,
-    AbstractValueAlgorithm const& valueAlgorithm,
-    AbstractScaleAlgorithm const& scaleAlgorithm);
-  void buildDiagonalImage(
-    qtGradient const& gradient,
+  void buildLayout();
+  void computeIntensities(
     AbstractValueAlgorithm const& valueAlgorithm,
     AbstractScaleAlgorithm const& scaleAlgorithm);
 
+  int maxLevel() const;
+  float sumPoolingScale(int level);
+
+  QImage const& tile(int level, int tx, int ty);
+  QImage renderTile(int level, int tx, int ty);
+  QImage renderImage();
+
   Ui::MatchMatrixWindow UI;
   Am::MatchMatrixWindow AM;
   qtUiState uiState;
 
   Eigen::SparseMatrix<uint> matrix;
+  std::vector<AbstractValueAlgorithm::Triplet> triplets;
   uint maxValue;
   std::vector<kwiver::vital::frame_id_t> frames;
 
-  QImage image;
+  // Layout-space position of each nonzero, sorted by base tile; this depends
+  // only on the matrix and layout, and survives value and scale changes
+  QVector<MatrixEntry> entries;
+  QHash<quint64, QPair<int, int>> baseTiles;
+  QSize imageSize;
   int offset;
 
+  // Normalized intensity of each nonzero, in the order of triplets
+  QVector<float> intensities;
+  QHash<int, float> sumPoolingScales;
+
+  QScopedPointer<GradientLookupTable> colors;
+  QCache<quint64, QImage> tiles;
+
+  double zoom;
+
   QGraphicsScene scene;
 };
 
@@ -198,80 +266,282 @@ void MatchMatrixWindowPrivate::persist(
 }
 
 //-----------------------------------------------------------------------------
-void MatchMatrixWindowPrivate::buildHorizontalImage(
-  qtGradient const& gradient,
-  AbstractValueAlgorithm const& valueAlgorithm,
-  AbstractScaleAlgorithm const& scaleAlgorithm)
+void MatchMatrixWindowPrivate::buildLayout()
 {
-  auto const k = this->matrix.rows();
-  auto minY = k;
-  auto maxY = k;
+  auto const k = static_cast<int>(this->matrix.rows());
+  auto const layout = this->UI.layout->currentIndex();
 
-  auto image = QImage(k, k * 2, QImage::Format_RGB32);
-  image.fill(gradient.at(0.0));
+  this->entries.clear();
+  this->entries.reserve(static_cast<int>(this->triplets.size()));
 
-  foreach (auto it, kwiver::vital::enumerate(this->matrix))
+  // Map each nonzero into layout space, tracking the extent of the skewed
+  // axis so that empty space can be trimmed
+  auto minPos = k - 1;
+  auto maxPos = k - 1;
+  auto index = 0;
+
+  for (auto const& t : this->triplets)
+  {
+    auto const row = static_cast<int>(t.row());
+    auto const col = static_cast<int>(t.col());
+
+    MatrixEntry entry;
+    entry.index = index++;
+
+    switch (layout)
+    {
+      case Horizontal:
+        entry.x = row;
+        entry.y = col + k - 1 - row;
+        minPos = qMin(minPos, entry.y);
+        maxPos = qMax(maxPos, entry.y);
+        break;
+
+      case Vertical:
+        entry.x = row + k - 1 - col;
+        entry.y = col;
+        minPos = qMin(minPos, entry.x);
+        maxPos = qMax(maxPos, entry.x);
+        break;
+
+      default: // Diagonal
+        entry.x = row;
+        entry.y = col;
+        break;
+    }
+
+    this->entries.append(entry);
+  }
+
+  switch (layout)
   {
-    auto const y = it.col() + k - 1 - it.row();
-    minY = qMin(minY, y);
-    maxY = qMax(maxY, y);
+    case Horizontal:
+      for (auto& entry : this->entries)
+      {
+        entry.y -= minPos;
+      }
+      this->imageSize = QSize(k, maxPos - minPos + 1);
+      this->offset = minPos;
+      break;
 
-    auto const a = scaleAlgorithm(valueAlgorithm(this->matrix, it));
-    auto const c = gradient.at(a);
-    image.setPixel(it.row(), y, c.rgba());
+    case Vertical:
+      for (auto& entry : this->entries)
+      {
+        entry.x -= minPos;
+      }
+      this->imageSize = QSize(maxPos - minPos + 1, k);
+      this->offset = minPos;
+      break;
+
+    default: // Diagonal
+      this->imageSize = QSize(k, k);
+      this->offset = 0;
+      break;
+  }
+
+  // Bucket entries by base (level 0) tile
+  std::stable_sort(this->entries.begin(), this->entries.end());
+
+  this->baseTiles.clear();
+  for (int i = 0, n = this->entries.count(); i < n;)
+  {
+    auto const& first = this->entries[i];
+    auto const tx = first.x >> TileShift;
+    auto const ty = first.y >> TileShift;
+
+    auto j = i + 1;
+    while (j < n && !(first < this->entries[j]))
+    {
+      ++j;
+    }
+
+    this->baseTiles.insert(tileKey(0, tx, ty), qMakePair(i, j));
+    i = j;
   }
 
-  this->image = image.copy(0, minY, k, maxY - minY + 1);
-  this->offset = minY;
+  this->tiles.clear();
 }
 
 //-----------------------------------------------------------------------------
-void MatchMatrixWindowPrivate::buildVerticalImage(
-  qtGradient const& gradient,
+void MatchMatrixWindowPrivate::computeIntensities(
   AbstractValueAlgorithm const& valueAlgorithm,
   AbstractScaleAlgorithm const& scaleAlgorithm)
 {
-  auto const k = this->matrix.rows();
-  auto minX = k;
-  auto maxX = k;
+  auto const n = this->triplets.size();
+  this->intensities.resize(static_cast<int>(n));
+
+  auto* const out = this->intensities.data();
+  valueAlgorithm(this->matrix, this->triplets.data(), n, out);
+  scaleAlgorithm(out, out, n);
+
+  this->sumPoolingScales.clear();
+  this->tiles.clear();
+}
+
+//-----------------------------------------------------------------------------
+int MatchMatrixWindowPrivate::maxLevel() const
+{
+  // Coarsest level is the one at which the whole image fits in one tile
+  auto const extent = qMax(this->imageSize.width(), this->imageSize.height());
+
+  auto level = 0;
+  while ((TileSize << level) < extent && level < 16)
+  {
+    ++level;
+  }
 
-  auto image = QImage(k * 2, k, QImage::Format_RGB32);
-  image.fill(gradient.at(0.0));
+  return level;
+}
 
-  foreach (auto it, kwiver::vital::enumerate(this->matrix))
+//-----------------------------------------------------------------------------
+float MatchMatrixWindowPrivate::sumPoolingScale(int level)
+{
+  // At level 0 every pixel holds at most one entry, so sums are already in
+  // range; coarser levels are normalized by their largest pooled sum
+  if (level == 0)
   {
-    auto const x = it.row() + k - 1 - it.col();
-    minX = qMin(minX, x);
-    maxX = qMax(maxX, x);
+    return 1.0f;
+  }
 
-    auto const a = scaleAlgorithm(valueAlgorithm(this->matrix, it));
-    auto const c = gradient.at(a);
-    image.setPixel(x, it.col(), c.rgba());
+  auto const i = this->sumPoolingScales.find(level);
+  if (i != this->sumPoolingScales.end())
+  {
+    return i.value();
   }
 
-  this->image = image.copy(minX, 0, maxX - minX + 1, k);
-  this->offset = minX;
+  QHash<quint64, float> sums;
+  sums.reserve(this->entries.count());
+
+  auto maxSum = 0.0f;
+  foreach (auto const& entry, this->entries)
+  {
+    auto& sum = sums[tileKey(0, entry.x >> level, entry.y >> level)];
+    sum += this->intensities[entry.index];
+    maxSum = qMax(maxSum, sum);
+  }
+
+  auto const scale = (maxSum > 0.0f ? 1.0f / maxSum : 1.0f);
+  this->sumPoolingScales.insert(level, scale);
+  return scale;
 }
 
 //-----------------------------------------------------------------------------
-void MatchMatrixWindowPrivate::buildDiagonalImage(
-  qtGradient const& gradient,
-  AbstractValueAlgorithm const& valueAlgorithm,
-  AbstractScaleAlgorithm const& scaleAlgorithm)
+QImage const& MatchMatrixWindowPrivate::tile(int level, int tx, int ty)
+{
+  auto const key = tileKey(level, tx, ty);
+  if (auto* const cached = this->tiles.object(key))
+  {
+    return *cached;
+  }
+
+  auto* const image = new QImage(this->renderTile(level, tx, ty));
+  this->tiles.insert(key, image);
+  return *image;
+}
+
+//-----------------------------------------------------------------------------
+QImage MatchMatrixWindowPrivate::renderTile(int level, int tx, int ty)
+{
+  // Each tile pixel at this level covers a (2^level)^2 block of frame pairs,
+  // which correspond to (2^level)^2 base tiles
+  auto const span = 1 << level;
+  auto const x0 = tx << (TileShift + level);
+  auto const y0 = ty << (TileShift + level);
+
+  auto const sum = (this->UI.pooling->currentIndex() == SumPooling);
+  QVector<float> pooled(TileSize * TileSize, 0.0f);
+
+  auto poolBaseTile = [&](QPair<int, int> const& range){
+    for (auto i = range.first; i < range.second; ++i)
+    {
+      auto const& entry = this->entries[i];
+      auto const px = (entry.x - x0) >> level;
+      auto const py = (entry.y - y0) >> level;
+      auto const v = this->intensities[entry.index];
+      auto& p = pooled[py * TileSize + px];
+      p = (sum ? p + v : qMax(p, v));
+    }
+  };
+
+  auto const bx0 = tx << level;
+  auto const by0 = ty << level;
+  if (span * span <= this->baseTiles.count())
+  {
+    for (auto by = by0; by < by0 + span; ++by)
+    {
+      for (auto bx = bx0; bx < bx0 + span; ++bx)
+      {
+        auto const i = this->baseTiles.find(tileKey(0, bx, by));
+        if (i != this->baseTiles.end())
+        {
+          poolBaseTile(i.value());
+        }
+      }
+    }
+  }
+  else
+  {
+    // Sparser to walk the occupied base tiles than the covered ones
+    for (auto i = this->baseTiles.begin(); i != this->baseTiles.end(); ++i)
+    {
+      auto const& first = this->entries[i.value().first];
+      auto const bx = first.x >> TileShift;
+      auto const by = first.y >> TileShift;
+      if (bx >= bx0 && bx < bx0 + span && by >= by0 && by < by0 + span)
+      {
+        poolBaseTile(i.value());
+      }
+    }
+  }
+
+  // Colorize pooled values; empty pixels are zero, which maps to the same
+  // color as the background
+  if (sum)
+  {
+    auto const scale = this->sumPoolingScale(level);
+    for (auto& p : pooled)
+    {
+      p *= scale;
+    }
+  }
+
+  auto image = QImage(TileSize, TileSize, QImage::Format_RGB32);
+  for (auto y = 0; y < TileSize; ++y)
+  {
+    auto* const line = reinterpret_cast<QRgb*>(image.scanLine(y));
+    auto const* const values = pooled.constData() + (y * TileSize);
+    (*this->colors)(values, line, TileSize);
+  }
+
+  return image;
+}
+
+//-----------------------------------------------------------------------------
+QImage MatchMatrixWindowPrivate::renderImage()
 {
-  auto const k = this->matrix.rows();
-  auto image = QImage(k, k, QImage::Format_RGB32);
-  image.fill(gradient.at(0.0));
+  auto image = QImage(this->imageSize, QImage::Format_RGB32);
+  if (image.isNull())
+  {
+    return image;
+  }
 
-  foreach (auto it, kwiver::vital::enumerate(this->matrix))
+  QPainter painter(&image);
+
+  auto const nx = (this->imageSize.width() + TileSize - 1) >> TileShift;
+  auto const ny = (this->imageSize.height() + TileSize - 1) >> TileShift;
+  for (auto ty = 0; ty < ny; ++ty)
   {
-    auto const a = scaleAlgorithm(valueAlgorithm(this->matrix, it));
-    auto const c = gradient.at(a);
-    image.setPixel(it.row(), it.col(), c.rgba());
+    for (auto tx = 0; tx < nx; ++tx)
+    {
+      auto const key = tileKey(0, tx, ty);
+      auto const* const cached = this->tiles.object(key);
+      auto const& tile =
+        (cached ? *cached : this->renderTile(0, tx, ty));
+      painter.drawImage(tx * TileSize, ty * TileSize, tile);
+    }
   }
 
-  this->image = image;
-  this->offset = 0;
+  return image;
 }
 
 //END MatchMatrixWindowPrivate
@@ -281,10 +551,15 @@ void MatchMatrixWindowPrivate::buildDiagonalImage(
 //BEGIN MatchMatrixImageItem
 
 //-----------------------------------------------------------------------------
-class MatchMatrixImageItem : public QGraphicsPixmapItem
+class MatchMatrixImageItem : public QGraphicsItem
 {
 public:
-  MatchMatrixImageItem(QImage const& image, MatchMatrixWindowPrivate* q);
+  MatchMatrixImageItem(MatchMatrixWindowPrivate* q);
+
+  virtual QRectF boundingRect() const QTE_OVERRIDE;
+  virtual void paint(QPainter* painter,
+                     QStyleOptionGraphicsItem const* option,
+                     QWidget* widget) QTE_OVERRIDE;
 
 protected:
   virtual void hoverEnterEvent(QGraphicsSceneHoverEvent* event) QTE_OVERRIDE;
@@ -298,11 +573,76 @@ protected:
 };
 
 //-----------------------------------------------------------------------------
-MatchMatrixImageItem::MatchMatrixImageItem(
-  QImage const& image, MatchMatrixWindowPrivate* q)
-  : QGraphicsPixmapItem(QPixmap::fromImage(image)), q_ptr(q)
+MatchMatrixImageItem::MatchMatrixImageItem(MatchMatrixWindowPrivate* q)
+  : q_ptr(q)
 {
   this->setAcceptHoverEvents(true);
+  this->setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
+}
+
+//-----------------------------------------------------------------------------
+QRectF MatchMatrixImageItem::boundingRect() const
+{
+  QTE_Q();
+  return QRectF(QPointF(0.0, 0.0), q->imageSize);
+}
+
+//-----------------------------------------------------------------------------
+void MatchMatrixImageItem::paint(
+  QPainter* painter, QStyleOptionGraphicsItem const* option, QWidget*)
+{
+  QTE_Q();
+
+  auto const bounds = this->boundingRect();
+  auto const exposed = option->exposedRect & bounds;
+  if (exposed.isEmpty())
+  {
+    return;
+  }
+
+  // Pick the coarsest pyramid level whose pixels (2^level matrix cells) are
+  // still no larger than one device pixel, so that no detail is lost; level 0
+  // is used when matrix cells are already larger than a device pixel
+  auto const lod =
+    QStyleOptionGraphicsItem::levelOfDetailFromTransform(
+      painter->worldTransform());
+  auto const maxLevel = q->maxLevel();
+  auto level = 0;
+  while (level < maxLevel && (lod * (2 << level)) <= 1.0)
+  {
+    ++level;
+  }
+
+  painter->setRenderHint(QPainter::SmoothPixmapTransform, level > 0);
+
+  // Draw only the tiles which intersect the exposed area
+  auto const span = static_cast<double>(TileSize << level);
+  auto const tx0 = static_cast<int>(floor(exposed.left() / span));
+  auto const ty0 = static_cast<int>(floor(exposed.top() / span));
+  auto const tx1 = static_cast<int>(floor(exposed.right() / span));
+  auto const ty1 = static_cast<int>(floor(exposed.bottom() / span));
+
+  for (auto ty = ty0; ty <= ty1; ++ty)
+  {
+    for (auto tx = tx0; tx <= tx1; ++tx)
+    {
+      // Clip tiles at the image edge to the item bounds
+      auto const tileRect = QRectF(tx * span, ty * span, span, span);
+      auto const target = tileRect & bounds;
+      if (target.isEmpty())
+      {
+        continue;
+      }
+
+      auto const scale = 1.0 / static_cast<double>(1 << level);
+      auto const source =
+        QRectF((target.left() - tileRect.left()) * scale,
+               (target.top() - tileRect.top()) * scale,
+               target.width() * scale, target.height() * scale);
+
+      painter->drawImage(target, q->tile(level, tx, ty), source);
+    }
+  }
 }
 
 //-----------------------------------------------------------------------------
@@ -414,6 +754,7 @@ MatchMatrixWindow::MatchMatrixWindow(QWidget* parent, Qt::WindowFlags flags)
   d->uiState.setCurrentGroup("MatchMatrixWindow");
   d->persist("Layout", d->UI.layout);
   d->persist("Orientation", d->UI.orientation);
+  d->persist("Pooling", d->UI.pooling);
   d->persist("Values", d->UI.values);
   d->persist("Scale", d->UI.scale);
   d->persist("Exponent", d->UI.exponent);
@@ -425,26 +766,34 @@ MatchMatrixWindow::MatchMatrixWindow(QWidget* parent, Qt::WindowFlags flags)
   d->uiState.mapGeometry("Window/geometry", this);
   d->uiState.restore();
 
+  d->colors.reset(new GradientLookupTable(d->UI.color->currentGradient()));
+
   this->updateControls();
   this->updateImageTransform();
 
   // Set up signals/slots
   connect(d->UI.actionSaveImage, SIGNAL(triggered()), this, SLOT(saveImage()));
+  connect(d->UI.actionZoomIn, SIGNAL(triggered()), this, SLOT(zoomIn()));
+  connect(d->UI.actionZoomOut, SIGNAL(triggered()), this, SLOT(zoomOut()));
+  connect(d->UI.actionZoomExtents, SIGNAL(triggered()),
+          this, SLOT(zoomExtents()));
 
   connect(d->UI.layout, SIGNAL(currentIndexChanged(QString)),
           this, SLOT(updateImage()));
   connect(d->UI.orientation, SIGNAL(currentIndexChanged(QString)),
           this, SLOT(updateImageTransform()));
+  connect(d->UI.pooling, SIGNAL(currentIndexChanged(QString)),
+          this, SLOT(updateTiles()));
   connect(d->UI.values, SIGNAL(currentIndexChanged(QString)),
-          this, SLOT(updateImage()));
+          this, SLOT(updateValues()));
   connect(d->UI.scale, SIGNAL(currentIndexChanged(QString)),
-          this, SLOT(updateImage()));
+          this, SLOT(updateValues()));
   connect(d->UI.color, SIGNAL(currentIndexChanged(QString)),
-          this, SLOT(updateImage()));
+          this, SLOT(updateTiles()));
   connect(d->UI.exponent, SIGNAL(valueChanged(double)),
-          this, SLOT(updateImage()));
+          this, SLOT(updateValues()));
   connect(d->UI.range, SIGNAL(valueChanged(double)),
-          this, SLOT(updateImage()));
+          this, SLOT(updateValues()));
 
   connect(d->UI.values, SIGNAL(currentIndexChanged(QString)),
           this, SLOT(updateControls()));
@@ -469,6 +818,13 @@ void MatchMatrixWindow::setMatrix(Eigen::SparseMatrix<uint> const& matrix,
   d->maxValue = sparseMax(matrix);
   d->frames = frames;
 
+  d->triplets.clear();
+  d->triplets.reserve(static_cast<size_t>(matrix.nonZeros()));
+  foreach (auto it, kwiver::vital::enumerate(matrix))
+  {
+    d->triplets.emplace_back(it.row(), it.col(), it.value());
+  }
+
   this->updateImage();
 }
 
@@ -493,10 +849,12 @@ void MatchMatrixWindow::saveImage(QString const& path)
 {
   QTE_D();
 
+  // Saved images are always written at full resolution
   auto const flip = (d->UI.orientation->currentIndex() == Graph);
-  auto const& image = (flip ? d->image.mirrored() : d->image);
+  auto const& fullImage = d->renderImage();
+  auto const& image = (flip ? fullImage.mirrored() : fullImage);
 
-  if (!image.save(path))
+  if (image.isNull() || !image.save(path))
   {
     static auto const msgFormat = QString("Failed to write image to \"%1\".");
     QMessageBox::critical(this, "Error", msgFormat.arg(path));
@@ -550,10 +908,26 @@ void MatchMatrixWindow::updateImage()
 {
   QTE_D();
 
+  // Rebuild the layout-space geometry; this is the only step which depends
+  // on the layout, and is reused across value, scale and color changes
+  d->buildLayout();
+
+  d->scene.clear();
+  auto* const item = new MatchMatrixImageItem(d);
+  d->scene.addItem(item);
+  d->scene.setSceneRect(item->boundingRect());
+
+  this->updateValues();
+}
+
+//-----------------------------------------------------------------------------
+void MatchMatrixWindow::updateValues()
+{
+  QTE_D();
+
   // Set up visualization
   QScopedPointer<AbstractValueAlgorithm> valueAlgorithm;
   QScopedPointer<AbstractScaleAlgorithm> scaleAlgorithm;
-  auto const& gradient = d->UI.color->currentGradient();
 
   switch (d->UI.values->currentIndex())
   {
@@ -596,22 +970,19 @@ void MatchMatrixWindow::updateImage()
       break;
   }
 
-  // Build image
-  switch (d->UI.layout->currentIndex())
-  {
-    case Horizontal:
-      d->buildHorizontalImage(gradient, *valueAlgorithm, *scaleAlgorithm);
-      break;
-    case Vertical:
-      d->buildVerticalImage(gradient, *valueAlgorithm, *scaleAlgorithm);
-      break;
-    default: // Diagonal
-      d->buildDiagonalImage(gradient, *valueAlgorithm, *scaleAlgorithm);
-      break;
-  }
+  // Recompute intensities; this discards rendered tiles
+  d->computeIntensities(*valueAlgorithm, *scaleAlgorithm);
+  d->scene.update();
+}
 
-  d->scene.clear();
-  d->scene.addItem(new MatchMatrixImageItem(d->image, d));
+//-----------------------------------------------------------------------------
+void MatchMatrixWindow::updateTiles()
+{
+  QTE_D();
+
+  d->colors.reset(new GradientLookupTable(d->UI.color->currentGradient()));
+  d->tiles.clear();
+  d->scene.update();
 }
 
 //-----------------------------------------------------------------------------
@@ -620,7 +991,45 @@ void MatchMatrixWindow::updateImageTransform()
   QTE_D();
 
   auto const s = (d->UI.orientation->currentIndex() == Graph ? -1.0 : 1.0);
-  d->UI.view->setTransform(QTransform::fromScale(1.0, s));
+  d->UI.view->setTransform(QTransform::fromScale(d->zoom, d->zoom * s));
+}
+
+//-----------------------------------------------------------------------------
+void MatchMatrixWindow::zoomIn()
+{
+  QTE_D();
+
+  d->zoom *= ZoomStep;
+  this->updateImageTransform();
+}
+
+//-----------------------------------------------------------------------------
+void MatchMatrixWindow::zoomOut()
+{
+  QTE_D();
+
+  d->zoom /= ZoomStep;
+  this->updateImageTransform();
+}
+
+//-----------------------------------------------------------------------------
+void MatchMatrixWindow::zoomExtents()
+{
+  QTE_D();
+
+  if (d->imageSize.isEmpty())
+  {
+    return;
+  }
+
+  auto const& viewport = d->UI.view->viewport()->size();
+  auto const zx = static_cast<double>(viewport.width()) /
+                  static_cast<double>(d->imageSize.width());
+  auto const zy = static_cast<double>(viewport.height()) /
+                  static_cast<double>(d->imageSize.height());
+
+  d->zoom = qMin(zx, zy);
+  this->updateImageTransform();
 }
 
 //END MatchMatrixWindow
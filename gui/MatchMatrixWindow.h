@@ -56,9 +56,15 @@ public slots:
   void saveImage();
   void saveImage(QString const& path);
 
+  void zoomIn();
+  void zoomOut();
+  void zoomExtents();
+
 protected slots:
   void updateControls();
   void updateImage();
+  void updateValues();
+  void updateTiles();
   void updateImageTransform();
 
 private:
@@ -74,6 +74,14 @@ bool Project::read(QString const& path)
                                                          prefix);
 
     this->cameraPath = getPath(config, base, "output_krtd_dir");
+    // Prefer a packed camera archive, if one was written
+    auto const& archivePath =
+      config->get_value<std::string>("output_camera_archive", "");
+    if (!archivePath.empty() &&
+        QFileInfo(base.filePath(qtString(archivePath))).isFile())
+    {
+      this->cameraPath = base.filePath(qtString(archivePath));
+    }
     this->landmarks = getPath(config, base, "output_ply_file");
     this->tracks =
       getPath(config, base, "input_track_file", "output_tracks_file");
@@ -38,6 +38,7 @@
 #include "DepthMapOptions.h"
 #include "FieldInformation.h"
 #include "ImageOptions.h"
+#include "LandmarkStatistics.h"
 #include "PointOptions.h"
 #include "VolumeOptions.h"
 #include "vtkMaptkImageUnprojectDepth.h"
@@ -55,6 +56,7 @@
 #include <vtkCubeAxesActor.h>
 #include <vtkDoubleArray.h>
 #include <vtkGeometryFilter.h>
+#include <vtkIdTypeArray.h>
 #include <vtkImageActor.h>
 #include <vtkImageData.h>
 #include <vtkMaptkImageDataGeometryFilter.h>
@@ -68,6 +70,8 @@
 #include <vtkProperty.h>
 #include <vtkRenderWindow.h>
 #include <vtkRenderer.h>
+#include <vtkSMPThreadLocal.h>
+#include <vtkSMPTools.h>
 #include <vtkStructuredGrid.h>
 #include <vtkTextProperty.h>
 #include <vtkThreshold.h>
@@ -96,10 +100,74 @@
 
 #include <QFileInfo>
 
+#include <numeric>
+#include <vector>
+
 using namespace LandmarkArrays;
 
 QTE_IMPLEMENT_D_FUNC(WorldView)
 
+namespace // anonymous
+{
+
+//-----------------------------------------------------------------------------
+class LandmarkArrayFiller
+{
+public:
+  LandmarkArrayFiller(
+    std::vector<kwiver::vital::landmark const*> const& landmarks,
+    float* points, unsigned char* colors, double* elevations,
+    unsigned* observations)
+    : landmarks(landmarks), points(points), colors(colors),
+      elevations(elevations), observations(observations) {}
+
+  void operator()(vtkIdType begin, vtkIdType end);
+
+  LandmarkStatistics statistics();
+
+protected:
+  std::vector<kwiver::vital::landmark const*> const& landmarks;
+  float* const points;
+  unsigned char* const colors;
+  double* const elevations;
+  unsigned* const observations;
+
+  vtkSMPThreadLocal<LandmarkStatistics> localStatistics;
+};
+
+//-----------------------------------------------------------------------------
+void LandmarkArrayFiller::operator()(vtkIdType begin, vtkIdType end)
+{
+  auto& stats = this->localStatistics.Local();
+
+  for (auto i = begin; i < end; ++i)
+  {
+    auto const& lm = *this->landmarks[i];
+    auto const& pos = lm.loc();
+    auto const& color = lm.color();
+    auto const observations = lm.observations();
+
+    this->points[3 * i + 0] = static_cast<float>(pos[0]);
+    this->points[3 * i + 1] = static_cast<float>(pos[1]);
+    this->points[3 * i + 2] = static_cast<float>(pos[2]);
+    this->colors[3 * i + 0] = color.r;
+    this->colors[3 * i + 1] = color.g;
+    this->colors[3 * i + 2] = color.b;
+    this->elevations[i] = pos[2];
+    this->observations[i] = observations;
+
+    stats.add(color, pos[2], observations);
+  }
+}
+
+//-----------------------------------------------------------------------------
+LandmarkStatistics LandmarkArrayFiller::statistics()
+{
+  return LandmarkStatistics::combine(this->localStatistics);
+}
+
+} // namespace <anonymous>
+
 //-----------------------------------------------------------------------------
 class WorldViewPrivate
 {
@@ -810,58 +878,62 @@ void WorldView::setLandmarks(kwiver::vital::landmark_map const& lm)
   auto const& landmarks = lm.landmarks();
   auto const size = static_cast<vtkIdType>(landmarks.size());
 
-  auto const defaultColor = kwiver::vital::rgb_color{};
-  auto haveColor = false;
-  auto maxObservations = unsigned{0};
-  auto minZ = qInf(), maxZ = -qInf();
-
-  d->landmarkPoints->Reset();
-  d->landmarkVerts->Reset();
-  d->landmarkColors->Reset();
-  d->landmarkElevations->Reset();
-  d->landmarkObservations->Reset();
-  d->landmarkPoints->Allocate(size);
-  d->landmarkVerts->Allocate(size);
-  d->landmarkColors->Allocate(3 * size);
-  d->landmarkElevations->Allocate(size);
-  d->landmarkObservations->Allocate(size);
-
-  vtkIdType vertIndex = 0;
-  foreach (auto const& lm, landmarks)
+  // Gather the landmarks so they can be visited in parallel
+  auto landmarkPtrs = std::vector<kwiver::vital::landmark const*>{};
+  landmarkPtrs.reserve(landmarks.size());
+  for (auto const& lmi : landmarks)
+  {
+    landmarkPtrs.push_back(lmi.second.get());
+  }
+
+  // Size arrays once, then fill them in parallel
+  d->landmarkPoints->SetDataTypeToFloat();
+  d->landmarkPoints->SetNumberOfPoints(size);
+  d->landmarkColors->SetNumberOfTuples(size);
+  d->landmarkElevations->SetNumberOfTuples(size);
+  d->landmarkObservations->SetNumberOfTuples(size);
+
+  auto* const points =
+    static_cast<float*>(d->landmarkPoints->GetVoidPointer(0));
+  LandmarkArrayFiller filler(landmarkPtrs, points,
+                             d->landmarkColors->GetPointer(0),
+                             d->landmarkElevations->GetPointer(0),
+                             d->landmarkObservations->GetPointer(0));
+  vtkSMPTools::For(0, size, filler);
+
+  auto const stats = filler.statistics();
+
+  // Render all landmarks as a single poly-vertex cell
+  if (size)
+  {
+    vtkNew<vtkIdTypeArray> verts;
+    verts->SetNumberOfValues(size + 1);
+    verts->SetValue(0, size);
+    std::iota(verts->GetPointer(1), verts->GetPointer(1) + size,
+              vtkIdType{0});
+    d->landmarkVerts->SetCells(1, verts.GetPointer());
+  }
+  else
   {
-    auto const& pos = lm.second->loc();
-    auto const& color = lm.second->color();
-    auto const observations = lm.second->observations();
-
-    d->landmarkPoints->InsertNextPoint(pos.data());
-    d->landmarkVerts->InsertNextCell(1);
-    d->landmarkVerts->InsertCellPoint(vertIndex++);
-    d->landmarkColors->InsertNextValue(color.r);
-    d->landmarkColors->InsertNextValue(color.g);
-    d->landmarkColors->InsertNextValue(color.b);
-    d->landmarkElevations->InsertNextValue(pos[2]);
-    d->landmarkObservations->InsertNextValue(observations);
-
-    haveColor = haveColor || (color != defaultColor);
-    maxObservations = qMax(maxObservations, observations);
-    minZ = qMin(minZ, pos[2]);
-    maxZ = qMax(maxZ, pos[2]);
+    d->landmarkVerts->Reset();
   }
 
   auto fields = QHash<QString, FieldInformation>{};
-  fields.insert("Elevation", FieldInformation{Elevation, {minZ, maxZ}});
-  if (maxObservations)
+  fields.insert("Elevation",
+                FieldInformation{Elevation, {stats.minZ, stats.maxZ}});
+  if (stats.maxObservations)
   {
-    auto const upper = static_cast<double>(maxObservations);
+    auto const upper = static_cast<double>(stats.maxObservations);
     fields.insert("Observations", FieldInformation{Observations, {0.0, upper}});
   }
 
-  d->landmarkOptions->setTrueColorAvailable(haveColor);
+  d->landmarkOptions->setTrueColorAvailable(stats.haveColor);
   d->landmarkOptions->setDataFields(fields);
 
   d->landmarkPoints->Modified();
   d->landmarkVerts->Modified();
   d->landmarkColors->Modified();
+  d->landmarkElevations->Modified();
   d->landmarkObservations->Modified();
 
   d->updateScale(this);
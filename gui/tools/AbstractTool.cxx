@@ -33,6 +33,92 @@
 #include <QtCore/QThread>
 
 #include <atomic>
+#include <unordered_map>
+
+namespace // anonymous
+{
+
+//-----------------------------------------------------------------------------
+bool isSameTrack(kwiver::vital::track const& a, kwiver::vital::track const& b)
+{
+  // Tracks are only ever extended (states are not replaced), so a track whose
+  // extent matches that of an earlier copy is unchanged
+  return a.size() == b.size() &&
+         a.first_frame() == b.first_frame() &&
+         a.last_frame() == b.last_frame();
+}
+
+//-----------------------------------------------------------------------------
+bool isSameCamera(kwiver::vital::camera const& a,
+                  kwiver::vital::camera const& b)
+{
+  if (a.center() != b.center() ||
+      a.rotation().quaternion().coeffs() != b.rotation().quaternion().coeffs())
+  {
+    return false;
+  }
+
+  auto const& ai = a.intrinsics();
+  auto const& bi = b.intrinsics();
+  if (ai == bi)
+  {
+    return true;
+  }
+
+  return ai && bi &&
+         ai->as_matrix() == bi->as_matrix() &&
+         ai->dist_coeffs() == bi->dist_coeffs();
+}
+
+//-----------------------------------------------------------------------------
+bool isSameLandmark(kwiver::vital::landmark const& a,
+                    kwiver::vital::landmark const& b)
+{
+  return a.loc() == b.loc() &&
+         a.scale() == b.scale() &&
+         a.normal() == b.normal() &&
+         a.covar().matrix() == b.covar().matrix() &&
+         a.color() == b.color() &&
+         a.observations() == b.observations();
+}
+
+//-----------------------------------------------------------------------------
+// Copy a map of shared objects, reusing the copies in a previous copy of the
+// map (which must also be sorted by key) where the object is unchanged
+template <typename Map, typename Compare>
+Map copyMap(Map const& source, Map const& previous, Compare isSame)
+{
+  auto result = Map{};
+  auto pi = previous.begin();
+  auto const pe = previous.end();
+
+  for (auto const& si : source)
+  {
+    // Advance to the previous copy of this entry, if there is one
+    while (pi != pe && pi->first < si.first)
+    {
+      ++pi;
+    }
+
+    if (!si.second)
+    {
+      result.emplace_hint(result.end(), si.first, si.second);
+    }
+    else if (pi != pe && pi->first == si.first && pi->second &&
+             isSame(*si.second, *pi->second))
+    {
+      result.emplace_hint(result.end(), si.first, pi->second);
+    }
+    else
+    {
+      result.emplace_hint(result.end(), si.first, si.second->clone());
+    }
+  }
+
+  return result;
+}
+
+} // namespace <anonymous>
 
 //-----------------------------------------------------------------------------
 class AbstractToolPrivate : public QThread
@@ -44,6 +130,7 @@ public:
   virtual void run() QTE_OVERRIDE;
 
   std::shared_ptr<ToolData> data;
+  std::shared_ptr<ToolData> lastUpdate;
 
   std::atomic<bool> cancelRequested;
 
@@ -62,14 +149,37 @@ void AbstractToolPrivate::run()
 }
 
 //-----------------------------------------------------------------------------
-void ToolData::copyTracks(feature_track_set_sptr const& newTracks)
+void ToolData::copyTracks(feature_track_set_sptr const& newTracks,
+                          ToolData const* previous)
 {
   if (newTracks)
   {
+    // Index the tracks of the previous copy, if any
+    auto previousTracks =
+      std::unordered_map<kwiver::vital::track_id_t,
+                         kwiver::vital::track_sptr>{};
+    if (previous && previous->tracks)
+    {
+      foreach (auto const& ti, previous->tracks->tracks())
+      {
+        previousTracks.emplace(ti->id(), ti);
+      }
+    }
+
+    auto const& sourceTracks = newTracks->tracks();
     auto copiedTracks = std::vector<kwiver::vital::track_sptr>{};
-    foreach (auto const& ti, newTracks->tracks())
+    copiedTracks.reserve(sourceTracks.size());
+    foreach (auto const& ti, sourceTracks)
     {
-      copiedTracks.push_back(ti->clone());
+      auto const pi = previousTracks.find(ti->id());
+      if (pi != previousTracks.end() && isSameTrack(*ti, *pi->second))
+      {
+        copiedTracks.push_back(pi->second);
+      }
+      else
+      {
+        copiedTracks.push_back(ti->clone());
+      }
     }
     this->tracks =
       std::make_shared<kwiver::vital::feature_track_set>(copiedTracks);
@@ -81,15 +191,17 @@ void ToolData::copyTracks(feature_track_set_sptr const& newTracks)
 }
 
 //-----------------------------------------------------------------------------
-void ToolData::copyCameras(camera_map_sptr const& newCameras)
+void ToolData::copyCameras(camera_map_sptr const& newCameras,
+                           ToolData const* previous)
 {
   if (newCameras)
   {
-    auto copiedCameras = kwiver::vital::camera_map::map_camera_t{};
-    foreach (auto const& ci, newCameras->cameras())
-    {
-      copiedCameras.insert(std::make_pair(ci.first, ci.second->clone()));
-    }
+    auto const previousCameras =
+      (previous && previous->cameras
+        ? previous->cameras->cameras()
+        : kwiver::vital::camera_map::map_camera_t{});
+    auto const copiedCameras =
+      copyMap(newCameras->cameras(), previousCameras, isSameCamera);
     this->cameras =
       std::make_shared<kwiver::vital::simple_camera_map>(copiedCameras);
   }
@@ -100,15 +212,17 @@ void ToolData::copyCameras(camera_map_sptr const& newCameras)
 }
 
 //-----------------------------------------------------------------------------
-void ToolData::copyLandmarks(landmark_map_sptr const& newLandmarks)
+void ToolData::copyLandmarks(landmark_map_sptr const& newLandmarks,
+                             ToolData const* previous)
 {
   if (newLandmarks)
   {
-    auto copiedLandmarks = kwiver::vital::landmark_map::map_landmark_t{};
-    foreach (auto const& ci, newLandmarks->landmarks())
-    {
-      copiedLandmarks.insert(std::make_pair(ci.first, ci.second->clone()));
-    }
+    auto const previousLandmarks =
+      (previous && previous->landmarks
+        ? previous->landmarks->landmarks()
+        : kwiver::vital::landmark_map::map_landmark_t{});
+    auto const copiedLandmarks =
+      copyMap(newLandmarks->landmarks(), previousLandmarks, isSameLandmark);
     this->landmarks =
       std::make_shared<kwiver::vital::simple_landmark_map>(copiedLandmarks);
   }
@@ -200,21 +314,48 @@ void AbstractTool::setImagePaths(std::vector<std::string> const& paths)
 void AbstractTool::setTracks(feature_track_set_sptr const& newTracks)
 {
   QTE_D();
-  d->data->copyTracks(newTracks);
+
+  // Only a tool that outputs tracks may modify them; otherwise, share them
+  if (this->outputs().testFlag(Tracks))
+  {
+    d->data->copyTracks(newTracks);
+  }
+  else
+  {
+    d->data->tracks = newTracks;
+  }
 }
 
 //-----------------------------------------------------------------------------
 void AbstractTool::setCameras(camera_map_sptr const& newCameras)
 {
   QTE_D();
-  d->data->copyCameras(newCameras);
+
+  // Only a tool that outputs cameras may modify them; otherwise, share them
+  if (this->outputs().testFlag(Cameras))
+  {
+    d->data->copyCameras(newCameras);
+  }
+  else
+  {
+    d->data->cameras = newCameras;
+  }
 }
 
 //-----------------------------------------------------------------------------
 void AbstractTool::setLandmarks(landmark_map_sptr const& newLandmarks)
 {
   QTE_D();
-  d->data->copyLandmarks(newLandmarks);
+
+  // Only a tool that outputs landmarks may modify them; otherwise, share them
+  if (this->outputs().testFlag(Landmarks))
+  {
+    d->data->copyLandmarks(newLandmarks);
+  }
+  else
+  {
+    d->data->landmarks = newLandmarks;
+  }
 }
 
 //-----------------------------------------------------------------------------
@@ -223,6 +364,7 @@ bool AbstractTool::execute(QWidget* window)
   QTE_D();
 
   d->cancelRequested = false;
+  d->lastUpdate.reset();
   d->start();
   return true;
 }
@@ -269,6 +411,21 @@ bool AbstractTool::hasLandmarks() const
   return d->data->landmarks && d->data->landmarks->size();
 }
 
+//-----------------------------------------------------------------------------
+ToolData const* AbstractTool::lastUpdate() const
+{
+  QTE_D();
+  return d->lastUpdate.get();
+}
+
+//-----------------------------------------------------------------------------
+void AbstractTool::emitUpdated(std::shared_ptr<ToolData> const& data)
+{
+  QTE_D();
+  d->lastUpdate = data;
+  emit this->updated(data);
+}
+
 //-----------------------------------------------------------------------------
 void AbstractTool::updateTracks(feature_track_set_sptr const& newTracks)
 {
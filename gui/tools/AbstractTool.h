@@ -50,13 +50,26 @@ public:
   typedef kwiver::vital::landmark_map_sptr landmark_map_sptr;
 
   /// Deep copy the feature tracks into this data class
-  void copyTracks(feature_track_set_sptr const&);
+  ///
+  /// If \p previous is given, tracks that are unchanged from the copies held
+  /// by \p previous are shared with it rather than copied again. Because of
+  /// this, the copied tracks must be treated as immutable.
+  void copyTracks(feature_track_set_sptr const&,
+                  ToolData const* previous = 0);
 
   /// Deep copy the cameras into this data class
-  void copyCameras(camera_map_sptr const&);
+  ///
+  /// If \p previous is given, cameras that are unchanged from the copies held
+  /// by \p previous are shared with it rather than copied again. Because of
+  /// this, the copied cameras must be treated as immutable.
+  void copyCameras(camera_map_sptr const&, ToolData const* previous = 0);
 
   /// Deep copy the landmarks into this data class
-  void copyLandmarks(landmark_map_sptr const&);
+  ///
+  /// If \p previous is given, landmarks that are unchanged from the copies
+  /// held by \p previous are shared with it rather than copied again. Because
+  /// of this, the copied landmarks must be treated as immutable.
+  void copyLandmarks(landmark_map_sptr const&, ToolData const* previous = 0);
 
   unsigned int activeFrame;
   std::vector<std::string> imagePaths;
@@ -108,12 +121,24 @@ public:
   void setImagePaths(std::vector<std::string> const&);
 
   /// Set the feature tracks to be used as input to the tool.
+  ///
+  /// The tracks are deep copied only if the tool outputs tracks (and so may
+  /// modify them); otherwise they are shared, and must not be modified by the
+  /// caller while the tool is executing.
   void setTracks(feature_track_set_sptr const&);
 
   /// Set the cameras to be used as input to the tool.
+  ///
+  /// The cameras are deep copied only if the tool outputs cameras (and so may
+  /// modify them); otherwise they are shared, and must not be modified by the
+  /// caller while the tool is executing.
   void setCameras(camera_map_sptr const&);
 
   /// Set the landmarks to be used as input to the tool.
+  ///
+  /// The landmarks are deep copied only if the tool outputs landmarks (and so
+  /// may modify them); otherwise they are shared, and must not be modified by
+  /// the caller while the tool is executing.
   void setLandmarks(landmark_map_sptr const&);
 
   /// Execute the tool.
@@ -137,11 +162,12 @@ public:
   /// Get tracks.
   ///
   /// This returns the new tracks resulting from the tool execution. If the
-  /// tool does not output tracks, the tracks will be a copy of the input
-  /// tracks.
+  /// tool does not output tracks, the tracks will be the input tracks.
   ///
   /// This may also be used by tool implementations to get the input tracks.
-  /// (The tracks will be a copy that can be safely modified.)
+  /// If the tool outputs tracks, they will be a copy that can be safely
+  /// modified; otherwise they are shared with the caller and must not be
+  /// modified.
   ///
   /// \warning Users must not call this method while the tool is executing,
   ///          as doing so may not be thread safe.
@@ -150,11 +176,12 @@ public:
   /// Get cameras.
   ///
   /// This returns the new cameras resulting from the tool execution. If the
-  /// tool does not output cameras, the cameras will be a copy of the input
-  /// cameras.
+  /// tool does not output cameras, the cameras will be the input cameras.
   ///
   /// This may also be used by tool implementations to get the input cameras.
-  /// (The cameras will be a copy that can be safely modified.)
+  /// If the tool outputs cameras, they will be a copy that can be safely
+  /// modified; otherwise they are shared with the caller and must not be
+  /// modified.
   ///
   /// \warning Users must not call this method while the tool is executing,
   ///          as doing so may not be thread safe.
@@ -163,11 +190,13 @@ public:
   /// Get landmarks.
   ///
   /// This returns the new landmarks resulting from the tool execution. If the
-  /// tool does not output landmarks, the landmarks will be a copy of the input
+  /// tool does not output landmarks, the landmarks will be the input
   /// landmarks.
   ///
   /// This may also be used by tool implementations to get the input landmarks.
-  /// (The landmarks will be a copy that can be safely modified.)
+  /// If the tool outputs landmarks, they will be a copy that can be safely
+  /// modified; otherwise they are shared with the caller and must not be
+  /// modified.
   ///
   /// \warning Users must not call this method while the tool is executing,
   ///          as doing so may not be thread safe.
@@ -225,6 +254,21 @@ protected:
   ///         otherwise \c false
   bool hasLandmarks() const;
 
+  /// Get the data most recently passed to emitUpdated.
+  ///
+  /// This returns a null pointer if no intermediate update has been emitted
+  /// during the current execution of the tool. Tool implementations should
+  /// pass the result to ToolData::copyTracks (etc.) when building the next
+  /// update, so that data which has not changed is shared rather than copied.
+  ToolData const* lastUpdate() const;
+
+  /// Emit an intermediate update of the data.
+  ///
+  /// This emits #updated with \p data, and remembers \p data so that it can
+  /// be retrieved with lastUpdate. The data is shared with the recipients of
+  /// the signal and must not be modified after calling this method.
+  void emitUpdated(std::shared_ptr<ToolData> const& data);
+
   /// Set the tracks produced by the tool.
   ///
   /// This sets the tracks that are produced by the tool as output. Unlike
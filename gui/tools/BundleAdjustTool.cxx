@@ -166,11 +166,12 @@ void BundleAdjustTool::run()
 bool BundleAdjustTool::callback_handler(camera_map_sptr cameras,
                                         landmark_map_sptr landmarks)
 {
-  // make a copy of the tool data
+  // make a copy of the tool data, sharing what is unchanged since the last
+  // update
   auto data = std::make_shared<ToolData>();
-  data->copyCameras(cameras);
-  data->copyLandmarks(landmarks);
+  data->copyCameras(cameras, this->lastUpdate());
+  data->copyLandmarks(landmarks, this->lastUpdate());
 
-  emit updated(data);
+  this->emitUpdated(data);
   return !this->isCanceled();
 }
@@ -183,12 +183,13 @@ void TrackFeaturesTool::run()
       tracks = kwiver::maptk::extract_feature_colors(tracks, *image, i);
     }
 
-    // make a copy of the tool data
+    // make a copy of the tool data, sharing what is unchanged since the last
+    // update
     auto data = std::make_shared<ToolData>();
-    data->copyTracks(tracks);
+    data->copyTracks(tracks, this->lastUpdate());
     data->activeFrame = i;
 
-    emit updated(data);
+    this->emitUpdated(data);
     if( this->isCanceled() )
     {
       break;
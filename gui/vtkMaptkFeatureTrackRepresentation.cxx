@@ -31,14 +31,19 @@
 #include "vtkMaptkFeatureTrackRepresentation.h"
 
 
+#include <vital/types/feature_track_set.h>
+
 #include <vtkActor.h>
 #include <vtkCellArray.h>
+#include <vtkIdTypeArray.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
 #include <vtkPolyData.h>
 #include <vtkPolyDataMapper.h>
 
-#include <map>
+#include <algorithm>
+#include <numeric>
+#include <vector>
 
 vtkStandardNewMacro(vtkMaptkFeatureTrackRepresentation);
 
@@ -48,6 +53,24 @@ typedef vtkMaptkFeatureTrackRepresentation::TrailStyleEnum TrailStyleEnum;
 class vtkMaptkFeatureTrackRepresentation::vtkInternal
 {
 public:
+  struct TrackPoint
+  {
+    unsigned Track;
+    unsigned Frame;
+    vtkIdType Point;
+  };
+
+  struct TrackSpan
+  {
+    size_t Track; // Index of the track
+    size_t Slot; // Index of the track's first point at or after the frame
+  };
+
+  vtkInternal() : IndexDirty(false), FirstFrame(0) {}
+
+  void Clear();
+  void BuildIndex();
+
   void UpdateActivePoints(unsigned activeFrame);
   void UpdateTrails(unsigned activeFrame, unsigned trailLength,
                     TrailStyleEnum style);
@@ -60,29 +83,194 @@ public:
   vtkNew<vtkPolyData> PointsPolyData;
   vtkNew<vtkPolyData> TrailsPolyData;
 
-  typedef std::map<unsigned, vtkIdType> TrackType;
-  typedef std::map<unsigned, TrackType> TrackMapType;
-
-  TrackMapType Tracks;
+  // All track points, sorted by track and frame when the index is current
+  std::vector<TrackPoint> Entries;
+  bool IndexDirty;
+
+  // Track-major index; the points of track i, in frame order, are at
+  // [TrackOffsets[i], TrackOffsets[i + 1])
+  std::vector<size_t> TrackOffsets;
+  std::vector<unsigned> TrackFrames;
+  std::vector<vtkIdType> TrackPoints;
+
+  // Frame-major index; for frame f, the points on that frame are at
+  // [FrameOffsets[f - FirstFrame], FrameOffsets[f - FirstFrame + 1]) in
+  // FramePoints, and the tracks whose extent includes f are likewise found
+  // in FrameSpans via SpanOffsets
+  unsigned FirstFrame;
+  std::vector<size_t> FrameOffsets;
+  std::vector<vtkIdType> FramePoints;
+  std::vector<size_t> SpanOffsets;
+  std::vector<TrackSpan> FrameSpans;
 };
 
 //-----------------------------------------------------------------------------
-void vtkMaptkFeatureTrackRepresentation::vtkInternal::UpdateActivePoints(
-  unsigned activeFrame)
+void vtkMaptkFeatureTrackRepresentation::vtkInternal::Clear()
 {
-  this->PointsCells->Reset();
+  this->Entries.clear();
+  this->IndexDirty = false;
+
+  this->TrackOffsets.clear();
+  this->TrackFrames.clear();
+  this->TrackPoints.clear();
 
-  for(auto const& t : this->Tracks)
+  this->FrameOffsets.clear();
+  this->FramePoints.clear();
+  this->SpanOffsets.clear();
+  this->FrameSpans.clear();
+}
+
+//-----------------------------------------------------------------------------
+void vtkMaptkFeatureTrackRepresentation::vtkInternal::BuildIndex()
+{
+  if (!this->IndexDirty)
+  {
+    return;
+  }
+  this->IndexDirty = false;
+
+  // Sort points by track and frame; if a track has more than one point on a
+  // frame, keep the one added last
+  auto& entries = this->Entries;
+  std::stable_sort(entries.begin(), entries.end(),
+                   [](TrackPoint const& a, TrackPoint const& b){
+                     return (a.Track < b.Track ||
+                             (a.Track == b.Track && a.Frame < b.Frame));
+                   });
+
+  auto out = entries.begin();
+  for (auto in = entries.begin(); in != entries.end(); ++in)
   {
-    auto const& track = t.second;
-    auto const fi = track.find(activeFrame);
-    if (fi != track.cend())
+    auto const next = in + 1;
+    if (next == entries.end() ||
+        next->Track != in->Track || next->Frame != in->Frame)
     {
-      this->PointsCells->InsertNextCell(1);
-      this->PointsCells->InsertCellPoint(fi->second);
+      *out++ = *in;
     }
   }
+  entries.erase(out, entries.end());
+
+  // Build track-major index
+  auto const n = entries.size();
+  this->TrackOffsets.clear();
+  this->TrackFrames.resize(n);
+  this->TrackPoints.resize(n);
+
+  auto firstFrame = ~0u, lastFrame = 0u;
+  for (size_t i = 0; i < n; ++i)
+  {
+    if (i == 0 || entries[i].Track != entries[i - 1].Track)
+    {
+      this->TrackOffsets.push_back(i);
+    }
+    this->TrackFrames[i] = entries[i].Frame;
+    this->TrackPoints[i] = entries[i].Point;
+    firstFrame = std::min(firstFrame, entries[i].Frame);
+    lastFrame = std::max(lastFrame, entries[i].Frame);
+  }
+  this->TrackOffsets.push_back(n);
+
+  this->FrameOffsets.clear();
+  this->FramePoints.clear();
+  this->SpanOffsets.clear();
+  this->FrameSpans.clear();
+  if (!n)
+  {
+    return;
+  }
+
+  // Count points and spanning tracks per frame
+  auto const frames = static_cast<size_t>(lastFrame - firstFrame) + 1;
+  auto const tracks = this->TrackOffsets.size() - 1;
+
+  this->FirstFrame = firstFrame;
+  this->FrameOffsets.assign(frames + 1, 0);
+  this->SpanOffsets.assign(frames + 1, 0);
+
+  for (size_t i = 0; i < n; ++i)
+  {
+    ++this->FrameOffsets[this->TrackFrames[i] - firstFrame + 1];
+  }
+
+  for (size_t t = 0; t < tracks; ++t)
+  {
+    auto const ob = this->TrackFrames[this->TrackOffsets[t]] - firstFrame;
+    auto const oe =
+      this->TrackFrames[this->TrackOffsets[t + 1] - 1] - firstFrame;
+    for (auto o = size_t{ob}; o <= oe; ++o)
+    {
+      ++this->SpanOffsets[o + 1];
+    }
+  }
+
+  std::partial_sum(this->FrameOffsets.begin(), this->FrameOffsets.end(),
+                   this->FrameOffsets.begin());
+  std::partial_sum(this->SpanOffsets.begin(), this->SpanOffsets.end(),
+                   this->SpanOffsets.begin());
+
+  // Fill frame-major index; within each frame, entries are in track order
+  this->FramePoints.resize(this->FrameOffsets.back());
+  this->FrameSpans.resize(this->SpanOffsets.back());
+
+  auto nextPoint = std::vector<size_t>(this->FrameOffsets.begin(),
+                                       this->FrameOffsets.end() - 1);
+  auto nextSpan = std::vector<size_t>(this->SpanOffsets.begin(),
+                                      this->SpanOffsets.end() - 1);
+
+  for (size_t t = 0; t < tracks; ++t)
+  {
+    auto const tb = this->TrackOffsets[t];
+    auto const te = this->TrackOffsets[t + 1];
+    auto const ob = this->TrackFrames[tb] - firstFrame;
+    auto const oe = this->TrackFrames[te - 1] - firstFrame;
+
+    auto slot = tb;
+    for (auto o = size_t{ob}; o <= oe; ++o)
+    {
+      while (this->TrackFrames[slot] - firstFrame < o)
+      {
+        ++slot;
+      }
+
+      if (this->TrackFrames[slot] - firstFrame == o)
+      {
+        this->FramePoints[nextPoint[o]++] = this->TrackPoints[slot];
+      }
+      this->FrameSpans[nextSpan[o]++] = TrackSpan{t, slot};
+    }
+  }
+}
+
+//-----------------------------------------------------------------------------
+void vtkMaptkFeatureTrackRepresentation::vtkInternal::UpdateActivePoints(
+  unsigned activeFrame)
+{
+  this->BuildIndex();
 
+  auto const o = static_cast<size_t>(activeFrame - this->FirstFrame);
+  if (activeFrame < this->FirstFrame || o + 1 >= this->FrameOffsets.size())
+  {
+    this->PointsCells->Reset();
+    this->PointsPolyData->Modified();
+    return;
+  }
+
+  // Active points are a contiguous slice of the frame-major index
+  auto const first = this->FramePoints.begin() + this->FrameOffsets[o];
+  auto const last = this->FramePoints.begin() + this->FrameOffsets[o + 1];
+  auto const count = static_cast<vtkIdType>(last - first);
+
+  vtkNew<vtkIdTypeArray> cells;
+  cells->SetNumberOfValues(2 * count);
+
+  auto* out = cells->GetPointer(0);
+  for (auto iter = first; iter != last; ++iter)
+  {
+    *out++ = 1;
+    *out++ = *iter;
+  }
+
+  this->PointsCells->SetCells(count, cells.GetPointer());
   this->PointsPolyData->Modified();
 }
 
@@ -90,7 +278,15 @@ void vtkMaptkFeatureTrackRepresentation::vtkInternal::UpdateActivePoints(
 void vtkMaptkFeatureTrackRepresentation::vtkInternal::UpdateTrails(
   unsigned activeFrame, unsigned trailLength, TrailStyleEnum style)
 {
-  this->TrailsCells->Reset();
+  this->BuildIndex();
+
+  auto const o = static_cast<size_t>(activeFrame - this->FirstFrame);
+  if (activeFrame < this->FirstFrame || o + 1 >= this->SpanOffsets.size())
+  {
+    this->TrailsCells->Reset();
+    this->TrailsPolyData->Modified();
+    return;
+  }
 
   auto const symmetric =
     (style == vtkMaptkFeatureTrackRepresentation::Symmetric);
@@ -99,35 +295,46 @@ void vtkMaptkFeatureTrackRepresentation::vtkInternal::UpdateTrails(
     (trailLength > activeFrame ? 0 : activeFrame - trailLength);
   auto const maxFrame = (symmetric ? activeFrame + trailLength : activeFrame);
 
-  std::vector<vtkIdType> points;
+  // Find the range of points of each track that is active on the active frame
+  auto const first = this->FrameSpans.begin() + this->SpanOffsets[o];
+  auto const last = this->FrameSpans.begin() + this->SpanOffsets[o + 1];
 
-  for (auto const& ti : this->Tracks)
-  {
-    auto const& track = ti.second;
-    if (track.cbegin()->first > activeFrame ||
-        (--track.cend())->first < activeFrame)
-    {
-      // Skip tracks that are not active on the active frame
-      continue;
-    }
+  auto const* const frames = this->TrackFrames.data();
+  std::vector<std::pair<size_t, size_t>> ranges;
+  ranges.reserve(static_cast<size_t>(last - first));
 
-    // Build list of relevant points
-    points.clear();
-
-    auto const fe = track.upper_bound(maxFrame);
-    for (auto fi = track.lower_bound(minFrame); fi != fe; ++fi)
-    {
-      points.push_back(fi->second);
-    }
+  auto size = vtkIdType{0};
+  for (auto iter = first; iter != last; ++iter)
+  {
+    auto const tb = this->TrackOffsets[iter->Track];
+    auto const te = this->TrackOffsets[iter->Track + 1];
+    auto const rb =
+      std::lower_bound(frames + tb, frames + iter->Slot, minFrame) - frames;
+    auto const re =
+      std::upper_bound(frames + iter->Slot, frames + te, maxFrame) - frames;
 
     // Create cell for trail (only if trail is non-empty)
-    auto const n = static_cast<vtkIdType>(points.size());
-    if (n > 1)
+    if (re - rb > 1)
     {
-      this->TrailsCells->InsertNextCell(points.size(), points.data());
+      ranges.push_back(std::make_pair(rb, re));
+      size += static_cast<vtkIdType>(re - rb) + 1;
     }
   }
 
+  // Copy the point IDs of each trail into a single cell array
+  vtkNew<vtkIdTypeArray> cells;
+  cells->SetNumberOfValues(size);
+
+  auto* out = cells->GetPointer(0);
+  auto const* const points = this->TrackPoints.data();
+  for (auto const& r : ranges)
+  {
+    *out++ = static_cast<vtkIdType>(r.second - r.first);
+    out = std::copy(points + r.first, points + r.second, out);
+  }
+
+  this->TrailsCells->SetCells(static_cast<vtkIdType>(ranges.size()),
+                              cells.GetPointer());
   this->TrailsPolyData->Modified();
 }
 
@@ -175,14 +382,87 @@ void vtkMaptkFeatureTrackRepresentation::AddTrackPoint(
   unsigned trackId, unsigned frameId, double x, double y)
 {
   auto const id = this->Internal->Points->InsertNextPoint(x, y, 0.0);
-  this->Internal->Tracks[trackId][frameId] = id;
+  this->Internal->Entries.push_back({trackId, frameId, id});
+  this->Internal->IndexDirty = true;
+}
+
+//-----------------------------------------------------------------------------
+void vtkMaptkFeatureTrackRepresentation::AddTrack(
+  kwiver::vital::track const& track, unsigned firstFrame)
+{
+  // States are ordered by frame, so search backward for the first state to be
+  // added; this keeps adding the newest points of a long track cheap
+  auto first = track.end();
+  while (first != track.begin() &&
+         static_cast<unsigned>((*(first - 1))->frame()) >= firstFrame)
+  {
+    --first;
+  }
+
+  auto const trackId = static_cast<unsigned>(track.id());
+  for (auto iter = first; iter != track.end(); ++iter)
+  {
+    auto const& fts =
+      std::dynamic_pointer_cast<kwiver::vital::feature_track_state>(*iter);
+    if (!fts || !fts->feature)
+    {
+      continue;
+    }
+
+    auto const& loc = fts->feature->loc();
+    this->AddTrackPoint(trackId, static_cast<unsigned>(fts->frame()),
+                        loc[0], loc[1]);
+  }
+}
+
+//-----------------------------------------------------------------------------
+void vtkMaptkFeatureTrackRepresentation::AddTracks(
+  kwiver::vital::feature_track_set const& tracks)
+{
+  auto const& allTracks = tracks.tracks();
+
+  // Allocate storage for all points at once
+  auto count = size_t{0};
+  for (auto const& track : allTracks)
+  {
+    count += track->size();
+  }
+
+  auto const points = this->Internal->Points.GetPointer();
+  auto nextId = points->GetNumberOfPoints();
+  points->SetNumberOfPoints(nextId + static_cast<vtkIdType>(count));
+  this->Internal->Entries.reserve(this->Internal->Entries.size() + count);
+
+  for (auto const& track : allTracks)
+  {
+    auto const trackId = static_cast<unsigned>(track->id());
+    for (auto const& state : *track)
+    {
+      auto const& fts =
+        std::dynamic_pointer_cast<kwiver::vital::feature_track_state>(state);
+      if (!fts || !fts->feature)
+      {
+        continue;
+      }
+
+      auto const& loc = fts->feature->loc();
+      auto const frameId = static_cast<unsigned>(state->frame());
+      points->SetPoint(nextId, loc[0], loc[1], 0.0);
+      this->Internal->Entries.push_back({trackId, frameId, nextId});
+      ++nextId;
+    }
+  }
+
+  points->SetNumberOfPoints(nextId);
+  points->Modified();
+  this->Internal->IndexDirty = true;
 }
 
 //-----------------------------------------------------------------------------
 void vtkMaptkFeatureTrackRepresentation::ClearTrackData()
 {
   this->Internal->Points->Reset();
-  this->Internal->Tracks.clear();
+  this->Internal->Clear();
   this->Internal->PointsCells->Reset();
   this->Internal->TrailsCells->Reset();
 }
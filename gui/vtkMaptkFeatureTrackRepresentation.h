@@ -39,6 +39,11 @@
 
 class vtkActor;
 
+namespace kwiver { namespace vital {
+class feature_track_set;
+class track;
+} }
+
 class vtkMaptkFeatureTrackRepresentation : public vtkObject
 {
 public:
@@ -55,6 +60,14 @@ public:
 
   void AddTrackPoint(unsigned trackId, unsigned frameId, double x, double y);
 
+  // Description:
+  // Add the points of a track that are on or after the specified frame
+  void AddTrack(kwiver::vital::track const& track, unsigned firstFrame = 0);
+
+  // Description:
+  // Add the points of all tracks in a track set
+  void AddTracks(kwiver::vital::feature_track_set const& tracks);
+
   // Description:
   // Remove all track data
   void ClearTrackData();
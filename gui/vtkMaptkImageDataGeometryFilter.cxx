@@ -33,18 +33,55 @@
 #include <vtkCellData.h>
 #include <vtkExecutive.h>
 #include <vtkFloatArray.h>
+#include <vtkIdTypeArray.h>
 #include <vtkImageData.h>
 #include <vtkInformation.h>
 #include <vtkInformationVector.h>
 #include <vtkObjectFactory.h>
 #include <vtkPointData.h>
 #include <vtkPolyData.h>
+#include <vtkSMPTools.h>
+#include <vtkSmartPointer.h>
 
-
+#include <algorithm>
 #include <map>
+#include <numeric>
+#include <vector>
 
 vtkStandardNewMacro(vtkMaptkImageDataGeometryFilter);
 
+namespace // anonymous
+{
+
+//-----------------------------------------------------------------------------
+// Clear the valid flag of each point whose value is outside [min, max]; NaN
+// values are not rejected
+template <typename T>
+void applyConstraint(T const* data, int stride, double minValue,
+                     double maxValue, unsigned char* valid, vtkIdType count)
+{
+  auto apply = [=](vtkIdType begin, vtkIdType end){
+    for (auto i = begin; i < end; ++i)
+    {
+      auto const value = static_cast<double>(data[i * stride]);
+      auto const reject = (value < minValue) | (value > maxValue);
+      valid[i] &= static_cast<unsigned char>(!reject);
+    }
+  };
+  vtkSMPTools::For(0, count, apply);
+}
+
+//-----------------------------------------------------------------------------
+// Number of triangles generated for a quad with the given corner validity
+inline int quadTriangles(bool a, bool b, bool c, bool d)
+{
+  auto const n = static_cast<int>(a) + static_cast<int>(b) +
+                 static_cast<int>(c) + static_cast<int>(d);
+  return (n == 4 ? 2 : (n == 3 ? 1 : 0));
+}
+
+} // namespace <anonymous>
+
 //-----------------------------------------------------------------------------
 class vtkMaptkImageDataGeometryFilter::vtkInternal
 {
@@ -70,6 +107,16 @@ public:
   typedef std::map<std::string, ConstraintRange> ConstraintType;
 
   ConstraintType Constraints;
+
+  // The XY point grid only depends on the image geometry, so it is reused
+  // until that changes
+  vtkSmartPointer<vtkPoints> GridPoints;
+  int GridExtents[6];
+  double GridOrigin[3];
+  double GridSpacing[3];
+
+  // Per-point validity, kept to avoid reallocating on every update
+  std::vector<unsigned char> ValidPoints;
 };
 
 // Construct with initial extent of all the data
@@ -89,6 +136,7 @@ vtkMaptkImageDataGeometryFilter::vtkMaptkImageDataGeometryFilter()
 vtkMaptkImageDataGeometryFilter::~vtkMaptkImageDataGeometryFilter()
 {
   this->SetUnprojectedPointArrayName(0);
+  delete this->Internal;
 }
 
 //-----------------------------------------------------------------------------
@@ -159,10 +207,36 @@ int vtkMaptkImageDataGeometryFilter::RequestData(
     return 1;
   }
 
-  newPts = vtkPoints::New();
+  auto& grid = this->Internal->GridPoints;
+  if (!grid ||
+      !std::equal(extents, extents + 6, this->Internal->GridExtents) ||
+      !std::equal(origin, origin + 3, this->Internal->GridOrigin) ||
+      !std::equal(spacing, spacing + 3, this->Internal->GridSpacing))
+  {
+    grid = vtkSmartPointer<vtkPoints>::New();
+    grid->SetNumberOfPoints(numberOfPoints);
+
+    std::copy(extents, extents + 6, this->Internal->GridExtents);
+    std::copy(origin, origin + 3, this->Internal->GridOrigin);
+    std::copy(spacing, spacing + 3, this->Internal->GridSpacing);
+
+    float* pointsPtr =
+      vtkFloatArray::SafeDownCast(grid->GetData())->GetPointer(0);
+    for (int row = extents[2]; row <= extents[3]; ++row)
+    {
+      float y = origin[1] + row * spacing[1];
+      for (int column = extents[0]; column <= extents[1]; ++column)
+      {
+        *pointsPtr = origin[0] + column * spacing[0];
+        *(++pointsPtr) = y;
+        *(++pointsPtr) = origin[2];
+        ++pointsPtr;
+      }
+    }
+  }
+
+  newPts = grid;
   output->SetPoints(newPts);
-  newPts->FastDelete();
-  newPts->SetNumberOfPoints(numberOfPoints);
 
   // Expect 3D point data for the 2nd output; if not present, use same points
   // as 1st input
@@ -183,20 +257,6 @@ int vtkMaptkImageDataGeometryFilter::RequestData(
     points3D->FastDelete();
   }
 
-  float* pointsPtr =
-    vtkFloatArray::SafeDownCast(newPts->GetData())->GetPointer(0);
-  for (int row = extents[2]; row <= extents[3]; ++row)
-  {
-    float y = origin[1] + row * spacing[1];
-    for (int column = extents[0]; column <= extents[1]; ++column)
-    {
-      *pointsPtr = origin[0] + column * spacing[0];
-      *(++pointsPtr) = y;
-      *(++pointsPtr) = origin[2];
-      ++pointsPtr;
-    }
-  }
-
   // Copy the pointData from input to output
   vtkPointData* pointData = input->GetPointData();
   output->GetPointData()->ShallowCopy(pointData);
@@ -247,105 +307,168 @@ int vtkMaptkImageDataGeometryFilter::RequestData(
     return 1;
   }
 
-  // Add vertices for each point that passes filtering, or all if not
-  // threshold cells
-  vtkCellArray* newVerts = vtkCellArray::New();
-  newVerts->Allocate(numberOfPoints);
-  output->SetVerts(newVerts);
-  outputUnprojected->SetVerts(newVerts);
-  newVerts->FastDelete();
+  auto const columns = static_cast<vtkIdType>(extents[1] - extents[0] + 1);
+  auto const rows = static_cast<vtkIdType>(extents[3] - extents[2] + 1);
+
+  // Build the mask of points that pass filtering, or all if not threshold
+  // cells
+  auto& valid = this->Internal->ValidPoints;
+  valid.assign(static_cast<size_t>(numberOfPoints), 1);
 
-  vtkIdType* validPoints = new vtkIdType[numberOfPoints];
-  vtkIdType* currentPt = validPoints;
-  // Check each constrainst
-  for (vtkIdType i = 0; i < numberOfPoints; ++i)
+  if (this->ThresholdCells)
   {
-    if (this->ThresholdCells && constraints.size())
+    for (auto const& constraint : constraints)
     {
-      bool skipCell = false;
-      for(auto const constraint : constraints)
+      auto* const dataArray = constraint.Array;
+      auto const stride = dataArray->GetNumberOfComponents();
+      switch (dataArray->GetDataType())
       {
-        double value = constraint.Array->GetTuple1(i);
-        if (value < constraint.MinValue || value > constraint.MaxValue)
-        {
-          skipCell = true;
+        vtkTemplateMacro(
+          applyConstraint(
+            static_cast<VTK_TT const*>(dataArray->GetVoidPointer(0)), stride,
+            constraint.MinValue, constraint.MaxValue,
+            valid.data(), numberOfPoints));
+
+        default:
+          vtkErrorMacro(<< "Unsupported constraint array type");
           break;
-        }
       }
+    }
+  }
+
+  auto const* const validPoints = valid.data();
+
+  // Add vertices for each valid point; rows are counted in parallel, and a
+  // prefix sum over the counts gives the offset at which each row's cells
+  // are written
+  std::vector<vtkIdType> vertOffsets(static_cast<size_t>(rows + 1), 0);
+  auto countVerts = [&](vtkIdType begin, vtkIdType end){
+    for (auto row = begin; row < end; ++row)
+    {
+      auto const* const rowValid = validPoints + (row * columns);
+      vertOffsets[row + 1] = std::count(rowValid, rowValid + columns, 1);
+    }
+  };
+  vtkSMPTools::For(0, rows, countVerts);
+  std::partial_sum(vertOffsets.begin(), vertOffsets.end(),
+                   vertOffsets.begin());
+
+  auto const numberOfVerts = vertOffsets.back();
+  auto vertIds = vtkSmartPointer<vtkIdTypeArray>::New();
+  vertIds->SetNumberOfValues(2 * numberOfVerts);
+  auto* const vertIdsPtr = vertIds->GetPointer(0);
 
-      if (skipCell)
+  auto fillVerts = [&](vtkIdType begin, vtkIdType end){
+    for (auto row = begin; row < end; ++row)
+    {
+      auto* out = vertIdsPtr + (2 * vertOffsets[row]);
+      auto const first = row * columns;
+      for (auto i = first; i < first + columns; ++i)
       {
-        *currentPt++ = -1;
-        continue;
+        if (validPoints[i])
+        {
+          *(out++) = 1;
+          *(out++) = i;
+        }
       }
     }
+  };
+  vtkSMPTools::For(0, rows, fillVerts);
 
-    *currentPt++ = i;
-    newVerts->InsertNextCell(1, &i);
-  }
+  vtkCellArray* newVerts = vtkCellArray::New();
+  newVerts->SetCells(numberOfVerts, vertIds);
+  output->SetVerts(newVerts);
+  outputUnprojected->SetVerts(newVerts);
+  newVerts->FastDelete();
 
   if (this->GenerateTriangleOutput)
   {
     // Add triangles according to the validPoints; all 3 points making up a
-    // triangle must be valid
-    vtkCellArray* newPolys = vtkCellArray::New();
-    int numberOfRowsMinus1 = extents[3] - extents[2];
-    int numberOfColumnsMinus1 = extents[1] - extents[0];
-    newPolys->Allocate(2 * 4 * numberOfRowsMinus1 * numberOfColumnsMinus1);
-    outputUnprojectedPolys->SetPolys(newPolys);
-    newPolys->FastDelete();
-
-    // Setup pointers to two first rows of validPoints
-    vtkIdType* thisRow = validPoints;
-    vtkIdType* nextRow = validPoints + (numberOfColumnsMinus1 + 1);
-    vtkIdType triIds[3];
-    for (int i = 0; i < numberOfRowsMinus1; ++i, ++thisRow, ++nextRow)
-    {
-      for (int j = 0; j < numberOfColumnsMinus1; ++j, ++thisRow, ++nextRow)
+    // triangle must be valid.  As with vertices, triangles are counted per
+    // row of quads, then written at offsets given by a prefix sum.
+    auto const quadRows = rows - 1;
+    auto const quadColumns = columns - 1;
+
+    std::vector<vtkIdType> triOffsets(static_cast<size_t>(rows), 0);
+    auto countTris = [&](vtkIdType begin, vtkIdType end){
+      for (auto i = begin; i < end; ++i)
       {
-        // if all 4 points for this quad are valid, add two triangles; if 3 valid
-        // points add a single triangle, otherwise add no triangles
-        if (*thisRow != -1 && *(thisRow + 1) != -1 &&
-          *nextRow != -1 && *(nextRow + 1) != -1)
-        {
-          triIds[0] = *thisRow;
-          triIds[1] = *(thisRow + 1);
-          triIds[2] = *(nextRow + 1);
-          newPolys->InsertNextCell(3, triIds);
-          triIds[1] = triIds[2];
-          triIds[2] = *nextRow;
-          newPolys->InsertNextCell(3, triIds);
-        }
-        else if (*thisRow != -1 && *(thisRow + 1) != -1 && *nextRow != -1)
-        {
-          triIds[0] = *thisRow;
-          triIds[1] = *(thisRow + 1);
-          triIds[2] = *nextRow;
-          newPolys->InsertNextCell(3, triIds);
-        }
-        else if (*thisRow != -1 && *(thisRow + 1) != -1 && *(nextRow + 1) != -1)
-        {
-          triIds[0] = *thisRow;
-          triIds[1] = *(thisRow + 1);
-          triIds[2] = *(nextRow + 1);
-          newPolys->InsertNextCell(3, triIds);
-        }
-        else if (*thisRow != -1 && *nextRow != -1 && *(nextRow + 1) != -1)
+        auto const* const thisRow = validPoints + (i * columns);
+        auto const* const nextRow = thisRow + columns;
+
+        vtkIdType count = 0;
+        for (vtkIdType j = 0; j < quadColumns; ++j)
         {
-          triIds[0] = *thisRow;
-          triIds[1] = *(nextRow + 1);
-          triIds[2] = *nextRow;
-          newPolys->InsertNextCell(3, triIds);
+          count += quadTriangles(thisRow[j], thisRow[j + 1],
+                                 nextRow[j], nextRow[j + 1]);
         }
-        else if (*(thisRow + 1) != -1 && *nextRow != -1 && *(nextRow + 1) != -1)
+        triOffsets[i + 1] = count;
+      }
+    };
+    vtkSMPTools::For(0, quadRows, countTris);
+    std::partial_sum(triOffsets.begin(), triOffsets.end(),
+                     triOffsets.begin());
+
+    auto const numberOfTris = triOffsets.back();
+    auto triIds = vtkSmartPointer<vtkIdTypeArray>::New();
+    triIds->SetNumberOfValues(4 * numberOfTris);
+    auto* const triIdsPtr = triIds->GetPointer(0);
+
+    auto fillTris = [&](vtkIdType begin, vtkIdType end){
+      for (auto i = begin; i < end; ++i)
+      {
+        auto* out = triIdsPtr + (4 * triOffsets[i]);
+        auto addTriangle = [&out](vtkIdType a, vtkIdType b, vtkIdType c){
+          *(out++) = 3;
+          *(out++) = a;
+          *(out++) = b;
+          *(out++) = c;
+        };
+
+        for (vtkIdType j = 0; j < quadColumns; ++j)
         {
-          triIds[0] = *(thisRow + 1);
-          triIds[1] = *(nextRow + 1);
-          triIds[2] = *nextRow;
-          newPolys->InsertNextCell(3, triIds);
+          auto const p00 = (i * columns) + j;
+          auto const p01 = p00 + 1;
+          auto const p10 = p00 + columns;
+          auto const p11 = p10 + 1;
+
+          auto const v00 = validPoints[p00] != 0;
+          auto const v01 = validPoints[p01] != 0;
+          auto const v10 = validPoints[p10] != 0;
+          auto const v11 = validPoints[p11] != 0;
+
+          // if all 4 points for this quad are valid, add two triangles; if 3
+          // valid points add a single triangle, otherwise add no triangles
+          if (v00 && v01 && v10 && v11)
+          {
+            addTriangle(p00, p01, p11);
+            addTriangle(p00, p11, p10);
+          }
+          else if (v00 && v01 && v10)
+          {
+            addTriangle(p00, p01, p10);
+          }
+          else if (v00 && v01 && v11)
+          {
+            addTriangle(p00, p01, p11);
+          }
+          else if (v00 && v10 && v11)
+          {
+            addTriangle(p00, p11, p10);
+          }
+          else if (v01 && v10 && v11)
+          {
+            addTriangle(p01, p11, p10);
+          }
         }
       }
-    }
+    };
+    vtkSMPTools::For(0, quadRows, fillTris);
+
+    vtkCellArray* newPolys = vtkCellArray::New();
+    newPolys->SetCells(numberOfTris, triIds);
+    outputUnprojectedPolys->SetPolys(newPolys);
+    newPolys->FastDelete();
   }
   else
   {
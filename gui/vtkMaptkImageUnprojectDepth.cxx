@@ -31,16 +31,91 @@
 
 #include "vtkMaptkCamera.h"
 
-#include <vtkDoubleArray.h>
+#include <vtkDataArray.h>
 #include <vtkFloatArray.h>
 #include <vtkImageData.h>
 #include <vtkObjectFactory.h>
 #include <vtkPointData.h>
+#include <vtkSMPTools.h>
 
 vtkStandardNewMacro(vtkMaptkImageUnprojectDepth);
 
 vtkCxxSetObjectMacro(vtkMaptkImageUnprojectDepth, Camera, vtkMaptkCamera);
 
+namespace // anonymous
+{
+
+//-----------------------------------------------------------------------------
+// Parameters for unprojecting image rows.  For pixel (u, v) at depth d, the world
+// point is d * M * [u, v, 1] + C, where M = R^T * K^-1 and C = -R^T * t.
+// Since v is constant along a row, and u is linear in the column, the ray
+// direction along a row reduces to a + c * b for column c, which leaves a
+// multiply-add per component in the inner loop.
+struct UnprojectParameters
+{
+  float* Points;
+  vtkIdType Columns;
+
+  // Pixel coordinates of column 0 of row 0, and their increments
+  double U0, DU;
+  double V0, DV;
+
+  Eigen::Matrix3d M;
+  Eigen::Vector3d C;
+};
+
+//-----------------------------------------------------------------------------
+template <typename T>
+class UnprojectRows : protected UnprojectParameters
+{
+public:
+  UnprojectRows(UnprojectParameters const& parameters, T const* depths)
+    : UnprojectParameters(parameters), Depths(depths) {}
+
+  void operator()(vtkIdType begin, vtkIdType end) const
+  {
+    auto const cx = static_cast<float>(this->C[0]);
+    auto const cy = static_cast<float>(this->C[1]);
+    auto const cz = static_cast<float>(this->C[2]);
+
+    for (auto row = begin; row < end; ++row)
+    {
+      auto const v = this->V0 + (static_cast<double>(row) * this->DV);
+      auto const* const depths = this->Depths + (row * this->Columns);
+      auto* const points = this->Points + (3 * row * this->Columns);
+
+      Eigen::Vector3d const a =
+        this->M * Eigen::Vector3d{this->U0, v, 1.0};
+      Eigen::Vector3d const b = this->M.col(0) * this->DU;
+
+      auto const ax = static_cast<float>(a[0]);
+      auto const ay = static_cast<float>(a[1]);
+      auto const az = static_cast<float>(a[2]);
+      auto const bx = static_cast<float>(b[0]);
+      auto const by = static_cast<float>(b[1]);
+      auto const bz = static_cast<float>(b[2]);
+
+      // Use a 32-bit index, as 64-bit integer to float conversion does not
+      // vectorize on most targets
+      auto const columns = static_cast<int>(this->Columns);
+      for (int column = 0; column < columns; ++column)
+      {
+        auto const c = static_cast<float>(column);
+        auto const d = static_cast<float>(depths[column]);
+
+        points[(3 * column) + 0] = (d * (ax + (c * bx))) + cx;
+        points[(3 * column) + 1] = (d * (ay + (c * by))) + cy;
+        points[(3 * column) + 2] = (d * (az + (c * bz))) + cz;
+      }
+    }
+  }
+
+protected:
+  T const* Depths;
+};
+
+} // namespace <anonymous>
+
 //-----------------------------------------------------------------------------
 vtkMaptkImageUnprojectDepth::vtkMaptkImageUnprojectDepth()
 {
@@ -74,12 +149,14 @@ void vtkMaptkImageUnprojectDepth::SimpleExecute(vtkImageData* input,
     return;
   }
 
-  vtkDoubleArray* depths = vtkDoubleArray::SafeDownCast(
-    output->GetPointData()->GetArray(this->DepthArrayName));
-  if (!depths || depths->GetNumberOfComponents() != 1)
+  vtkDataArray* depths =
+    output->GetPointData()->GetArray(this->DepthArrayName);
+  if (!depths || depths->GetNumberOfComponents() != 1 ||
+      (depths->GetDataType() != VTK_DOUBLE &&
+       depths->GetDataType() != VTK_FLOAT))
   {
     vtkErrorMacro(<< "Specified input depth array is not present or is not " <<
-      "a scalar DoubleArray as expected!");
+      "a scalar DoubleArray or FloatArray as expected!");
     return;
   }
 
@@ -101,7 +178,8 @@ void vtkMaptkImageUnprojectDepth::SimpleExecute(vtkImageData* input,
   auto const imageRatio =
     static_cast<double>(input->GetDimensions()[0]) /
     static_cast<double>(this->Camera->GetImageDimensions()[0]);
-  auto const scaledCamera = this->Camera->ScaledK(imageRatio);
+  auto const scaledCamera = this->Camera->ScaledK(imageRatio)->GetCamera();
+  auto const& intrinsics = scaledCamera->intrinsics();
 
   vtkDataArray* inputPoints = output->GetPointData()->GetArray(
     this->UnprojectedPointArrayName);
@@ -124,22 +202,34 @@ void vtkMaptkImageUnprojectDepth::SimpleExecute(vtkImageData* input,
   output->GetPointData()->AddArray(points);
   points->FastDelete();
 
-  // loop over each point / depth in the image, computing the unprojected point
-  double* depthPtr = depths->GetPointer(0);
-  float* pointsPtr = points->GetPointer(0);
-  double pixel[2];
-  for (int row = extents[2]; row <= extents[3]; ++row)
+  // Precompute the camera transform once; rows are then unprojected in
+  // parallel
+  Eigen::Matrix3d const Rt =
+    scaledCamera->rotation().matrix().transpose();
+  Eigen::Vector3d const C = -(Rt * scaledCamera->translation());
+
+  UnprojectParameters parameters;
+  parameters.Points = points->GetPointer(0);
+  parameters.Columns = extents[1] - extents[0] + 1;
+  parameters.U0 = origin[0] + extents[0] * spacing[0];
+  parameters.DU = spacing[0];
+  parameters.V0 = height - 1 - (origin[1] + extents[2] * spacing[1]);
+  parameters.DV = -spacing[1];
+  parameters.C = C;
+  parameters.M = Rt * intrinsics->as_matrix().inverse();
+
+  auto const rows = static_cast<vtkIdType>(extents[3] - extents[2] + 1);
+  auto* const depthData = depths->GetVoidPointer(0);
+  if (depths->GetDataType() == VTK_FLOAT)
   {
-    pixel[1] = height - 1 - (origin[1] + row * spacing[1]);
-    for (int column = extents[0]; column <= extents[1]; ++column, ++depthPtr)
-    {
-      pixel[0] = origin[0] + column * spacing[0];
-
-      auto const p = scaledCamera->UnprojectPoint(pixel, *depthPtr);
-      *pointsPtr = p[0];
-      *(++pointsPtr) = p[1];
-      *(++pointsPtr) = p[2];
-      ++pointsPtr;
-    }
+    UnprojectRows<float> functor(
+      parameters, static_cast<float const*>(depthData));
+    vtkSMPTools::For(0, rows, functor);
+  }
+  else
+  {
+    UnprojectRows<double> functor(
+      parameters, static_cast<double const*>(depthData));
+    vtkSMPTools::For(0, rows, functor);
   }
 }
@@ -36,6 +36,10 @@
 #include <qtGradient.h>
 #include <qtIndexRange.h>
 
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
 vtkStandardNewMacro(vtkMaptkScalarsToGradient);
 
 QTE_IMPLEMENT_D_FUNC(vtkMaptkScalarsToGradient)
@@ -47,24 +51,41 @@ QTE_IMPLEMENT_D_FUNC(vtkMaptkScalarsToGradient)
 namespace // anonymous
 {
 
-typedef double (*GetValue)(void const*, int);
+// Number of values processed per pass of the mapping loops; the first pass
+// over each block only converts and rescales, so that it can be vectorized
+int const BlockSize = 256;
 
 //-----------------------------------------------------------------------------
 template <typename T>
-double getValue(void const* data, int offset)
+void mapScalars(
+  T const* input, int inputIncrement, int numberOfValues,
+  double lower, float scale, float maxIndex,
+  unsigned char const* table, unsigned char* output, int outputComponents)
 {
-  auto const realData = static_cast<T const*>(data);
-  return static_cast<double>(realData[offset]);
-}
+  float k[BlockSize];
 
-//-----------------------------------------------------------------------------
-GetValue typedGetValue(int type)
-{
-  switch (type)
+  for (int block = 0; block < numberOfValues; block += BlockSize)
   {
-    vtkTemplateAliasMacro(return &getValue<VTK_TT>);
-    default:
-      return 0;
+    auto const n = std::min(BlockSize, numberOfValues - block);
+    auto const in = input + (block * inputIncrement);
+    auto const out = output + (block * outputComponents);
+
+    // Map values to (fractional) table indices; the lower bound is removed
+    // in double precision so that values far from zero relative to the range
+    // width do not lose table resolution
+    for (int i = 0; i < n; ++i)
+    {
+      auto const v = static_cast<double>(in[i * inputIncrement]) - lower;
+      k[i] = static_cast<float>(v) * scale;
+    }
+
+    // Look up colors; written so that NaN maps to the start of the table
+    for (int i = 0; i < n; ++i)
+    {
+      auto const a = std::min(maxIndex, std::max(0.0f, k[i]));
+      auto const c = table + (4 * static_cast<int>(a + 0.5f));
+      std::memcpy(out + (i * outputComponents), c, outputComponents);
+    }
   }
 }
 
@@ -74,12 +95,36 @@ GetValue typedGetValue(int type)
 class vtkMaptkScalarsToGradientPrivate
 {
 public:
+  void updateTable();
+
   double lower;
   double scale;
 
   qtGradient gradient;
+
+  // Gradient sampled at regular intervals over the range, as RGBA
+  int tableSize;
+  std::vector<unsigned char> table;
 };
 
+//-----------------------------------------------------------------------------
+void vtkMaptkScalarsToGradientPrivate::updateTable()
+{
+  this->table.resize(4 * static_cast<size_t>(this->tableSize));
+
+  auto const step = 1.0 / static_cast<double>(this->tableSize - 1);
+  foreach (auto const i, qtIndexRange(this->tableSize))
+  {
+    auto const c = this->gradient.at(static_cast<double>(i) * step);
+
+    auto const out = this->table.data() + (4 * i);
+    out[0] = static_cast<unsigned char>(c.red());
+    out[1] = static_cast<unsigned char>(c.green());
+    out[2] = static_cast<unsigned char>(c.blue());
+    out[3] = static_cast<unsigned char>(c.alpha());
+  }
+}
+
 //-----------------------------------------------------------------------------
 vtkMaptkScalarsToGradient::vtkMaptkScalarsToGradient()
   : d_ptr(new vtkMaptkScalarsToGradientPrivate)
@@ -87,6 +132,8 @@ vtkMaptkScalarsToGradient::vtkMaptkScalarsToGradient()
   QTE_D();
   d->lower = 0.0;
   d->scale = 1.0;
+  d->tableSize = 4096;
+  d->updateTable();
 
   this->vtkScalarsToColors::SetRange(0.0, 1.0);
 }
@@ -103,10 +150,33 @@ void vtkMaptkScalarsToGradient::SetGradient(qtGradient const& gradient)
   QTE_D();
 
   d->gradient = gradient;
+  d->updateTable();
 
   this->Modified();
 }
 
+//-----------------------------------------------------------------------------
+void vtkMaptkScalarsToGradient::SetNumberOfTableValues(int count)
+{
+  QTE_D();
+
+  count = std::max(count, 2);
+  if (count != d->tableSize)
+  {
+    d->tableSize = count;
+    d->updateTable();
+
+    this->Modified();
+  }
+}
+
+//-----------------------------------------------------------------------------
+int vtkMaptkScalarsToGradient::GetNumberOfTableValues() const
+{
+  QTE_D();
+  return d->tableSize;
+}
+
 //-----------------------------------------------------------------------------
 void vtkMaptkScalarsToGradient::SetRange(double min, double max)
 {
@@ -138,48 +208,27 @@ void vtkMaptkScalarsToGradient::MapScalarsThroughTable2(
 {
   QTE_D();
 
-  auto const get = typedGetValue(inputDataType);
-  if (!get)
+  if (outputFormat != VTK_RGBA && outputFormat != VTK_RGB)
   {
-    vtkErrorMacro(<< __func__ << ": Unknown input data type");
+    this->vtkScalarsToColors::MapScalarsThroughTable2(
+      input, output, inputDataType, numberOfValues,
+      inputIncrement, outputFormat);
     return;
   }
 
-  switch (outputFormat)
-  {
-    case VTK_RGBA:
-      foreach (auto const i, qtIndexRange(numberOfValues))
-      {
-        auto const value = (*get)(input, i);
-        auto const k = (value - d->lower) * d->scale;
-        auto const c = d->gradient.at(k);
-
-        auto const out = output + (4 * i);
-        out[0] = c.red();
-        out[1] = c.green();
-        out[2] = c.blue();
-        out[3] = c.alpha();
-      }
-      break;
+  // Fold the range and table size into a single scale
+  auto const maxIndex = static_cast<double>(d->tableSize - 1);
+  auto const scale = static_cast<float>(d->scale * maxIndex);
 
-    case VTK_RGB:
-      foreach (auto const i, qtIndexRange(numberOfValues))
-      {
-        auto const value = (*get)(input, i);
-        auto const k = (value - d->lower) * d->scale;
-        auto const c = d->gradient.at(k);
-
-        auto const out = output + (3 * i);
-        out[0] = c.red();
-        out[1] = c.green();
-        out[2] = c.blue();
-      }
-      break;
+  switch (inputDataType)
+  {
+    vtkTemplateAliasMacro(
+      mapScalars(static_cast<VTK_TT const*>(input), inputIncrement,
+                 numberOfValues, d->lower, scale, static_cast<float>(maxIndex),
+                 d->table.data(), output, outputFormat));
 
     default:
-      this->vtkScalarsToColors::MapScalarsThroughTable2(
-        input, output, inputDataType, numberOfValues,
-        inputIncrement, outputFormat);
+      vtkErrorMacro(<< __func__ << ": Unknown input data type");
       break;
   }
 }
@@ -47,6 +47,11 @@ public:
 
   void SetGradient(qtGradient const&);
 
+  // Set the number of entries in the table used to map scalars to colors
+  // (default 4096)
+  void SetNumberOfTableValues(int);
+  int GetNumberOfTableValues() const;
+
   virtual void SetRange(double min, double max);
 
   virtual void GetColor(double v, double rgb[3]);
@@ -0,0 +1,201 @@
+/*ckwg +29
+ * Copyright 2017 by Kitware, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ *  * Neither name of Kitware, Inc. nor the names of any contributors may be used
+ *    to endorse or promote products derived from this software without specific
+ *    prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * \brief Implementation of the asynchronous output sink
+ */
+
+#include "async_output_sink.h"
+
+#include <vital/logger/logger.h>
+#include <vital/util/thread_pool.h>
+
+#include <kwiversys/SystemTools.hxx>
+
+#include <algorithm>
+#include <deque>
+#include <exception>
+#include <future>
+#include <vector>
+
+
+namespace kwiver {
+namespace maptk {
+
+
+/// Private implementation class
+class async_output_sink::priv
+{
+public:
+  priv(size_t bs)
+    : batch_size(std::max<size_t>(bs, 1)),
+      max_in_flight(std::max<size_t>(vital::thread_pool::instance().num_threads() * 2, 2))
+  {
+  }
+
+  /// Send the current batch to the thread pool
+  void dispatch()
+  {
+    if (batch.empty())
+    {
+      return;
+    }
+    auto jobs = std::make_shared<std::vector<std::function<void()> > >();
+    jobs->swap(batch);
+    in_flight.push_back(vital::thread_pool::instance().enqueue([jobs]()
+    {
+      // run every job in the batch and report the first failure
+      std::exception_ptr error;
+      for (auto const& job : *jobs)
+      {
+        try
+        {
+          job();
+        }
+        catch (...)
+        {
+          if (!error)
+          {
+            error = std::current_exception();
+          }
+        }
+      }
+      if (error)
+      {
+        std::rethrow_exception(error);
+      }
+    }));
+  }
+
+  /// Wait for the oldest batch in flight and record any error
+  void finish_oldest()
+  {
+    try
+    {
+      in_flight.front().get();
+    }
+    catch (...)
+    {
+      if (!error)
+      {
+        error = std::current_exception();
+      }
+    }
+    in_flight.pop_front();
+  }
+
+  size_t batch_size;
+  size_t max_in_flight;
+  std::vector<std::function<void()> > batch;
+  std::deque<std::future<void> > in_flight;
+  std::exception_ptr error;
+};
+
+
+/// Constructor
+async_output_sink
+::async_output_sink(size_t batch_size)
+  : d_(new priv(batch_size))
+{
+}
+
+
+/// Destructor
+async_output_sink
+::~async_output_sink()
+{
+  try
+  {
+    this->wait();
+  }
+  catch (std::exception const& e)
+  {
+    vital::logger_handle_t logger( vital::get_logger( "async_output_sink" ) );
+    LOG_ERROR(logger, "Failed to write output: " << e.what());
+  }
+  catch (...)
+  {
+    vital::logger_handle_t logger( vital::get_logger( "async_output_sink" ) );
+    LOG_ERROR(logger, "Failed to write output");
+  }
+}
+
+
+/// Queue a job to run on the thread pool
+void
+async_output_sink
+::add(std::function<void()> job)
+{
+  d_->batch.push_back(std::move(job));
+  if (d_->batch.size() >= d_->batch_size)
+  {
+    while (d_->in_flight.size() >= d_->max_in_flight)
+    {
+      d_->finish_oldest();
+    }
+    d_->dispatch();
+  }
+}
+
+
+/// Queue the removal of a file
+void
+async_output_sink
+::remove_file(vital::path_t const& file_path)
+{
+  this->add([file_path]()
+  {
+    kwiversys::SystemTools::RemoveFile(file_path);
+  });
+}
+
+
+/// Run all queued jobs and wait for them to finish
+void
+async_output_sink
+::wait()
+{
+  d_->dispatch();
+  while (!d_->in_flight.empty())
+  {
+    d_->finish_oldest();
+  }
+  if (d_->error)
+  {
+    std::exception_ptr error = d_->error;
+    d_->error = nullptr;
+    std::rethrow_exception(error);
+  }
+}
+
+
+} // end namespace maptk
+} // end namespace kwiver
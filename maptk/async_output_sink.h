@@ -0,0 +1,98 @@
+/*ckwg +29
+ * Copyright 2017 by Kitware, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ *  * Neither name of Kitware, Inc. nor the names of any contributors may be used
+ *    to endorse or promote products derived from this software without specific
+ *    prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * \brief Header for a sink that writes many small output files in parallel
+ */
+
+#ifndef MAPTK_ASYNC_OUTPUT_SINK_H_
+#define MAPTK_ASYNC_OUTPUT_SINK_H_
+
+#include <maptk/maptk_export.h>
+
+#include <vital/vital_types.h>
+
+#include <functional>
+#include <memory>
+
+
+namespace kwiver {
+namespace maptk {
+
+/// Runs file output jobs in batches on the vital thread pool
+/**
+ * Writing thousands of small files one at a time is dominated by file
+ * creation latency, especially on network file systems.  This class collects
+ * output jobs into batches and runs each batch as one task on the thread
+ * pool, keeping a bounded number of batches in flight so that the caller
+ * does not queue the entire output at once.
+ *
+ * Jobs must be independent of each other.  The first exception thrown by a
+ * job is rethrown from wait().
+ */
+class MAPTK_EXPORT async_output_sink
+{
+public:
+  /// Constructor
+  /**
+   * \param batch_size the number of jobs to run together in one task
+   */
+  explicit async_output_sink(size_t batch_size = 32);
+
+  /// Destructor
+  /**
+   * Waits for all queued jobs to finish.  Errors not already reported by
+   * wait() are logged.
+   */
+  ~async_output_sink();
+
+  /// Queue a job to run on the thread pool
+  void add(std::function<void()> job);
+
+  /// Queue the removal of a file
+  void remove_file(vital::path_t const& file_path);
+
+  /// Run all queued jobs and wait for them to finish
+  /**
+   * \throws the first exception thrown by any job since the last call
+   */
+  void wait();
+
+private:
+  class priv;
+  const std::unique_ptr<priv> d_;
+};
+
+
+} // end namespace maptk
+} // end namespace kwiver
+
+#endif // MAPTK_ASYNC_OUTPUT_SINK_H_
@@ -0,0 +1,589 @@
+/*ckwg +29
+ * Copyright 2017 by Kitware, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ *  * Neither name of Kitware, Inc. nor the names of any contributors may be used
+ *    to endorse or promote products derived from this software without specific
+ *    prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * \brief Implementation of maptk camera I/O
+ */
+
+#include "camera_io.h"
+
+#include <vital/exceptions.h>
+#include <vital/io/camera_io.h>
+#include <vital/logger/logger.h>
+#include <vital/util/thread_pool.h>
+
+#include <kwiversys/Directory.hxx>
+#include <kwiversys/SystemTools.hxx>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <future>
+#include <iomanip>
+#include <set>
+#include <sstream>
+#include <vector>
+
+
+namespace kwiver {
+namespace maptk {
+
+namespace {
+
+/// First line of every camera archive
+const char archive_header[] = "# maptk camera archive v1";
+
+/// Signature at the start of every binary camera cache
+const char cache_magic[8] = { 'M', 'A', 'P', 'T', 'K', 'C', 'C', '\n' };
+
+/// Current version of the binary camera cache format
+const uint32_t cache_version = 3;
+
+/// Resolution (in seconds) of file modification times, with some margin
+/**
+ * A KRTD file modified within this long before the cache was written may have
+ * been rewritten again with the same size and modification time, so its
+ * cache entry is not trusted.
+ */
+const int64_t mtime_resolution = 2;
+
+
+/// A camera along with the state of the KRTD file it was read from
+struct cached_camera
+{
+  int64_t mtime = 0;
+  uint64_t size = 0;
+  vital::camera_sptr camera;
+};
+
+
+/// Write a plain value to a binary stream
+template <typename T>
+void
+write_value(std::ostream& os, T const& value)
+{
+  os.write(reinterpret_cast<char const*>(&value), sizeof(T));
+}
+
+
+/// Read a plain value from a binary stream
+template <typename T>
+bool
+read_value(std::istream& is, T& value)
+{
+  return static_cast<bool>(
+    is.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+
+/// Read the binary camera cache of a directory
+/**
+ * Returns an empty map if the cache is missing or invalid, or if it was
+ * written for a directory other than \p krtd_dir.  The time at which the
+ * cache was written is returned in \p write_time.
+ */
+std::map<std::string, cached_camera>
+read_camera_cache(vital::path_t const& cache_file,
+                  vital::path_t const& krtd_dir, int64_t& write_time)
+{
+  std::map<std::string, cached_camera> cache;
+  std::ifstream ifs(cache_file.c_str(), std::ios::in | std::ios::binary);
+  char magic[sizeof(cache_magic)];
+  uint32_t version = 0, dir_len = 0;
+  uint64_t count = 0;
+  if (!ifs || !ifs.read(magic, sizeof(magic)) ||
+      std::memcmp(magic, cache_magic, sizeof(magic)) != 0 ||
+      !read_value(ifs, version) || version != cache_version ||
+      !read_value(ifs, dir_len) || dir_len != krtd_dir.size())
+  {
+    return cache;
+  }
+  std::string dir(dir_len, '\0');
+  if (!ifs.read(&dir[0], dir_len) || dir != krtd_dir ||
+      !read_value(ifs, write_time) || !read_value(ifs, count))
+  {
+    return cache;
+  }
+
+  for (uint64_t i = 0; i < count; ++i)
+  {
+    uint32_t name_len = 0, num_dist = 0;
+    cached_camera entry;
+    double intr[5], quat[4], center[3];
+    if (!read_value(ifs, name_len))
+    {
+      return std::map<std::string, cached_camera>();
+    }
+    std::string name(name_len, '\0');
+    if (!ifs.read(&name[0], name_len) ||
+        !read_value(ifs, entry.mtime) || !read_value(ifs, entry.size) ||
+        !ifs.read(reinterpret_cast<char*>(intr), sizeof(intr)) ||
+        !ifs.read(reinterpret_cast<char*>(quat), sizeof(quat)) ||
+        !ifs.read(reinterpret_cast<char*>(center), sizeof(center)) ||
+        !read_value(ifs, num_dist))
+    {
+      return std::map<std::string, cached_camera>();
+    }
+    Eigen::VectorXd dist(num_dist);
+    if (num_dist > 0 &&
+        !ifs.read(reinterpret_cast<char*>(dist.data()), num_dist * sizeof(double)))
+    {
+      return std::map<std::string, cached_camera>();
+    }
+
+    vital::simple_camera_intrinsics K(intr[0], vital::vector_2d(intr[1], intr[2]),
+                                      intr[3], intr[4], dist);
+    Eigen::Quaterniond q(quat[3], quat[0], quat[1], quat[2]);
+    entry.camera = std::make_shared<vital::simple_camera>(
+      vital::vector_3d(center[0], center[1], center[2]), vital::rotation_d(q), K);
+    cache[name] = entry;
+  }
+  return cache;
+}
+
+
+/// Write the binary camera cache of a directory
+/**
+ * \p write_time must be no later than the time at which the files were
+ * examined for the entries in \p cache.
+ */
+void
+write_camera_cache(vital::path_t const& cache_file,
+                   vital::path_t const& krtd_dir,
+                   std::map<std::string, cached_camera> const& cache,
+                   int64_t write_time)
+{
+  // write to a temporary file and rename so readers never see a partial file
+  vital::path_t const tmp_file = cache_file + ".tmp";
+  {
+    std::ofstream ofs(tmp_file.c_str(), std::ios::out | std::ios::binary);
+    if (!ofs)
+    {
+      throw vital::file_write_exception(tmp_file, "Could not open file");
+    }
+    ofs.write(cache_magic, sizeof(cache_magic));
+    write_value(ofs, cache_version);
+    write_value(ofs, static_cast<uint32_t>(krtd_dir.size()));
+    ofs.write(krtd_dir.data(), krtd_dir.size());
+    write_value(ofs, write_time);
+    write_value(ofs, static_cast<uint64_t>(cache.size()));
+    for (auto const& p : cache)
+    {
+      auto const& cam = *p.second.camera;
+      auto const K = cam.intrinsics();
+      auto const pp = K->principal_point();
+      auto const dist = K->dist_coeffs();
+      auto const q = cam.rotation().quaternion();
+      auto const c = cam.center();
+      double const intr[5] = { K->focal_length(), pp.x(), pp.y(),
+                               K->aspect_ratio(), K->skew() };
+      double const quat[4] = { q.x(), q.y(), q.z(), q.w() };
+      double const center[3] = { c.x(), c.y(), c.z() };
+
+      write_value(ofs, static_cast<uint32_t>(p.first.size()));
+      ofs.write(p.first.data(), p.first.size());
+      write_value(ofs, p.second.mtime);
+      write_value(ofs, p.second.size);
+      ofs.write(reinterpret_cast<char const*>(intr), sizeof(intr));
+      ofs.write(reinterpret_cast<char const*>(quat), sizeof(quat));
+      ofs.write(reinterpret_cast<char const*>(center), sizeof(center));
+      write_value(ofs, static_cast<uint32_t>(dist.size()));
+      ofs.write(reinterpret_cast<char const*>(dist.data()),
+                dist.size() * sizeof(double));
+    }
+    if (!ofs)
+    {
+      throw vital::file_write_exception(tmp_file, "Failed writing file");
+    }
+  }
+  kwiversys::SystemTools::RemoveFile(cache_file);
+  if (!kwiversys::SystemTools::RenameFile(tmp_file, cache_file))
+  {
+    kwiversys::SystemTools::RemoveFile(tmp_file);
+    throw vital::file_write_exception(cache_file, "Could not rename file");
+  }
+}
+
+
+/// Run a function over blocks of a range in parallel on the thread pool
+template <typename Func>
+void
+parallel_for_blocks(size_t num, Func const& func)
+{
+  static const size_t min_block_size = 64;
+  auto& pool = vital::thread_pool::instance();
+  size_t const num_blocks = std::min(num / min_block_size + 1,
+                                     pool.num_threads() * 4 + 1);
+  if (num_blocks <= 1)
+  {
+    func(0, num);
+    return;
+  }
+  size_t const block_size = (num + num_blocks - 1) / num_blocks;
+  std::vector<std::future<void> > jobs;
+  for (size_t begin = 0; begin < num; begin += block_size)
+  {
+    size_t const end = std::min(begin + block_size, num);
+    jobs.push_back(pool.enqueue([&func, begin, end]() { func(begin, end); }));
+  }
+  for (auto& j : jobs)
+  {
+    j.get();
+  }
+}
+
+} // end anonymous namespace
+
+
+/// Write a set of cameras to a single packed camera archive file
+void
+write_camera_archive(std::map<std::string, vital::camera_sptr> const& cameras,
+                     vital::path_t const& file_path)
+{
+  std::vector<std::pair<std::string, vital::camera_sptr> > entries;
+  entries.reserve(cameras.size());
+  for (auto const& p : cameras)
+  {
+    if (p.second)
+    {
+      entries.push_back(p);
+    }
+  }
+
+  // format the KRTD text of each camera in parallel
+  std::vector<std::string> blobs(entries.size());
+  parallel_for_blocks(entries.size(), [&](size_t begin, size_t end)
+  {
+    for (size_t i = begin; i < end; ++i)
+    {
+      std::ostringstream ss;
+      ss << std::setprecision(15) << *entries[i].second;
+      blobs[i] = ss.str();
+    }
+  });
+
+  // Ensure that the parent directory exists
+  vital::path_t parent_dir = kwiversys::SystemTools::GetFilenamePath(
+    kwiversys::SystemTools::CollapseFullPath(file_path));
+  if (!kwiversys::SystemTools::FileIsDirectory(parent_dir))
+  {
+    if (!kwiversys::SystemTools::MakeDirectory(parent_dir))
+    {
+      throw vital::file_write_exception(parent_dir,
+        "Attempted directory creation, but no directory created!");
+    }
+  }
+
+  std::ofstream ofs(file_path.c_str(), std::ios::out | std::ios::binary);
+  if (!ofs)
+  {
+    throw vital::file_write_exception(file_path,
+                                      "Could not open camera archive");
+  }
+
+  // header and index: "offset length name", offsets relative to the data
+  ofs << archive_header << "\n" << entries.size() << "\n";
+  size_t offset = 0;
+  for (size_t i = 0; i < entries.size(); ++i)
+  {
+    ofs << offset << " " << blobs[i].size() << " " << entries[i].first << "\n";
+    offset += blobs[i].size();
+  }
+  for (auto const& b : blobs)
+  {
+    ofs.write(b.data(), b.size());
+  }
+  if (!ofs)
+  {
+    throw vital::file_write_exception(file_path,
+                                      "Failed writing camera archive");
+  }
+}
+
+
+/// Read all cameras from a packed camera archive file
+std::map<std::string, vital::camera_sptr>
+read_camera_archive(vital::path_t const& file_path)
+{
+  std::ifstream ifs(file_path.c_str(), std::ios::in | std::ios::binary);
+  if (!ifs)
+  {
+    throw vital::file_not_found_exception(file_path,
+                                          "Could not open camera archive");
+  }
+
+  std::string line;
+  size_t num_cameras = 0;
+  if (!std::getline(ifs, line) || line != archive_header ||
+      !std::getline(ifs, line) || !(std::istringstream(line) >> num_cameras))
+  {
+    throw vital::invalid_file(file_path, "Not a camera archive");
+  }
+
+  // the index is untrusted, so bound it by the size of the file before
+  // allocating anything based on it
+  std::streamoff const index_start = ifs.tellg();
+  ifs.seekg(0, std::ios::end);
+  size_t const file_size = static_cast<size_t>(ifs.tellg());
+  ifs.seekg(index_start);
+  if (num_cameras > file_size)
+  {
+    throw vital::invalid_file(file_path, "Corrupt camera archive index");
+  }
+
+  struct entry_t
+  {
+    std::string name;
+    size_t offset;
+    size_t length;
+  };
+  std::vector<entry_t> entries(num_cameras);
+  for (auto& e : entries)
+  {
+    std::getline(ifs, line);
+    std::istringstream ss(line);
+    if (!(ss >> e.offset >> e.length) || ss.get() != ' ')
+    {
+      throw vital::invalid_file(file_path, "Corrupt camera archive index");
+    }
+    std::getline(ss, e.name);
+  }
+
+  // every entry must lie within the data following the index
+  std::streamoff const data_start = ifs.tellg();
+  if (data_start < 0)
+  {
+    throw vital::invalid_file(file_path, "Camera archive is truncated");
+  }
+  size_t const available = file_size - static_cast<size_t>(data_start);
+  size_t data_size = 0;
+  for (auto const& e : entries)
+  {
+    if (e.offset > available || e.length > available - e.offset)
+    {
+      throw vital::invalid_file(file_path, "Camera archive is truncated");
+    }
+    data_size = std::max(data_size, e.offset + e.length);
+  }
+
+  std::string data(data_size, '\0');
+  if (!ifs.read(&data[0], data_size))
+  {
+    throw vital::invalid_file(file_path, "Camera archive is truncated");
+  }
+
+  // parse the KRTD text of each camera in parallel; a camera that fails to
+  // parse is left null and reported after all jobs have finished
+  std::vector<vital::camera_sptr> cams(entries.size());
+  parallel_for_blocks(entries.size(), [&](size_t begin, size_t end)
+  {
+    for (size_t i = begin; i < end; ++i)
+    {
+      std::istringstream ss(data.substr(entries[i].offset, entries[i].length));
+      auto cam = std::make_shared<vital::simple_camera>();
+      if (ss >> *cam)
+      {
+        cams[i] = cam;
+      }
+    }
+  });
+  for (size_t i = 0; i < entries.size(); ++i)
+  {
+    if (!cams[i])
+    {
+      throw vital::invalid_file(file_path, "Could not parse camera \""
+                                + entries[i].name + "\" in camera archive");
+    }
+  }
+
+  std::map<std::string, vital::camera_sptr> cameras;
+  for (size_t i = 0; i < entries.size(); ++i)
+  {
+    cameras[entries[i].name] = cams[i];
+  }
+  return cameras;
+}
+
+
+/// Read the KRTD cameras with the given names from a directory
+std::map<std::string, vital::camera_sptr>
+read_krtd_directory(vital::path_t const& krtd_dir,
+                    std::vector<std::string> const& names,
+                    vital::path_t const& cache_file)
+{
+  typedef kwiversys::SystemTools ST;
+  vital::logger_handle_t logger( vital::get_logger( "read_krtd_directory" ) );
+
+  // list the directory once instead of testing for each file
+  std::set<std::string> available;
+  kwiversys::Directory dir;
+  if (dir.Load(krtd_dir))
+  {
+    for (unsigned long i = 0; i < dir.GetNumberOfFiles(); ++i)
+    {
+      std::string const file = dir.GetFile(i);
+      if (ST::GetFilenameLastExtension(file) == ".krtd")
+      {
+        available.insert(ST::GetFilenameWithoutLastExtension(file));
+      }
+    }
+  }
+  else
+  {
+    LOG_WARN(logger, "Could not access directory \"" << krtd_dir << "\"");
+  }
+
+  std::vector<std::string> found;
+  found.reserve(names.size());
+  for (auto const& n : names)
+  {
+    if (available.count(n))
+    {
+      found.push_back(n);
+    }
+  }
+
+  // Modification times only have a resolution of a second, so a file that
+  // was modified just before the cache was written may have been rewritten
+  // since with the same size and modification time.  Only trust entries for
+  // files that were last modified well before the cache was written.
+  int64_t const scan_time = static_cast<int64_t>(std::time(nullptr));
+  bool const use_cache = !cache_file.empty();
+  vital::path_t const cache_dir =
+    use_cache ? ST::CollapseFullPath(krtd_dir) : vital::path_t();
+  int64_t cache_time = 0;
+  std::map<std::string, cached_camera> const old_cache =
+    use_cache ? read_camera_cache(cache_file, cache_dir, cache_time)
+              : std::map<std::string, cached_camera>();
+  auto const trusted = [cache_time](cached_camera const& c)
+  {
+    return c.mtime + mtime_resolution <= cache_time;
+  };
+
+  // stat each file and parse only those not matching the cache
+  std::vector<cached_camera> entries(found.size());
+  std::vector<char> from_cache(found.size(), 0);
+  parallel_for_blocks(found.size(), [&](size_t begin, size_t end)
+  {
+    for (size_t i = begin; i < end; ++i)
+    {
+      vital::path_t const krtd_file = krtd_dir + "/" + found[i] + ".krtd";
+      auto& e = entries[i];
+      e.mtime = static_cast<int64_t>(ST::ModifiedTime(krtd_file));
+      e.size = static_cast<uint64_t>(ST::FileLength(krtd_file));
+
+      auto const c = old_cache.find(found[i]);
+      if (c != old_cache.end() && trusted(c->second) &&
+          c->second.mtime == e.mtime && c->second.size == e.size)
+      {
+        e.camera = c->second.camera;
+        from_cache[i] = 1;
+        continue;
+      }
+      try
+      {
+        e.camera = vital::read_krtd_file(krtd_file);
+      }
+      catch (std::exception const& ex)
+      {
+        LOG_WARN(logger, "Failed to read camera from " << krtd_file
+                         << ": " << ex.what());
+      }
+    }
+  });
+
+  std::map<std::string, vital::camera_sptr> cameras;
+  std::map<std::string, cached_camera> new_cache;
+  size_t num_cached = 0;
+  for (size_t i = 0; i < found.size(); ++i)
+  {
+    if (entries[i].camera)
+    {
+      cameras[found[i]] = entries[i].camera;
+      new_cache[found[i]] = entries[i];
+    }
+    num_cached += from_cache[i];
+  }
+  LOG_DEBUG(logger, "Loaded " << cameras.size() << " cameras from "
+                    << krtd_dir << " (" << num_cached << " from cache)");
+
+  if (!use_cache)
+  {
+    return cameras;
+  }
+
+  // Keep the trusted cache entries of other cameras that still have a file.
+  // They are validated when next requested.  Only rewrite the cache if it
+  // changed.
+  bool changed = num_cached < new_cache.size();
+  for (auto const& p : old_cache)
+  {
+    if (new_cache.count(p.first) == 0)
+    {
+      if (available.count(p.first) && trusted(p.second))
+      {
+        new_cache.insert(p);
+      }
+      else
+      {
+        changed = true;
+      }
+    }
+  }
+  if (changed)
+  {
+    try
+    {
+      write_camera_cache(cache_file, cache_dir, new_cache, scan_time);
+    }
+    catch (std::exception const& ex)
+    {
+      LOG_DEBUG(logger, "Could not write camera cache: " << ex.what());
+    }
+  }
+  return cameras;
+}
+
+
+/// Return true if the file is a packed camera archive
+bool
+is_camera_archive(vital::path_t const& file_path)
+{
+  std::ifstream ifs(file_path.c_str(), std::ios::in | std::ios::binary);
+  std::string line;
+  return ifs && std::getline(ifs, line) && line == archive_header;
+}
+
+
+} // end namespace maptk
+} // end namespace kwiver
@@ -0,0 +1,125 @@
+/*ckwg +29
+ * Copyright 2017 by Kitware, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ *  * Neither name of Kitware, Inc. nor the names of any contributors may be used
+ *    to endorse or promote products derived from this software without specific
+ *    prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * \brief Header for maptk camera I/O, including a packed camera archive
+ */
+
+#ifndef MAPTK_CAMERA_IO_H_
+#define MAPTK_CAMERA_IO_H_
+
+#include <maptk/maptk_export.h>
+
+#include <vital/types/camera.h>
+#include <vital/vital_types.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+
+namespace kwiver {
+namespace maptk {
+
+/// Write a set of cameras to a single packed camera archive file
+/**
+ * A camera archive holds the KRTD text of many cameras in one file, each
+ * stored under a name (typically the image basename that the KRTD file would
+ * have been named after), along with an index of the byte range of each
+ * camera.  This avoids creating one small file per camera.  Null cameras are
+ * skipped.
+ *
+ * \param [in] cameras   map from camera name to camera
+ * \param [in] file_path the path to the file to write
+ * \throws vital::file_write_exception if the file can not be written
+ */
+MAPTK_EXPORT
+void
+write_camera_archive(std::map<std::string, vital::camera_sptr> const& cameras,
+                     vital::path_t const& file_path);
+
+
+/// Read all cameras from a packed camera archive file
+/**
+ * The cameras are parsed in parallel on the vital thread pool.
+ *
+ * \param [in] file_path the path to the file to read
+ * \return a map from camera name to camera
+ * \throws vital::file_not_found_exception if the file can not be opened
+ * \throws vital::invalid_file if the file is not a valid camera archive, or
+ *         if the KRTD text of any camera in it can not be parsed
+ */
+MAPTK_EXPORT
+std::map<std::string, vital::camera_sptr>
+read_camera_archive(vital::path_t const& file_path);
+
+
+/// Read the KRTD cameras with the given names from a directory
+/**
+ * The directory is listed once and the KRTD files that exist are parsed in
+ * parallel on the vital thread pool.  Names without a matching file are
+ * omitted from the result.  A KRTD file that cannot be parsed is logged as a
+ * warning and omitted, rather than raising an exception.
+ *
+ * When \p cache_file is not empty, the parsed cameras are also stored in
+ * that binary cache file along with the directory and the modification time
+ * and size of each KRTD file.  Later calls with the same directory take
+ * cameras from the cache when the file still has the same modification time
+ * and size, and only parse the files that changed.  Because modification
+ * times have a resolution of a second, files modified within a couple of
+ * seconds before the cache was written are always parsed.  The directory
+ * containing the cache file must exist; failure to write the cache is not an
+ * error.
+ *
+ * \param [in] krtd_dir   the directory containing the KRTD files
+ * \param [in] names      the camera names, i.e. KRTD file names without the
+ *                        ".krtd" extension
+ * \param [in] cache_file the binary cache file to read and update, or empty
+ *                        to not use a cache
+ * \return a map from camera name to camera
+ */
+MAPTK_EXPORT
+std::map<std::string, vital::camera_sptr>
+read_krtd_directory(vital::path_t const& krtd_dir,
+                    std::vector<std::string> const& names,
+                    vital::path_t const& cache_file = vital::path_t());
+
+
+/// Return true if the file is a packed camera archive
+MAPTK_EXPORT
+bool
+is_camera_archive(vital::path_t const& file_path);
+
+
+} // end namespace maptk
+} // end namespace kwiver
+
+#endif // MAPTK_CAMERA_IO_H_
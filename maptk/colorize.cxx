@@ -35,29 +35,161 @@
 
 #include "colorize.h"
 
+#include <vital/util/thread_pool.h>
+
+#include <algorithm>
+#include <cmath>
+#include <future>
+#include <vector>
+
 
 namespace kwiver {
 namespace maptk {
 
 
+namespace {
+
+/// Sample colors from an image with pixels of type T
+/**
+ * Work is done in blocks so that the coordinate clamping and weight
+ * computations run as tight loops over contiguous arrays that the compiler
+ * can vectorize, separate from the pixel gathers.
+ *
+ * \param scale factor mapping pixel values to the 8-bit range
+ */
+template <typename T>
+void
+sample_colors(vital::image const& image, double const* locations,
+              size_t num_samples, vital::rgb_color* colors, float scale)
+{
+  size_t const width = image.width();
+  size_t const height = image.height();
+  if (width == 0 || height == 0)
+  {
+    std::fill(colors, colors + num_samples, vital::rgb_color());
+    return;
+  }
+
+  T const* const data = static_cast<T const*>(image.first_pixel());
+  ptrdiff_t const ws = image.w_step();
+  ptrdiff_t const hs = image.h_step();
+  ptrdiff_t const ds = image.d_step();
+  // gray images use the first channel for all three colors
+  ptrdiff_t const c1 = image.depth() > 2 ? ds : 0;
+  ptrdiff_t const c2 = image.depth() > 2 ? 2 * ds : 0;
+  // step to the right and lower neighbors, zero for degenerate images
+  ptrdiff_t const dx = width > 1 ? ws : 0;
+  ptrdiff_t const dy = height > 1 ? hs : 0;
+  float const max_x = static_cast<float>(width - 1);
+  float const max_y = static_cast<float>(height - 1);
+  // largest valid upper-left corner of the 2x2 interpolation window
+  float const max_x0 = static_cast<float>(width > 1 ? width - 2 : 0);
+  float const max_y0 = static_cast<float>(height > 1 ? height - 2 : 0);
+
+  constexpr size_t block_size = 256;
+  float wx[block_size], wy[block_size];
+  ptrdiff_t offset[block_size];
+
+  for (size_t b = 0; b < num_samples; b += block_size)
+  {
+    size_t const n = std::min(block_size, num_samples - b);
+    double const* const loc = locations + 2 * b;
+
+    // clamp locations and compute interpolation weights and offsets
+    for (size_t i = 0; i < n; ++i)
+    {
+      float const x = std::min(std::max(static_cast<float>(loc[2 * i]), 0.0f), max_x);
+      float const y = std::min(std::max(static_cast<float>(loc[2 * i + 1]), 0.0f), max_y);
+      float const x0 = std::min(std::floor(x), max_x0);
+      float const y0 = std::min(std::floor(y), max_y0);
+      wx[i] = x - x0;
+      wy[i] = y - y0;
+      offset[i] = static_cast<ptrdiff_t>(x0) * ws + static_cast<ptrdiff_t>(y0) * hs;
+    }
+
+    // gather the four neighbors of each sample and interpolate
+    for (size_t i = 0; i < n; ++i)
+    {
+      T const* const p = data + offset[i];
+      float const w00 = (1.0f - wx[i]) * (1.0f - wy[i]);
+      float const w10 = wx[i] * (1.0f - wy[i]);
+      float const w01 = (1.0f - wx[i]) * wy[i];
+      float const w11 = wx[i] * wy[i];
+      auto interpolate = [&](ptrdiff_t c)
+      {
+        float const v = w00 * p[c] + w10 * p[c + dx] +
+                        w01 * p[c + dy] + w11 * p[c + dx + dy];
+        return static_cast<uint8_t>(std::min(v * scale + 0.5f, 255.0f));
+      };
+      colors[b + i] = vital::rgb_color(interpolate(0), interpolate(c1),
+                                       interpolate(c2));
+    }
+  }
+}
+
+} // end anonymous namespace
+
+
+/// Sample image colors at a batch of sub-pixel locations
+void
+sample_image_colors(
+  vital::image const& image,
+  double const* locations,
+  size_t num_samples,
+  vital::rgb_color* colors)
+{
+  auto const& traits = image.pixel_traits();
+  if (traits.type == vital::image_pixel_traits::UNSIGNED &&
+      traits.num_bytes == 1)
+  {
+    sample_colors<uint8_t>(image, locations, num_samples, colors, 1.0f);
+  }
+  else if (traits.type == vital::image_pixel_traits::UNSIGNED &&
+           traits.num_bytes == 2)
+  {
+    sample_colors<uint16_t>(image, locations, num_samples, colors,
+                            255.0f / 65535.0f);
+  }
+  else
+  {
+    vital::image_of<uint8_t> image_data;
+    vital::cast_image(image, image_data);
+    sample_colors<uint8_t>(image_data, locations, num_samples, colors, 1.0f);
+  }
+}
+
+
 /// Extract feature colors from a frame image
 vital::feature_set_sptr
 extract_feature_colors(
   vital::feature_set const& features,
   vital::image_container const& image)
 {
-  const vital::image_of<uint8_t> image_data(image.get_image());
   std::vector<vital::feature_sptr> in_feat = features.features();
-  std::vector<vital::feature_sptr> out_feat;
-  out_feat.reserve(in_feat.size());
+  size_t const num_feat = in_feat.size();
 
-  for (auto const& f : in_feat)
+  std::vector<double> locations(2 * num_feat);
+  for (size_t i = 0; i < num_feat; ++i)
+  {
+    auto const& loc = in_feat[i]->loc();
+    locations[2 * i] = loc[0];
+    locations[2 * i + 1] = loc[1];
+  }
+  std::vector<vital::rgb_color> colors(num_feat);
+  sample_image_colors(image.get_image(), locations.data(), num_feat,
+                      colors.data());
+
+  // allocate all of the colored features in one block and share ownership
+  // of the block among them
+  auto const block = std::make_shared<std::vector<vital::feature_d> >();
+  block->reserve(num_feat);
+  std::vector<vital::feature_sptr> out_feat;
+  out_feat.reserve(num_feat);
+  for (size_t i = 0; i < num_feat; ++i)
   {
-    auto const& loc = f->loc();
-    auto const fd = std::make_shared<vital::feature_d>(*f);
-    fd->set_color(image_data.at(static_cast<unsigned>(loc[0]),
-                                static_cast<unsigned>(loc[1])));
-    out_feat.push_back(fd);
+    block->emplace_back(*in_feat[i]);
+    block->back().set_color(colors[i]);
+    out_feat.push_back(vital::feature_sptr(block, &block->back()));
   }
 
   return std::make_shared<vital::simple_feature_set>(out_feat);
@@ -76,68 +208,191 @@ extract_feature_colors(
   {
     return nullptr;
   }
-  const vital::image_of<uint8_t> image_data(image.get_image());
 
+  std::vector<vital::feature_track_state*> states;
+  std::vector<double> locations;
   for (auto& state : tracks->frame_states( frame_id ))
   {
-    auto fts = std::dynamic_pointer_cast<vital::feature_track_state>(state);
-    if ( !fts )
+    auto fts = dynamic_cast<vital::feature_track_state*>(state.get());
+    if ( !fts || !fts->feature )
     {
       continue;
     }
+    auto const& loc = fts->feature->loc();
+    states.push_back(fts);
+    locations.push_back(loc[0]);
+    locations.push_back(loc[1]);
+  }
 
-    auto const feat = std::make_shared<vital::feature_d>(*fts->feature);
-    auto const& loc = feat->get_loc();
-    feat->set_color(image_data.at(static_cast<unsigned>(loc[0]),
-                                  static_cast<unsigned>(loc[1])));
+  std::vector<vital::rgb_color> colors(states.size());
+  sample_image_colors(image.get_image(), locations.data(), states.size(),
+                      colors.data());
 
-    fts->feature = feat;
+  // replace each feature with a colored copy rather than coloring it in
+  // place, as features may be shared with other copies of the tracks; the
+  // copies are allocated in one block that they share ownership of
+  auto const block = std::make_shared<std::vector<vital::feature_d> >();
+  block->reserve(states.size());
+  for (size_t i = 0; i < states.size(); ++i)
+  {
+    auto const fts = states[i];
+    block->emplace_back(*fts->feature);
+    block->back().set_color(colors[i]);
+    fts->feature = vital::feature_sptr(block, &block->back());
   }
 
   return tracks;
 }
 
 
+namespace {
+
+/// Compute the color of a single track
+/**
+ * \param [in] track the track whose feature colors are combined
+ * \param [in] mode the method used to combine feature colors
+ * \param [out] color the combined color
+ * \param [in,out] samples scratch space reused between calls
+ * \return true if the track has at least one colored feature
+ */
+bool
+track_color(vital::track const& track, landmark_color_mode mode,
+            vital::rgb_color& color,
+            std::vector<vital::rgb_color>& samples)
+{
+  double ra = 0.0, ga = 0.0, ba = 0.0, wa = 0.0; // accumulators
+  samples.clear();
+  for (auto const& ts : track)
+  {
+    auto const fts =
+      dynamic_cast<vital::feature_track_state const*>(ts.get());
+    if ( !fts || !fts->feature )
+    {
+      continue;
+    }
+    auto const& c = fts->feature->color();
+    samples.push_back(c);
+    double const w = (mode == LANDMARK_COLOR_WEIGHTED_MEAN)
+                     ? fts->feature->magnitude() : 1.0;
+    ra += w * c.r;
+    ga += w * c.g;
+    ba += w * c.b;
+    wa += w;
+  }
+
+  if (samples.empty())
+  {
+    return false;
+  }
+
+  if (mode == LANDMARK_COLOR_MEDIAN)
+  {
+    auto const mid = samples.size() / 2;
+    auto channel_median = [&](uint8_t vital::rgb_color::* channel)
+    {
+      std::nth_element(samples.begin(), samples.begin() + mid, samples.end(),
+                       [channel](vital::rgb_color const& a,
+                                 vital::rgb_color const& b)
+                       { return a.*channel < b.*channel; });
+      return samples[mid].*channel;
+    };
+    color.r = channel_median(&vital::rgb_color::r);
+    color.g = channel_median(&vital::rgb_color::g);
+    color.b = channel_median(&vital::rgb_color::b);
+    return true;
+  }
+
+  // fall back to an unweighted average if all weights are zero
+  if (wa <= 0.0)
+  {
+    ra = ga = ba = 0.0;
+    for (auto const& c : samples)
+    {
+      ra += c.r;
+      ga += c.g;
+      ba += c.b;
+    }
+    wa = static_cast<double>(samples.size());
+  }
+  color.r = static_cast<unsigned char>(ra / wa);
+  color.g = static_cast<unsigned char>(ga / wa);
+  color.b = static_cast<unsigned char>(ba / wa);
+  return true;
+}
+
+} // end anonymous namespace
+
+
 /// Compute colors for landmarks
 vital::landmark_map_sptr compute_landmark_colors(
   vital::landmark_map const& landmarks,
-  vital::feature_track_set const& tracks)
+  vital::feature_track_set const& tracks,
+  landmark_color_mode mode)
 {
   auto colored_landmarks = landmarks.landmarks();
-  auto const no_such_landmark = colored_landmarks.end();
 
-  for (auto const track : tracks.tracks())
+  // Flat arrays indexed by landmark position in ID order.  Each track
+  // writes only to the slot of the landmark with its ID, so workers never
+  // share a slot and need no locking.
+  std::vector<vital::landmark_id_t> lm_ids;
+  std::vector<vital::landmark_sptr*> lm_slots;
+  lm_ids.reserve(colored_landmarks.size());
+  lm_slots.reserve(colored_landmarks.size());
+  for (auto& p : colored_landmarks)
+  {
+    lm_ids.push_back(p.first);
+    lm_slots.push_back(&p.second);
+  }
+
+  auto const all_tracks = tracks.tracks();
+  auto color_tracks = [&](size_t begin, size_t end)
   {
-    auto const lmid = static_cast<vital::landmark_id_t>(track->id());
-    auto lmi = colored_landmarks.find(lmid);
-    if (lmi != no_such_landmark)
+    std::vector<vital::rgb_color> samples;
+    for (size_t i = begin; i < end; ++i)
     {
-      int ra = 0, ga = 0, ba = 0, k = 0; // accumulators
-      for (auto const& ts : *track)
+      auto const& track = all_tracks[i];
+      auto const lmid = static_cast<vital::landmark_id_t>(track->id());
+      auto const itr = std::lower_bound(lm_ids.begin(), lm_ids.end(), lmid);
+      if (itr == lm_ids.end() || *itr != lmid)
       {
-        auto fts = std::dynamic_pointer_cast<vital::feature_track_state>(ts);
-        if( !fts )
-        {
-          continue;
-        }
-        auto const& color = fts->feature->color();
-        ra += color.r;
-        ga += color.g;
-        ba += color.b;
-        ++k;
+        continue;
       }
 
-      if (k)
+      vital::rgb_color color;
+      if (track_color(*track, mode, color, samples))
       {
-        auto const r = static_cast<unsigned char>(ra / k);
-        auto const g = static_cast<unsigned char>(ga / k);
-        auto const b = static_cast<unsigned char>(ba / k);
-
-        auto lm = std::make_shared<kwiver::vital::landmark_d>(*(lmi->second));
-        lm->set_color({r, g, b});
-        lmi->second = lm;
+        auto& slot = *lm_slots[itr - lm_ids.begin()];
+        auto lm = std::make_shared<kwiver::vital::landmark_d>(*slot);
+        lm->set_color(color);
+        slot = lm;
       }
     }
+  };
+
+  // Split the tracks into more chunks than threads so that threads which
+  // finish early pick up the remaining work from the pool queue.
+  auto& pool = vital::thread_pool::instance();
+  size_t const num_tracks = all_tracks.size();
+  size_t const num_chunks =
+    std::min(num_tracks / 256 + 1, pool.num_threads() * 4 + 1);
+  if (num_chunks <= 1)
+  {
+    color_tracks(0, num_tracks);
+  }
+  else
+  {
+    size_t const chunk_size = (num_tracks + num_chunks - 1) / num_chunks;
+    std::vector<std::future<void> > jobs;
+    for (size_t begin = 0; begin < num_tracks; begin += chunk_size)
+    {
+      size_t const end = std::min(begin + chunk_size, num_tracks);
+      jobs.push_back(pool.enqueue([&color_tracks, begin, end]()
+                                  { color_tracks(begin, end); }));
+    }
+    for (auto& j : jobs)
+    {
+      j.get();
+    }
   }
 
   return std::make_shared<kwiver::vital::simple_landmark_map>(colored_landmarks);
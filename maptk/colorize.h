@@ -47,6 +47,26 @@
 namespace kwiver {
 namespace maptk {
 
+/// Sample image colors at a batch of sub-pixel locations
+/**
+ * This function bilinearly interpolates the image color at each location.
+ * Locations outside of the image are clamped to the nearest edge pixel.
+ * Images with 8-bit or 16-bit unsigned pixels are sampled directly, with
+ * 16-bit values scaled to the 8-bit range.  Other pixel types are first cast
+ * to 8-bit.  Single channel images produce gray colors.
+ *
+ *  \param [in] image the image from which to take colors
+ *  \param [in] locations interleaved (x, y) pixel locations, two per sample
+ *  \param [in] num_samples the number of locations to sample
+ *  \param [out] colors array of \p num_samples colors to fill
+ */
+MAPTK_EXPORT
+void sample_image_colors(
+  vital::image const& image,
+  double const* locations,
+  size_t num_samples,
+  vital::rgb_color* colors);
+
 /// Extract feature colors from a frame image
 /*
  * This function extracts the feature colors from a supplied frame image and
@@ -66,7 +86,11 @@ vital::feature_set_sptr extract_feature_colors(
 /**
  * This function extracts the feature colors from a supplied frame image and
  * applies them to all features in the input track set with the same frame
- * number.
+ * number.  The features themselves are not modified, as they may be shared
+ * with other track sets; instead, the feature of each of those track states
+ * is replaced with a colored copy.  The copies for the frame are allocated in
+ * one shared block, so holding on to any one of them keeps the copies of the
+ * whole frame in memory.
  *
  *  \param [in] tracks a set of feature tracks in which to colorize feature points
  *  \param [in] image the image from which to take colors
@@ -79,19 +103,33 @@ vital::feature_track_set_sptr extract_feature_colors(
   vital::image_container const& image,
   vital::frame_id_t frame_id);
 
+/// Methods for combining the colors of feature points into a landmark color
+enum landmark_color_mode
+{
+  /// Average color of all associated feature points
+  LANDMARK_COLOR_MEAN,
+  /// Per-channel median color of all associated feature points
+  LANDMARK_COLOR_MEDIAN,
+  /// Average color weighted by the magnitude of each feature point
+  LANDMARK_COLOR_WEIGHTED_MEAN
+};
+
 /// Compute colors for landmarks
 /**
- * This function computes landmark colors by taking the average color of all
- * associated feature points.
+ * This function computes landmark colors by combining the colors of all
+ * associated feature points.  By default the average color is used.
+ * Tracks are colored in parallel on the vital thread pool.
  *
  *  \param [in] landmarks a set of landmarks to be colored
  *  \param [in] tracks feature tracks to be used for computing landmark colors
+ *  \param [in] mode the method used to combine feature point colors
  *  \return a set of colored landmarks
  */
 MAPTK_EXPORT
 vital::landmark_map_sptr compute_landmark_colors(
   vital::landmark_map const& landmarks,
-  vital::feature_track_set const& tracks);
+  vital::feature_track_set const& tracks,
+  landmark_color_mode mode = LANDMARK_COLOR_MEAN);
 
 } // end namespace maptk
 } // end namespace kwiver
@@ -0,0 +1,718 @@
+/*ckwg +29
+ * Copyright 2017 by Kitware, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ *  * Neither name of Kitware, Inc. nor the names of any contributors may be used
+ *    to endorse or promote products derived from this software without specific
+ *    prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * \brief Implementation of maptk feature track file I/O
+ */
+
+#include "feature_track_io.h"
+
+#include <vital/exceptions.h>
+#include <vital/io/track_set_io.h>
+
+#include <kwiversys/SystemTools.hxx>
+
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+namespace kwiver {
+namespace maptk {
+
+namespace {
+
+/// Signature at the start of every binary track file
+const char binary_magic[8] = { 'M', 'A', 'P', 'T', 'K', 'B', 'T', '\n' };
+
+/// Value used to detect files written with a different byte order
+const uint32_t binary_byte_order = 0x01020304;
+
+/// Current version of the binary track format
+const uint32_t binary_version = 1;
+
+/// Element types of the optional descriptor section
+enum descriptor_type : uint32_t
+{
+  DESC_NONE = 0,
+  DESC_UINT8 = 1,
+  DESC_FLOAT = 2,
+  DESC_DOUBLE = 3
+};
+
+/// Fixed size header of a binary track file
+/**
+ * The header is followed by these columns, each padded to 8 bytes:
+ *  - int64 frame ID per state
+ *  - int64 track ID per state
+ *  - double (x, y) location per state
+ *  - double magnitude per state
+ *  - double scale per state
+ *  - double angle per state
+ *  - uint64 first state of each track, plus one past the last state
+ *  - uint8 (r, g, b) color per state
+ *  - descriptor_length elements of descriptor_type per state, if any
+ */
+struct binary_header
+{
+  char magic[8];
+  uint32_t byte_order;
+  uint32_t version;
+  uint64_t num_states;
+  uint64_t num_tracks;
+  uint32_t descriptor_type;
+  uint32_t descriptor_length;
+  uint64_t reserved;
+};
+
+/// Return the size in bytes of one descriptor element
+size_t
+descriptor_element_size(uint32_t type)
+{
+  switch (type)
+  {
+    case DESC_UINT8: return sizeof(uint8_t);
+    case DESC_FLOAT: return sizeof(float);
+    case DESC_DOUBLE: return sizeof(double);
+    default: return 0;
+  }
+}
+
+/// Round a byte count up to a multiple of 8
+size_t
+padded(size_t bytes)
+{
+  return (bytes + 7) & ~size_t(7);
+}
+
+/// Write a column of values followed by padding to 8 bytes
+template <typename T>
+void
+write_column(std::ostream& os, T const* data, size_t count)
+{
+  size_t const bytes = count * sizeof(T);
+  os.write(reinterpret_cast<char const*>(data), bytes);
+  static const char zeros[8] = {};
+  os.write(zeros, padded(bytes) - bytes);
+}
+
+/// Determine the element type of a descriptor
+template <typename T>
+bool
+descriptor_elements(vital::descriptor const& desc, uint32_t type,
+                    uint32_t& out_type, void const*& data)
+{
+  auto const a = dynamic_cast<vital::descriptor_array_of<T> const*>(&desc);
+  if (!a)
+  {
+    return false;
+  }
+  out_type = type;
+  data = a->raw_data();
+  return true;
+}
+
+/// Construct a descriptor from raw elements
+template <typename T>
+vital::descriptor_sptr
+make_descriptor(void const* data, size_t length)
+{
+  auto const desc = std::make_shared<vital::descriptor_dynamic<T> >(length);
+  std::memcpy(desc->raw_data(), data, length * sizeof(T));
+  return desc;
+}
+
+} // end anonymous namespace
+
+
+/// Read feature tracks from a file in either the text or binary format
+vital::feature_track_set_sptr
+read_feature_track_file(vital::path_t const& file_path)
+{
+  if (is_binary_feature_track_file(file_path))
+  {
+    return binary_feature_track_store(file_path).track_set();
+  }
+  return vital::read_feature_track_file(file_path);
+}
+
+
+/// Write feature tracks to a file in either the text or binary format
+void
+write_feature_track_file(vital::feature_track_set_sptr const& tracks,
+                         vital::path_t const& file_path)
+{
+  typedef kwiversys::SystemTools ST;
+  if (tracks && ST::GetFilenameLastExtension(file_path) == ".kwbt")
+  {
+    write_binary_feature_track_file(*tracks, file_path);
+    return;
+  }
+  vital::write_feature_track_file(tracks, file_path);
+}
+
+
+/// Write feature tracks to a file in the binary format
+void
+write_binary_feature_track_file(vital::feature_track_set const& tracks,
+                                vital::path_t const& file_path)
+{
+  std::ofstream ofs(file_path.c_str(), std::ios::binary);
+  if (!ofs)
+  {
+    throw vital::file_write_exception(file_path, "Could not open file");
+  }
+
+  auto const all_tracks = tracks.tracks();
+  size_t num_states = 0;
+  for (auto const& t : all_tracks)
+  {
+    num_states += t->size();
+  }
+
+  std::vector<int64_t> frame_ids, track_ids;
+  std::vector<double> locations, magnitudes, scales, angles;
+  std::vector<uint64_t> track_offsets;
+  std::vector<uint8_t> colors;
+  std::vector<char> descriptors;
+  frame_ids.reserve(num_states);
+  track_ids.reserve(num_states);
+  locations.reserve(2 * num_states);
+  magnitudes.reserve(num_states);
+  scales.reserve(num_states);
+  angles.reserve(num_states);
+  colors.reserve(3 * num_states);
+  track_offsets.reserve(all_tracks.size() + 1);
+
+  // descriptors are written only if all states have the same kind
+  uint32_t desc_type = DESC_NONE;
+  size_t desc_length = 0;
+  bool write_descriptors = num_states > 0;
+
+  vital::feature_d const default_feature;
+  for (auto const& t : all_tracks)
+  {
+    if (t->empty())
+    {
+      continue;
+    }
+    track_offsets.push_back(frame_ids.size());
+    for (auto const& ts : *t)
+    {
+      auto const fts = std::dynamic_pointer_cast<vital::feature_track_state>(ts);
+      vital::feature const* f = (fts && fts->feature) ? fts->feature.get()
+                                                      : &default_feature;
+      auto const& loc = f->loc();
+      auto const& color = f->color();
+      frame_ids.push_back(ts->frame());
+      track_ids.push_back(t->id());
+      locations.push_back(loc[0]);
+      locations.push_back(loc[1]);
+      magnitudes.push_back(f->magnitude());
+      scales.push_back(f->scale());
+      angles.push_back(f->angle());
+      colors.push_back(color.r);
+      colors.push_back(color.g);
+      colors.push_back(color.b);
+
+      if (!write_descriptors)
+      {
+        continue;
+      }
+      uint32_t type = DESC_NONE;
+      void const* data = nullptr;
+      if (!fts || !fts->descriptor ||
+          !(descriptor_elements<uint8_t>(*fts->descriptor, DESC_UINT8, type, data) ||
+            descriptor_elements<float>(*fts->descriptor, DESC_FLOAT, type, data) ||
+            descriptor_elements<double>(*fts->descriptor, DESC_DOUBLE, type, data)))
+      {
+        write_descriptors = false;
+        continue;
+      }
+      if (desc_type == DESC_NONE)
+      {
+        desc_type = type;
+        desc_length = fts->descriptor->size();
+        descriptors.reserve(num_states * desc_length *
+                            descriptor_element_size(desc_type));
+      }
+      if (type != desc_type || fts->descriptor->size() != desc_length)
+      {
+        write_descriptors = false;
+        continue;
+      }
+      auto const bytes = static_cast<char const*>(data);
+      descriptors.insert(descriptors.end(), bytes,
+                         bytes + desc_length * descriptor_element_size(type));
+    }
+  }
+  track_offsets.push_back(frame_ids.size());
+
+  if (!write_descriptors)
+  {
+    desc_type = DESC_NONE;
+    desc_length = 0;
+    descriptors.clear();
+  }
+
+  binary_header header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, binary_magic, sizeof(binary_magic));
+  header.byte_order = binary_byte_order;
+  header.version = binary_version;
+  header.num_states = frame_ids.size();
+  header.num_tracks = track_offsets.size() - 1;
+  header.descriptor_type = desc_type;
+  header.descriptor_length = static_cast<uint32_t>(desc_length);
+
+  ofs.write(reinterpret_cast<char const*>(&header), sizeof(header));
+  write_column(ofs, frame_ids.data(), frame_ids.size());
+  write_column(ofs, track_ids.data(), track_ids.size());
+  write_column(ofs, locations.data(), locations.size());
+  write_column(ofs, magnitudes.data(), magnitudes.size());
+  write_column(ofs, scales.data(), scales.size());
+  write_column(ofs, angles.data(), angles.size());
+  write_column(ofs, track_offsets.data(), track_offsets.size());
+  write_column(ofs, colors.data(), colors.size());
+  write_column(ofs, descriptors.data(), descriptors.size());
+
+  if (!ofs)
+  {
+    throw vital::file_write_exception(file_path, "Failed writing track data");
+  }
+}
+
+
+/// Return true if the file at \p file_path is a binary feature track file
+bool
+is_binary_feature_track_file(vital::path_t const& file_path)
+{
+  std::ifstream ifs(file_path.c_str(), std::ios::binary);
+  char magic[sizeof(binary_magic)];
+  return ifs.read(magic, sizeof(magic)) &&
+         std::memcmp(magic, binary_magic, sizeof(magic)) == 0;
+}
+
+
+/// Private implementation class
+class binary_feature_track_store::priv
+{
+public:
+  priv()
+    : data(nullptr),
+      length(0),
+#ifdef _WIN32
+      file(INVALID_HANDLE_VALUE),
+      mapping(nullptr),
+#else
+      fd(-1),
+#endif
+      header(nullptr)
+  {
+  }
+
+  ~priv()
+  {
+    unmap();
+  }
+
+  /// Map the file into memory, returning false on failure
+  bool map(vital::path_t const& file_path);
+
+  /// Unmap the file
+  void unmap();
+
+  /// Validate the header and locate the columns
+  void locate_columns(vital::path_t const& file_path);
+
+  char const* data;
+  size_t length;
+#ifdef _WIN32
+  HANDLE file;
+  HANDLE mapping;
+#else
+  int fd;
+#endif
+
+  binary_header const* header;
+  int64_t const* frame_ids;
+  int64_t const* track_ids;
+  double const* locations;
+  double const* magnitudes;
+  double const* scales;
+  double const* angles;
+  uint64_t const* track_offsets;
+  uint8_t const* colors;
+  char const* descriptors;
+};
+
+
+bool
+binary_feature_track_store::priv
+::map(vital::path_t const& file_path)
+{
+#ifdef _WIN32
+  file = CreateFileA(file_path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                     nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+  {
+    return false;
+  }
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size))
+  {
+    return false;
+  }
+  length = static_cast<size_t>(size.QuadPart);
+  if (length == 0)
+  {
+    return true;
+  }
+  mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (!mapping)
+  {
+    return false;
+  }
+  data = static_cast<char const*>(
+    MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+  fd = open(file_path.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0)
+  {
+    return false;
+  }
+  length = static_cast<size_t>(st.st_size);
+  if (length == 0)
+  {
+    return true;
+  }
+  void* const addr = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (addr == MAP_FAILED)
+  {
+    return false;
+  }
+  data = static_cast<char const*>(addr);
+#endif
+  return data != nullptr;
+}
+
+
+void
+binary_feature_track_store::priv
+::unmap()
+{
+#ifdef _WIN32
+  if (data)
+  {
+    UnmapViewOfFile(data);
+  }
+  if (mapping)
+  {
+    CloseHandle(mapping);
+  }
+  if (file != INVALID_HANDLE_VALUE)
+  {
+    CloseHandle(file);
+  }
+  mapping = nullptr;
+  file = INVALID_HANDLE_VALUE;
+#else
+  if (data)
+  {
+    munmap(const_cast<char*>(data), length);
+  }
+  if (fd >= 0)
+  {
+    close(fd);
+  }
+  fd = -1;
+#endif
+  data = nullptr;
+  length = 0;
+}
+
+
+void
+binary_feature_track_store::priv
+::locate_columns(vital::path_t const& file_path)
+{
+  if (length < sizeof(binary_header))
+  {
+    throw vital::invalid_file(file_path, "File too small for a binary track header");
+  }
+  header = reinterpret_cast<binary_header const*>(data);
+  if (std::memcmp(header->magic, binary_magic, sizeof(binary_magic)) != 0)
+  {
+    throw vital::invalid_file(file_path, "Not a binary track file");
+  }
+  if (header->byte_order != binary_byte_order)
+  {
+    throw vital::invalid_file(file_path, "Binary track file has a different byte order");
+  }
+  if (header->version != binary_version)
+  {
+    throw vital::invalid_file(file_path, "Unsupported binary track file version");
+  }
+
+  // Bound the counts in the header by the file size before using them, so
+  // that a corrupt header can not overflow the column size computations
+  size_t const elem_size = descriptor_element_size(header->descriptor_type);
+  if (header->num_states > length / (2 * sizeof(double)) ||
+      header->num_tracks >= length / sizeof(uint64_t) ||
+      (elem_size && header->descriptor_length > length / elem_size))
+  {
+    throw vital::invalid_file(file_path, "Binary track file header is corrupt");
+  }
+
+  size_t const n = static_cast<size_t>(header->num_states);
+  size_t const desc_size = header->descriptor_length * elem_size;
+  if (desc_size && n > length / desc_size)
+  {
+    throw vital::invalid_file(file_path, "Binary track file is truncated");
+  }
+  size_t const desc_bytes = n * desc_size;
+  size_t const expected = sizeof(binary_header) +
+                          2 * padded(n * sizeof(int64_t)) +
+                          5 * padded(n * sizeof(double)) +
+                          padded((header->num_tracks + 1) * sizeof(uint64_t)) +
+                          padded(3 * n) + padded(desc_bytes);
+  if (length < expected)
+  {
+    throw vital::invalid_file(file_path, "Binary track file is truncated");
+  }
+
+  char const* p = data + sizeof(binary_header);
+  frame_ids = reinterpret_cast<int64_t const*>(p);
+  p += padded(n * sizeof(int64_t));
+  track_ids = reinterpret_cast<int64_t const*>(p);
+  p += padded(n * sizeof(int64_t));
+  locations = reinterpret_cast<double const*>(p);
+  p += padded(2 * n * sizeof(double));
+  magnitudes = reinterpret_cast<double const*>(p);
+  p += padded(n * sizeof(double));
+  scales = reinterpret_cast<double const*>(p);
+  p += padded(n * sizeof(double));
+  angles = reinterpret_cast<double const*>(p);
+  p += padded(n * sizeof(double));
+  track_offsets = reinterpret_cast<uint64_t const*>(p);
+  p += padded((header->num_tracks + 1) * sizeof(uint64_t));
+  colors = reinterpret_cast<uint8_t const*>(p);
+  p += padded(3 * n);
+  descriptors = desc_bytes ? p : nullptr;
+
+  // The track offsets index the state columns, so they must partition them
+  size_t const num_tracks = static_cast<size_t>(header->num_tracks);
+  if (track_offsets[0] != 0 || track_offsets[num_tracks] != header->num_states)
+  {
+    throw vital::invalid_file(file_path, "Binary track file has invalid track offsets");
+  }
+  for (size_t i = 0; i < num_tracks; ++i)
+  {
+    if (track_offsets[i] > track_offsets[i + 1])
+    {
+      throw vital::invalid_file(file_path, "Binary track file has invalid track offsets");
+    }
+  }
+}
+
+
+/// Open and map a binary feature track file
+binary_feature_track_store
+::binary_feature_track_store(vital::path_t const& file_path)
+  : d_(new priv)
+{
+  if (!d_->map(file_path))
+  {
+    d_->unmap();
+    throw vital::file_not_found_exception(file_path, "Could not map file");
+  }
+  d_->locate_columns(file_path);
+}
+
+
+/// Destructor, unmaps the file
+binary_feature_track_store
+::~binary_feature_track_store()
+{
+}
+
+
+/// Return the number of track states in the file
+size_t
+binary_feature_track_store
+::size() const
+{
+  return static_cast<size_t>(d_->header->num_states);
+}
+
+
+/// Return the number of tracks in the file
+size_t
+binary_feature_track_store
+::num_tracks() const
+{
+  return static_cast<size_t>(d_->header->num_tracks);
+}
+
+
+/// Return the frame ID of each track state
+int64_t const*
+binary_feature_track_store
+::frame_ids() const
+{
+  return d_->frame_ids;
+}
+
+
+/// Return the track ID of each track state
+int64_t const*
+binary_feature_track_store
+::track_ids() const
+{
+  return d_->track_ids;
+}
+
+
+/// Return the interleaved (x, y) location of each track state
+double const*
+binary_feature_track_store
+::locations() const
+{
+  return d_->locations;
+}
+
+
+/// Return the interleaved (r, g, b) color of each track state
+uint8_t const*
+binary_feature_track_store
+::colors() const
+{
+  return d_->colors;
+}
+
+
+/// Return true if the file contains a descriptor for every track state
+bool
+binary_feature_track_store
+::has_descriptors() const
+{
+  return d_->descriptors != nullptr;
+}
+
+
+/// Construct the feature of the track state at \p index
+vital::feature_sptr
+binary_feature_track_store
+::feature(size_t index) const
+{
+  uint8_t const* c = d_->colors + 3 * index;
+  return std::make_shared<vital::feature_d>(
+    vital::vector_2d(d_->locations[2 * index], d_->locations[2 * index + 1]),
+    d_->magnitudes[index], d_->scales[index], d_->angles[index],
+    vital::rgb_color(c[0], c[1], c[2]));
+}
+
+
+/// Construct the descriptor of the track state at \p index, if any
+vital::descriptor_sptr
+binary_feature_track_store
+::descriptor(size_t index) const
+{
+  if (!d_->descriptors)
+  {
+    return nullptr;
+  }
+  size_t const length = d_->header->descriptor_length;
+  size_t const bytes = length * descriptor_element_size(d_->header->descriptor_type);
+  void const* data = d_->descriptors + index * bytes;
+  switch (d_->header->descriptor_type)
+  {
+    case DESC_UINT8: return make_descriptor<uint8_t>(data, length);
+    case DESC_FLOAT: return make_descriptor<float>(data, length);
+    case DESC_DOUBLE: return make_descriptor<double>(data, length);
+    default: return nullptr;
+  }
+}
+
+
+/// Construct the track at \p track_index in file order
+vital::track_sptr
+binary_feature_track_store
+::track(size_t track_index) const
+{
+  size_t const begin = static_cast<size_t>(d_->track_offsets[track_index]);
+  size_t const end = static_cast<size_t>(d_->track_offsets[track_index + 1]);
+
+  auto t = vital::track::create();
+  if (begin < end)
+  {
+    t->set_id(d_->track_ids[begin]);
+  }
+  for (size_t i = begin; i < end; ++i)
+  {
+    t->append(std::make_shared<vital::feature_track_state>(
+                d_->frame_ids[i], feature(i), descriptor(i)));
+  }
+  return t;
+}
+
+
+/// Construct a feature track set with all tracks in the file
+vital::feature_track_set_sptr
+binary_feature_track_store
+::track_set() const
+{
+  std::vector<vital::track_sptr> tracks;
+  tracks.reserve(num_tracks());
+  for (size_t i = 0; i < num_tracks(); ++i)
+  {
+    tracks.push_back(track(i));
+  }
+  return std::make_shared<vital::feature_track_set>(tracks);
+}
+
+} // end namespace maptk
+} // end namespace kwiver
@@ -0,0 +1,168 @@
+/*ckwg +29
+ * Copyright 2017 by Kitware, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ *  * Neither name of Kitware, Inc. nor the names of any contributors may be used
+ *    to endorse or promote products derived from this software without specific
+ *    prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * \brief Header for maptk feature track file I/O, including a binary format
+ */
+
+#ifndef MAPTK_FEATURE_TRACK_IO_H_
+#define MAPTK_FEATURE_TRACK_IO_H_
+
+#include <maptk/maptk_export.h>
+
+#include <vital/types/descriptor.h>
+#include <vital/types/feature.h>
+#include <vital/types/feature_track_set.h>
+#include <vital/vital_types.h>
+
+#include <cstdint>
+#include <memory>
+
+
+namespace kwiver {
+namespace maptk {
+
+/// Read feature tracks from a file in either the text or binary format
+/**
+ * Files starting with the binary track file signature are read through a
+ * memory mapped binary_feature_track_store.  All other files are read as
+ * the KWIVER text track format.
+ *
+ * \note Every track state of a binary file is constructed by this function.
+ *       To access the tracks of a large binary file lazily, use a
+ *       binary_feature_track_store directly instead.
+ *
+ * \param [in] file_path the path to the file to read
+ * \return a feature track set containing all of the tracks in the file
+ */
+MAPTK_EXPORT
+vital::feature_track_set_sptr
+read_feature_track_file(vital::path_t const& file_path);
+
+
+/// Write feature tracks to a file in either the text or binary format
+/**
+ * The binary format is written if the file extension is ".kwbt", otherwise
+ * the KWIVER text track format is written.
+ *
+ * \param [in] tracks the feature tracks to write
+ * \param [in] file_path the path to the file to write
+ */
+MAPTK_EXPORT
+void
+write_feature_track_file(vital::feature_track_set_sptr const& tracks,
+                         vital::path_t const& file_path);
+
+
+/// Write feature tracks to a file in the binary format
+/**
+ * The binary format stores track states in track order as contiguous columns
+ * of frame IDs, track IDs, locations, magnitudes, scales, angles, and colors.
+ * If every state has a descriptor of the same type and size, a descriptor
+ * section is also written.
+ *
+ * \param [in] tracks the feature tracks to write
+ * \param [in] file_path the path to the file to write
+ */
+MAPTK_EXPORT
+void
+write_binary_feature_track_file(vital::feature_track_set const& tracks,
+                                vital::path_t const& file_path);
+
+
+/// Return true if the file at \p file_path is a binary feature track file
+MAPTK_EXPORT
+bool
+is_binary_feature_track_file(vital::path_t const& file_path);
+
+
+/// A read-only, memory mapped view of a binary feature track file
+/**
+ * The columns of the file are accessed in place without copying.  Feature
+ * track states are only constructed when requested, either for a single
+ * track or for the whole set.
+ */
+class MAPTK_EXPORT binary_feature_track_store
+{
+public:
+  /// Open and map a binary feature track file
+  /**
+   * \throws vital::file_not_found_exception if the file can not be opened
+   * \throws vital::invalid_file if the file is not a valid binary track file
+   */
+  explicit binary_feature_track_store(vital::path_t const& file_path);
+
+  /// Destructor, unmaps the file
+  ~binary_feature_track_store();
+
+  /// Return the number of track states in the file
+  size_t size() const;
+
+  /// Return the number of tracks in the file
+  size_t num_tracks() const;
+
+  /// Return the frame ID of each track state
+  int64_t const* frame_ids() const;
+
+  /// Return the track ID of each track state
+  int64_t const* track_ids() const;
+
+  /// Return the interleaved (x, y) location of each track state
+  double const* locations() const;
+
+  /// Return the interleaved (r, g, b) color of each track state
+  uint8_t const* colors() const;
+
+  /// Return true if the file contains a descriptor for every track state
+  bool has_descriptors() const;
+
+  /// Construct the feature of the track state at \p index
+  vital::feature_sptr feature(size_t index) const;
+
+  /// Construct the descriptor of the track state at \p index, if any
+  vital::descriptor_sptr descriptor(size_t index) const;
+
+  /// Construct the track at \p track_index in file order
+  vital::track_sptr track(size_t track_index) const;
+
+  /// Construct a feature track set with all tracks in the file
+  vital::feature_track_set_sptr track_set() const;
+
+private:
+  class priv;
+  const std::unique_ptr<priv> d_;
+};
+
+} // end namespace maptk
+} // end namespace kwiver
+
+
+#endif
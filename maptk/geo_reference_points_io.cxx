@@ -35,13 +35,18 @@
 
 #include "geo_reference_points_io.h"
 #include <vital/exceptions.h>
-#include <vital/io/eigen_io.h>
 #include <vital/types/geodesy.h>
 #include <vital/logger/logger.h>
+#include <vital/util/thread_pool.h>
 
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
-#include <iomanip>
-#include <iostream>
+#include <future>
+#include <iterator>
+#include <sstream>
 #include <vector>
 
 
@@ -49,110 +54,293 @@
 namespace kwiver {
 namespace maptk {
 
+namespace {
 
-/// Load landmarks and feature tracks from reference points file
-void load_reference_file(vital::path_t const& reference_file,
-                         local_geo_cs & lgcs,
-                         vital::landmark_map_sptr & ref_landmarks,
-                         vital::feature_track_set_sptr & ref_track_set)
+/// A single parsed line of a reference points file
+struct reference_line
 {
-  using namespace std;
+  /// true if the line contains no data and should be skipped
+  bool blank = true;
+  /// longitude, latitude, and altitude of the landmark
+  double lon_lat_alt[3];
+  /// track of the landmark observations, without an ID assigned
+  vital::track_sptr track;
+};
 
-  kwiver::vital::logger_handle_t logger( kwiver::vital::get_logger( "load_reference_file" ) );
 
-  // Read in file, creating a landmark map and a vector of feature tracks, associated
-  // via IDs
-  std::ifstream input_stream(reference_file.c_str(), std::fstream::in);
-  if (!input_stream)
+/// Advance past spaces and tabs
+inline
+char const*
+skip_space(char const* p, char const* end)
+{
+  while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
   {
-    throw vital::file_not_found_exception(reference_file, "Could not open reference points file!");
+    ++p;
   }
+  return p;
+}
 
-  // pre-allocated vars for loop
-  vital::landmark_id_t cur_id = 1;
-  vital::frame_id_t frm;
-  vital::vector_2d feat_loc;
-  vital::vector_3d vec(0,0,0);
 
-  // used to stream file lines into data types
-  std::istringstream ss;
+/// Parse a floating point value from the range [p, end)
+/**
+ * Returns a pointer past the parsed value or nullptr if no valid number was
+ * found.  The range must be followed by a character that terminates the
+ * number, such as the line end.
+ */
+inline
+char const*
+parse_value(char const* p, char const* end, double& value)
+{
+  char* num_end = nullptr;
+  errno = 0;
+  value = std::strtod(p, &num_end);
+  if (num_end == p || num_end > end || errno == ERANGE)
+  {
+    return nullptr;
+  }
+  return num_end;
+}
 
-  vital::landmark_map::map_landmark_t reference_lms;
-  std::vector<vital::track_sptr> reference_tracks;
 
-  // Mean position of all landmarks.
-  vital::vector_3d mean(0,0,0);
+/// Parse an integer value from the range [p, end)
+inline
+char const*
+parse_value(char const* p, char const* end, vital::frame_id_t& value)
+{
+  char* num_end = nullptr;
+  errno = 0;
+  value = static_cast<vital::frame_id_t>(std::strtoll(p, &num_end, 10));
+  if (num_end == p || num_end > end || errno == ERANGE)
+  {
+    return nullptr;
+  }
+  return num_end;
+}
 
-  // If the origin is invalid then use the reference points to compute a new origin
-  const bool set_lgcs_origin = lgcs.origin().is_empty();
-  int crs = lgcs.origin().crs();
 
-  // TODO: put in try-catch around >>'s in case we have an ill-formatted file,
-  // or there's a parse error
-  LOG_INFO(logger, "Reading ground control points from file: " << reference_file);
-  for (std::string line; std::getline(input_stream, line);)
+/// Parse one line of a reference points file
+/**
+ * Returns an empty string on success, otherwise a description of the error.
+ */
+std::string
+parse_reference_line(char const* begin, char const* end, reference_line& rl)
+{
+  char const* p = skip_space(begin, end);
+  if (p == end)
   {
-    ss.clear();
-    ss.str(line);
+    rl.blank = true;
+    return std::string();
+  }
+  rl.blank = false;
 
-    // input landmarks are given in lon/lat/alt format (ignoring alt for now)
-    ss >> vec;
+  static char const* const lm_names[] = { "longitude", "latitude", "altitude" };
+  for (unsigned i = 0; i < 3; ++i)
+  {
+    p = parse_value(skip_space(p, end), end, rl.lon_lat_alt[i]);
+    if (!p)
+    {
+      return std::string("expected landmark ") + lm_names[i];
+    }
+  }
 
-    vital::vector_2d lon_lat(vec.x(), vec.y());
-    vital::geo_point gp(lon_lat, vital::SRID::lat_lon_WGS84);
-    if ( lgcs.origin().is_empty() )
+  rl.track = vital::track::create();
+  for (p = skip_space(p, end); p < end; p = skip_space(p, end))
+  {
+    vital::frame_id_t frm;
+    vital::vector_2d feat_loc;
+    p = parse_value(p, end, frm);
+    if (!p)
+    {
+      return "expected track state frame number";
+    }
+    p = parse_value(skip_space(p, end), end, feat_loc[0]);
+    if (!p)
+    {
+      return "expected track state x coordinate";
+    }
+    p = parse_value(skip_space(p, end), end, feat_loc[1]);
+    if (!p)
     {
-      auto zone = vital::utm_ups_zone( lon_lat );
-      crs = (zone.north ? vital::SRID::UTM_WGS84_north : vital::SRID::UTM_WGS84_south) + zone.number;
-      LOG_DEBUG(logger, "lgcs origin zone: " << zone.number );
-      lgcs.set_origin( vital::geo_point( gp.location( crs ), crs ) );
+      return "expected track state y coordinate";
     }
-    vital::vector_2d utm = gp.location(crs);
+    auto fts = std::make_shared<vital::feature_track_state>(frm,
+                     std::make_shared<vital::feature_d>(feat_loc),
+                     vital::descriptor_sptr());
+    rl.track->append(fts);
+  }
+  return std::string();
+}
 
-    vec[0] = utm.x();
-    vec[1] = utm.y();
-    mean += vec;
+} // end anonymous namespace
 
-    reference_lms[cur_id] = vital::landmark_sptr(new vital::landmark_d(vec));
 
-    // while there's still input left, read in track states
-    vital::track_sptr lm_track = vital::track::create();
-    lm_track->set_id(static_cast<vital::track_id_t>(cur_id));
-    while (ss.peek() != std::char_traits<char>::eof())
+/// Load landmarks and feature tracks from reference points file
+void load_reference_file(vital::path_t const& reference_file,
+                         local_geo_cs & lgcs,
+                         vital::landmark_map_sptr & ref_landmarks,
+                         vital::feature_track_set_sptr & ref_track_set)
+{
+  kwiver::vital::logger_handle_t logger( kwiver::vital::get_logger( "load_reference_file" ) );
+
+  // Read the whole file into memory so that lines may be parsed in parallel
+  std::ifstream input_stream(reference_file.c_str(),
+                             std::fstream::in | std::fstream::binary);
+  if (!input_stream)
+  {
+    throw vital::file_not_found_exception(reference_file, "Could not open reference points file!");
+  }
+  LOG_INFO(logger, "Reading ground control points from file: " << reference_file);
+  std::string buffer((std::istreambuf_iterator<char>(input_stream)),
+                     std::istreambuf_iterator<char>());
+  input_stream.close();
+
+  // Find the start of each line.  Every line, including the last, is
+  // terminated by a newline or by the end of the buffer, which strtod will not
+  // read past because std::string is null terminated.
+  std::vector<size_t> line_starts;
+  for (size_t pos = 0; pos < buffer.size(); )
+  {
+    line_starts.push_back(pos);
+    char const* nl = static_cast<char const*>(
+      std::memchr(buffer.data() + pos, '\n', buffer.size() - pos));
+    pos = nl ? static_cast<size_t>(nl - buffer.data()) + 1 : buffer.size();
+  }
+  line_starts.push_back(buffer.size());
+  size_t const num_lines = line_starts.size() - 1;
+
+  // Parse chunks of lines in parallel.  Each chunk records its first error.
+  std::vector<reference_line> lines(num_lines);
+  auto parse_lines = [&](size_t begin, size_t end,
+                         size_t& err_line, std::string& err_msg)
+  {
+    for (size_t i = begin; i < end; ++i)
     {
-      ss >> frm;
-      ss >> feat_loc;
-      auto fts = std::make_shared<vital::feature_track_state>(frm,
-                       vital::feature_sptr(new vital::feature_d(feat_loc)),
-                       vital::descriptor_sptr());
-      lm_track->append(fts);
+      char const* line_begin = buffer.data() + line_starts[i];
+      char const* line_end = buffer.data() + line_starts[i + 1];
+      if (line_end > line_begin && line_end[-1] == '\n')
+      {
+        --line_end;
+      }
+      err_msg = parse_reference_line(line_begin, line_end, lines[i]);
+      if (!err_msg.empty())
+      {
+        err_line = i;
+        return;
+      }
     }
-    reference_tracks.push_back(lm_track);
+  };
 
-    ++cur_id;
+  static const size_t min_chunk_size = 256;
+  auto& pool = vital::thread_pool::instance();
+  size_t const num_chunks = std::max<size_t>(1,
+    std::min(num_lines / min_chunk_size, pool.num_threads() * 4));
+  size_t const chunk_size = (num_lines + num_chunks - 1) / num_chunks;
+  std::vector<size_t> err_lines(num_chunks, num_lines);
+  std::vector<std::string> err_msgs(num_chunks);
+  if (num_chunks == 1)
+  {
+    parse_lines(0, num_lines, err_lines[0], err_msgs[0]);
+  }
+  else
+  {
+    std::vector<std::future<void> > jobs;
+    for (size_t c = 0; c < num_chunks; ++c)
+    {
+      size_t const begin = std::min(c * chunk_size, num_lines);
+      size_t const end = std::min(begin + chunk_size, num_lines);
+      jobs.push_back(pool.enqueue([&, c, begin, end]()
+      {
+        parse_lines(begin, end, err_lines[c], err_msgs[c]);
+      }));
+    }
+    for (auto& j : jobs)
+    {
+      j.get();
+    }
+  }
+  for (size_t c = 0; c < num_chunks; ++c)
+  {
+    if (!err_msgs[c].empty())
+    {
+      std::ostringstream ss;
+      ss << "Parse error on line " << (err_lines[c] + 1) << ": " << err_msgs[c];
+      throw vital::invalid_file(reference_file, ss.str());
+    }
   }
-  LOG_INFO(logger, "Loaded "<< reference_tracks.size() <<" ground control points");
 
+  // Gather the landmark positions of all non-blank lines
+  std::vector<reference_line*> points;
+  points.reserve(num_lines);
+  for (auto& rl : lines)
+  {
+    if (!rl.blank)
+    {
+      points.push_back(&rl);
+    }
+  }
+  LOG_INFO(logger, "Loaded "<< points.size() <<" ground control points");
+  if (points.empty())
+  {
+    // Nothing to compute an origin from; leave the lgcs as it was
+    ref_landmarks = std::make_shared<vital::simple_landmark_map>();
+    ref_track_set = std::make_shared<vital::feature_track_set>();
+    return;
+  }
+
+  std::vector<double> lon_lat_alt(3 * points.size());
+  for (size_t i = 0; i < points.size(); ++i)
+  {
+    std::copy(points[i]->lon_lat_alt, points[i]->lon_lat_alt + 3,
+              lon_lat_alt.begin() + 3 * i);
+  }
+
+  // If the origin is invalid then use the reference points to compute a new
+  // origin.  Start with the first point, which selects the UTM zone, and then
+  // shift to the mean position below.
+  const bool set_lgcs_origin = lgcs.origin().is_empty();
+  if (set_lgcs_origin)
+  {
+    lgcs.set_origin( vital::geo_point( vital::vector_2d( lon_lat_alt[0], lon_lat_alt[1] ),
+                                       vital::SRID::lat_lon_WGS84 ) );
+    lgcs.set_origin_altitude( 0.0 );
+    LOG_DEBUG(logger, "lgcs origin crs: " << lgcs.origin().crs() );
+  }
+
+  // Transform the landmarks into local coordinates in one batch
+  LOG_INFO(logger, "transforming ground control points to local coordinates");
+  std::vector<double> local(lon_lat_alt.size());
+  geographic_to_local(lgcs, lon_lat_alt.data(), points.size(), local.data());
+
+  vital::vector_3d mean(0,0,0);
   if (set_lgcs_origin)
   {
     // Initialize lgcs center
-    mean /= static_cast<double>(reference_lms.size());
-    lgcs.set_origin( vital::geo_point( vital::vector_2d( mean.x(), mean.y() ), crs ) );
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+      mean += vital::vector_3d(local[3*i], local[3*i+1], local[3*i+2]);
+    }
+    mean /= static_cast<double>(points.size());
+    lgcs.set_origin( vital::geo_point( lgcs.origin().location() +
+                                       vital::vector_2d( mean.x(), mean.y() ),
+                                       lgcs.origin().crs() ) );
     lgcs.set_origin_altitude( mean.z() );
-    LOG_DEBUG(logger, "mean position (lgcs origin): " << mean.transpose());
+    LOG_DEBUG(logger, "mean position (lgcs origin): "
+                      << lgcs.origin().location().transpose() << " "
+                      << lgcs.origin_altitude());
   }
 
-  // Scan through reference landmarks, adjusting their location by the lgcs
-  // origin.
-  LOG_INFO(logger, "transforming ground control points to local coordinates");
-  for(vital::landmark_map::map_landmark_t::value_type & p : reference_lms)
-  {
-    auto loc = p.second->loc();
-    auto origin_pt = lgcs.origin().location();
-    loc[0] -= origin_pt[0];
-    loc[1] -= origin_pt[1];
-    loc[2] -= lgcs.origin_altitude();
-    dynamic_cast<vital::landmark_d*>(p.second.get())->set_loc(loc);
+  vital::landmark_map::map_landmark_t reference_lms;
+  std::vector<vital::track_sptr> reference_tracks;
+  reference_tracks.reserve(points.size());
+  for (size_t i = 0; i < points.size(); ++i)
+  {
+    vital::landmark_id_t const cur_id = static_cast<vital::landmark_id_t>(i + 1);
+    vital::vector_3d const loc(local[3*i], local[3*i+1], local[3*i+2]);
+    reference_lms[cur_id] = std::make_shared<vital::landmark_d>(loc - mean);
+
+    auto const& lm_track = points[i]->track;
+    lm_track->set_id(static_cast<vital::track_id_t>(cur_id));
+    reference_tracks.push_back(lm_track);
   }
 
   ref_landmarks = std::make_shared<vital::simple_landmark_map>(reference_lms);
@@ -69,7 +69,11 @@ namespace maptk {
  * for each landmark, for transformation to converge, however more of each is
  * recommended.
  *
- * Landmark Z position, or altitude, should be given in meters.
+ * Landmark Z position, or altitude, should be given in meters.  Blank lines
+ * are ignored.  Lines are parsed in parallel and a vital::invalid_file
+ * exception reporting the line number is thrown for the first malformed line.
+ * If the file has no reference points, empty landmark and track maps are
+ * returned and \c lgcs is not changed.
  *
  */
 MAPTK_EXPORT
@@ -35,10 +35,16 @@
 
 #include "local_geo_cs.h"
 
+#include <algorithm>
+#include <cmath>
 #include <fstream>
+#include <future>
 #include <iomanip>
+#include <vector>
 
+#include <vital/exceptions.h>
 #include <vital/types/geodesy.h>
+#include <vital/util/thread_pool.h>
 #include <vital/video_metadata/video_metadata_traits.h>
 
 #define _USE_MATH_DEFINES
@@ -63,6 +69,233 @@ namespace maptk {
   static const double deg2rad = static_cast<double>( LOCAL_PI ) / 180.0;
 
 
+namespace {
+
+/// Return true if a coordinate system code is a WGS84 UTM zone
+/**
+ * Origins in the polar regions are in a UPS zone (zone number 0) instead.
+ */
+bool
+is_utm_crs(int crs)
+{
+  bool const north = crs < SRID::UTM_WGS84_south;
+  int const zone = crs - (north ? SRID::UTM_WGS84_north
+                                : SRID::UTM_WGS84_south);
+  return zone >= 1 && zone <= 60;
+}
+
+
+/// Transverse Mercator projection for a single WGS84 UTM zone
+/**
+ * This uses the Kruger series expanded to third order in the third
+ * flattening, which is accurate to about a millimeter within 3000 km of the
+ * central meridian.  The series coefficients depend only on the ellipsoid
+ * and are computed once.  Constructing a projection only sets up the zone.
+ */
+class utm_projection
+{
+public:
+  /// Construct the projection for a WGS84 UTM coordinate system code
+  explicit utm_projection(int crs)
+  {
+    if( !is_utm_crs(crs) )
+    {
+      throw vital::invalid_value("local_geo_cs origin is not in a WGS84 UTM zone");
+    }
+    bool const north = crs < SRID::UTM_WGS84_south;
+    int const zone = crs - (north ? SRID::UTM_WGS84_north
+                                  : SRID::UTM_WGS84_south);
+    lon0_ = (zone * 6.0 - 183.0) * deg2rad;
+    false_northing_ = north ? 0.0 : 10000000.0;
+  }
+
+  /// Project longitude and latitude (degrees) to easting and northing
+  void forward(double lon, double lat, double& easting, double& northing) const
+  {
+    series_t const& c = series();
+    double const phi = lat * deg2rad;
+    double const dlam = lon * deg2rad - lon0_;
+    double const sp = std::sin(phi);
+    double const t = std::sinh(std::atanh(sp) - c.e * std::atanh(c.e * sp));
+    double const xi = std::atan2(t, std::cos(dlam));
+    double const eta = std::atanh(std::sin(dlam) / std::sqrt(1.0 + t * t));
+    double x = xi, y = eta;
+    for( int j = 1; j <= 3; ++j )
+    {
+      x += c.alpha[j] * std::sin(2 * j * xi) * std::cosh(2 * j * eta);
+      y += c.alpha[j] * std::cos(2 * j * xi) * std::sinh(2 * j * eta);
+    }
+    easting = false_easting + k0 * c.A * y;
+    northing = false_northing_ + k0 * c.A * x;
+  }
+
+  /// Unproject easting and northing to longitude and latitude (degrees)
+  void inverse(double easting, double northing, double& lon, double& lat) const
+  {
+    series_t const& c = series();
+    double const xi = (northing - false_northing_) / (k0 * c.A);
+    double const eta = (easting - false_easting) / (k0 * c.A);
+    double xp = xi, yp = eta;
+    for( int j = 1; j <= 3; ++j )
+    {
+      xp -= c.beta[j] * std::sin(2 * j * xi) * std::cosh(2 * j * eta);
+      yp -= c.beta[j] * std::cos(2 * j * xi) * std::sinh(2 * j * eta);
+    }
+    double const chi = std::asin(std::sin(xp) / std::cosh(yp));
+    double phi = chi;
+    for( int j = 1; j <= 3; ++j )
+    {
+      phi += c.delta[j] * std::sin(2 * j * chi);
+    }
+    lat = phi * rad2deg;
+    lon = (lon0_ + std::atan2(std::sinh(yp), std::cos(xp))) * rad2deg;
+  }
+
+private:
+  /// Series coefficients of the WGS84 ellipsoid
+  struct series_t
+  {
+    series_t()
+    {
+      double const f = 1.0 / 298.257223563;
+      double const n = f / (2.0 - f);
+      double const n2 = n * n, n3 = n2 * n;
+      A = 6378137.0 / (1.0 + n) * (1.0 + n2 / 4.0 + n2 * n2 / 64.0);
+      e = 2.0 * std::sqrt(n) / (1.0 + n);
+      alpha[0] = beta[0] = delta[0] = 0.0;
+      alpha[1] = n / 2.0 - 2.0 * n2 / 3.0 + 5.0 * n3 / 16.0;
+      alpha[2] = 13.0 * n2 / 48.0 - 3.0 * n3 / 5.0;
+      alpha[3] = 61.0 * n3 / 240.0;
+      beta[1] = n / 2.0 - 2.0 * n2 / 3.0 + 37.0 * n3 / 96.0;
+      beta[2] = n2 / 48.0 + n3 / 15.0;
+      beta[3] = 17.0 * n3 / 480.0;
+      delta[1] = 2.0 * n - 2.0 * n2 / 3.0 - 2.0 * n3;
+      delta[2] = 7.0 * n2 / 3.0 - 8.0 * n3 / 5.0;
+      delta[3] = 56.0 * n3 / 15.0;
+    }
+
+    double A, e;
+    double alpha[4], beta[4], delta[4];
+  };
+
+  static series_t const& series()
+  {
+    static const series_t s;
+    return s;
+  }
+
+  static constexpr double k0 = 0.9996;
+  static constexpr double false_easting = 500000.0;
+
+  double lon0_;
+  double false_northing_;
+};
+
+constexpr double utm_projection::k0;
+constexpr double utm_projection::false_easting;
+
+
+/// Run a function over blocks of a range in parallel on the thread pool
+/**
+ * Small ranges are processed on the calling thread.
+ */
+template <typename Func>
+void
+parallel_for_blocks(size_t num, Func const& func)
+{
+  static const size_t min_block_size = 4096;
+  auto& pool = vital::thread_pool::instance();
+  size_t const num_blocks = std::min(num / min_block_size + 1,
+                                     pool.num_threads() * 4 + 1);
+  if( num_blocks <= 1 )
+  {
+    func(0, num);
+    return;
+  }
+  size_t const block_size = (num + num_blocks - 1) / num_blocks;
+  std::vector<std::future<void> > jobs;
+  for( size_t begin = 0; begin < num; begin += block_size )
+  {
+    size_t const end = std::min(begin + block_size, num);
+    jobs.push_back(pool.enqueue([&func, begin, end]() { func(begin, end); }));
+  }
+  for( auto& j : jobs )
+  {
+    j.get();
+  }
+}
+
+
+/// Check the native forward projection against the geo_point conversion
+/**
+ * The batch conversions use the native projection while single points (as in
+ * local_geo_cs::update_camera) are converted by geo_point.  This compares the
+ * two at a sample point so that the batch conversions can fall back to
+ * geo_point rather than disagree with it.
+ */
+bool
+forward_agrees(int crs, double lon, double lat)
+{
+  static const double tolerance = 0.01; // meters
+
+  double easting, northing;
+  utm_projection(crs).forward(lon, lat, easting, northing);
+  vector_2d const expected =
+    geo_point(vector_2d(lon, lat), SRID::lat_lon_WGS84).location(crs);
+  return std::abs(easting - expected.x()) < tolerance &&
+         std::abs(northing - expected.y()) < tolerance;
+}
+
+
+/// Check the native inverse projection against the geo_point conversion
+bool
+inverse_agrees(int crs, double easting, double northing)
+{
+  static const double tolerance = 1e-7; // degrees, about a centimeter
+
+  double lon, lat;
+  utm_projection(crs).inverse(easting, northing, lon, lat);
+  vector_2d const expected =
+    geo_point(vector_2d(easting, northing), crs).location(SRID::lat_lon_WGS84);
+  return std::abs(lon - expected.x()) < tolerance &&
+         std::abs(lat - expected.y()) < tolerance;
+}
+
+
+/// Warn that the batch conversions are falling back to geo_point
+void
+warn_projection_mismatch()
+{
+  vital::logger_handle_t logger( vital::get_logger( "local_geo_cs" ) );
+  LOG_WARN( logger, "Native UTM projection disagrees with geo_point; "
+                    "converting points one at a time" );
+}
+
+
+/// Apply the yaw, pitch, and roll in the metadata, if any, to the camera
+void
+update_camera_rotation(vital::video_metadata const& md,
+                       vital::simple_camera& cam,
+                       vital::rotation_d const& rot_offset)
+{
+  if( md.has( vital::VITAL_META_SENSOR_YAW_ANGLE) &&
+      md.has( vital::VITAL_META_SENSOR_PITCH_ANGLE) &&
+      md.has( vital::VITAL_META_SENSOR_ROLL_ANGLE) )
+  {
+    double yaw = md.find( vital::VITAL_META_SENSOR_YAW_ANGLE ).as_double();
+    double pitch = md.find( vital::VITAL_META_SENSOR_PITCH_ANGLE ).as_double();
+    double roll = md.find( vital::VITAL_META_SENSOR_ROLL_ANGLE ).as_double();
+
+    // Apply offset rotation specifically on the lhs of the INS
+    cam.set_rotation(rot_offset * rotation_d(yaw * deg2rad,
+                                             pitch * deg2rad,
+                                             roll * deg2rad));
+  }
+}
+
+} // end anonymous namespace
+
+
 /// Constructor
 local_geo_cs
 ::local_geo_cs()
@@ -92,19 +325,7 @@ local_geo_cs
                 vital::simple_camera& cam,
                 vital::rotation_d const& rot_offset) const
 {
-  if( md.has( vital::VITAL_META_SENSOR_YAW_ANGLE) &&
-      md.has( vital::VITAL_META_SENSOR_PITCH_ANGLE) &&
-      md.has( vital::VITAL_META_SENSOR_ROLL_ANGLE) )
-  {
-    double yaw = md.find( vital::VITAL_META_SENSOR_YAW_ANGLE ).as_double();
-    double pitch = md.find( vital::VITAL_META_SENSOR_PITCH_ANGLE ).as_double();
-    double roll = md.find( vital::VITAL_META_SENSOR_ROLL_ANGLE ).as_double();
-
-    // Apply offset rotation specifically on the lhs of the INS
-    cam.set_rotation(rot_offset * rotation_d(yaw * deg2rad,
-                                             pitch * deg2rad,
-                                             roll * deg2rad));
-  }
+  update_camera_rotation(md, cam, rot_offset);
 
   if( md.has( vital::VITAL_META_SENSOR_LOCATION) &&
       md.has( vital::VITAL_META_SENSOR_ALTITUDE) )
@@ -144,6 +365,116 @@ local_geo_cs
 }
 
 
+/// Convert a batch of geographic coordinates into local coordinates
+void
+geographic_to_local(local_geo_cs const& lgcs,
+                    double const* lon_lat_alt,
+                    size_t num_points,
+                    double* local)
+{
+  if( lgcs.origin().is_empty() )
+  {
+    throw vital::invalid_value("local_geo_cs does not have an origin");
+  }
+  int const crs = lgcs.origin().crs();
+  vector_2d const origin = lgcs.origin().location();
+  double const origin_alt = lgcs.origin_altitude();
+
+  // Origins that are not in a UTM zone (i.e. polar origins, which are in a
+  // UPS zone) are converted one point at a time through geo_point, as are all
+  // points if the native projection does not match geo_point
+  bool use_native = is_utm_crs(crs);
+  if( use_native && num_points > 0 &&
+      !forward_agrees(crs, lon_lat_alt[0], lon_lat_alt[1]) )
+  {
+    warn_projection_mismatch();
+    use_native = false;
+  }
+  if( !use_native )
+  {
+    for( size_t i = 0; i < num_points; ++i )
+    {
+      double const* const in = lon_lat_alt + 3 * i;
+      double* const out = local + 3 * i;
+      vector_2d const loc =
+        geo_point(vector_2d(in[0], in[1]), SRID::lat_lon_WGS84).location(crs);
+      out[0] = loc.x() - origin.x();
+      out[1] = loc.y() - origin.y();
+      out[2] = in[2] - origin_alt;
+    }
+    return;
+  }
+
+  utm_projection const proj(crs);
+  parallel_for_blocks(num_points, [&](size_t begin, size_t end)
+  {
+    for( size_t i = begin; i < end; ++i )
+    {
+      double const* const in = lon_lat_alt + 3 * i;
+      double* const out = local + 3 * i;
+      proj.forward(in[0], in[1], out[0], out[1]);
+      out[0] -= origin.x();
+      out[1] -= origin.y();
+      out[2] = in[2] - origin_alt;
+    }
+  });
+}
+
+
+/// Convert a batch of local coordinates into geographic coordinates
+void
+local_to_geographic(local_geo_cs const& lgcs,
+                    double const* local,
+                    size_t num_points,
+                    double* lon_lat_alt)
+{
+  if( lgcs.origin().is_empty() )
+  {
+    throw vital::invalid_value("local_geo_cs does not have an origin");
+  }
+  int const crs = lgcs.origin().crs();
+  vector_2d const origin = lgcs.origin().location();
+  double const origin_alt = lgcs.origin_altitude();
+
+  // As in geographic_to_local, fall back to geo_point for origins that are
+  // not in a UTM zone, or if the native projection does not match geo_point
+  bool use_native = is_utm_crs(crs);
+  if( use_native && num_points > 0 &&
+      !inverse_agrees(crs, local[0] + origin.x(), local[1] + origin.y()) )
+  {
+    warn_projection_mismatch();
+    use_native = false;
+  }
+  if( !use_native )
+  {
+    for( size_t i = 0; i < num_points; ++i )
+    {
+      double const* const in = local + 3 * i;
+      double* const out = lon_lat_alt + 3 * i;
+      vector_2d const loc =
+        geo_point(vector_2d(in[0] + origin.x(), in[1] + origin.y()), crs)
+        .location(SRID::lat_lon_WGS84);
+      out[0] = loc.x();
+      out[1] = loc.y();
+      out[2] = in[2] + origin_alt;
+    }
+    return;
+  }
+
+  utm_projection const proj(crs);
+  parallel_for_blocks(num_points, [&](size_t begin, size_t end)
+  {
+    for( size_t i = begin; i < end; ++i )
+    {
+      double const* const in = local + 3 * i;
+      double* const out = lon_lat_alt + 3 * i;
+      proj.inverse(in[0] + origin.x(), in[1] + origin.y(), out[0], out[1]);
+      out[2] = in[2] + origin_alt;
+    }
+  });
+}
+
+
 /// Read a local_geo_cs from a text file
 void
 read_local_geo_cs_from_file(local_geo_cs& lgcs,
@@ -211,21 +542,84 @@ initialize_cameras_with_metadata(std::map<vital::frame_id_t,
       update_local_origin = true;
     }
   }
+  // Gather the sensor locations given in geographic coordinates so that they
+  // are converted to local coordinates in one batch.  Locations in other
+  // coordinate systems fall back to converting one point at a time.
+  std::vector<vital::video_metadata const*> md_vec;
+  std::vector<vital::frame_id_t> frames;
+  std::vector<double> lon_lat_alt;
+  std::vector<size_t> batch_index;
+  std::vector<vector_3d> centers;
+  std::vector<char> has_center;
+  md_vec.reserve(md_map.size());
+  frames.reserve(md_map.size());
   for(auto const& p : md_map)
   {
-    auto md = p.second;
+    auto const& md = p.second;
     if( !md )
     {
       continue;
     }
-    lgcs.update_camera(*md, active_cam, rot_offset);
+    md_vec.push_back(md.get());
+    frames.push_back(p.first);
+    centers.push_back(vector_3d(0, 0, 0));
+    has_center.push_back(0);
+    if( md->has( vital::VITAL_META_SENSOR_LOCATION) &&
+        md->has( vital::VITAL_META_SENSOR_ALTITUDE) )
+    {
+      double alt = md->find( vital::VITAL_META_SENSOR_ALTITUDE ).as_double();
+      vital::geo_point gloc;
+      md->find( vital::VITAL_META_SENSOR_LOCATION ).data( gloc );
+      has_center.back() = 1;
+      if( gloc.crs() == SRID::lat_lon_WGS84 )
+      {
+        vector_2d const& loc = gloc.location();
+        lon_lat_alt.push_back(loc.x());
+        lon_lat_alt.push_back(loc.y());
+        lon_lat_alt.push_back(alt);
+        batch_index.push_back(centers.size() - 1);
+      }
+      else
+      {
+        // get the location in the same UTM zone as the origin
+        vector_2d loc = gloc.location(lgcs.origin().crs());
+        loc -= lgcs.origin().location();
+        centers.back() = vector_3d(loc.x(), loc.y(),
+                                   alt - lgcs.origin_altitude());
+      }
+    }
+  }
+
+  if( !batch_index.empty() )
+  {
+    std::vector<double> local(lon_lat_alt.size());
+    geographic_to_local(lgcs, lon_lat_alt.data(), batch_index.size(),
+                        local.data());
+    for( size_t i = 0; i < batch_index.size(); ++i )
+    {
+      centers[batch_index[i]] = vector_3d(local[3 * i], local[3 * i + 1],
+                                          local[3 * i + 2]);
+    }
+  }
+
+  // Update the cameras in sequence so that a frame missing a pose carries
+  // over the pose of the previous frame
+  std::vector<simple_camera> cameras;
+  cameras.reserve(md_vec.size());
+  for( size_t i = 0; i < md_vec.size(); ++i )
+  {
+    update_camera_rotation(*md_vec[i], active_cam, rot_offset);
+    if( has_center[i] )
+    {
+      active_cam.set_center(centers[i]);
+    }
     mean += active_cam.center();
-    cam_map[p.first] = camera_sptr(new simple_camera(active_cam));
+    cameras.push_back(active_cam);
   }
 
-  if( update_local_origin )
+  if( update_local_origin && !cameras.empty() )
   {
-    mean /= static_cast<double>(cam_map.size());
+    mean /= static_cast<double>(cameras.size());
     // only use the mean easting and northing
     mean[2] = 0.0;
 
@@ -234,14 +628,17 @@ initialize_cameras_with_metadata(std::map<vital::frame_id_t,
     lgcs.set_origin( geo_point( lgcs.origin().location() + mean_xy, lgcs.origin().crs() ) );
 
     // shift all cameras to the new coordinate system.
-    typedef std::map<frame_id_t, camera_sptr>::value_type cam_map_val_t;
-    for(cam_map_val_t const &p : cam_map)
+    for( auto& cam : cameras )
     {
-      simple_camera* cam = dynamic_cast<simple_camera*>(p.second.get());
-      cam->set_center(cam->get_center() - mean);
+      cam.set_center(cam.get_center() - mean);
     }
   }
 
+  for( size_t i = 0; i < cameras.size(); ++i )
+  {
+    cam_map[frames[i]] = std::make_shared<simple_camera>(cameras[i]);
+  }
+
   return cam_map;
 }
 
@@ -261,19 +658,35 @@ update_metadata_from_cameras(std::map<frame_id_t, camera_sptr> const& cam_map,
     return;
   }
 
-  typedef std::map<frame_id_t, camera_sptr>::value_type cam_map_val_t;
-  for(cam_map_val_t const &p : cam_map)
+  // Locations are written in the CRS of the origin, as in
+  // local_geo_cs::update_metadata, so no geodetic conversion is needed
+  int const crs = lgcs.origin().crs();
+  vector_2d const origin = lgcs.origin().location();
+  for( auto const& p : cam_map )
   {
-    auto active_md = md_map[p.first];
+    auto& active_md = md_map[p.first];
     if( !active_md )
     {
-      md_map[p.first] = active_md = std::make_shared<vital::video_metadata>();
+      active_md = std::make_shared<vital::video_metadata>();
     }
-    auto cam = dynamic_cast<vital::simple_camera*>(p.second.get());
-    if( active_md && cam )
+    if( !p.second )
     {
-      lgcs.update_metadata(*cam, *active_md);
+      continue;
     }
+
+    double yaw, pitch, roll;
+    p.second->rotation().get_yaw_pitch_roll(yaw, pitch, roll);
+    yaw *= rad2deg;
+    pitch *= rad2deg;
+    roll *= rad2deg;
+    vital::vector_3d const c = p.second->center();
+    vital::geo_point gc(vector_2d(c.x(), c.y()) + origin, crs);
+
+    active_md->add( NEW_METADATA_ITEM( VITAL_META_SENSOR_LOCATION, gc ) );
+    active_md->add( NEW_METADATA_ITEM( VITAL_META_SENSOR_ALTITUDE, c.z() ) );
+    active_md->add( NEW_METADATA_ITEM( VITAL_META_SENSOR_YAW_ANGLE, yaw ) );
+    active_md->add( NEW_METADATA_ITEM( VITAL_META_SENSOR_PITCH_ANGLE, pitch ) );
+    active_md->add( NEW_METADATA_ITEM( VITAL_META_SENSOR_ROLL_ANGLE, roll ) );
   }
 }
 
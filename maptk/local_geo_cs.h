@@ -74,7 +74,7 @@ public:
   const vital::geo_point& origin() const { return geo_origin_; }
 
   /// Access the geographic coordinate altituded (in meters)
-  int origin_altitude() const { return origin_alt_; }
+  double origin_altitude() const { return origin_alt_; }
 
   /// Use the pose data provided by metadata to update camera pose
   /**
@@ -99,6 +99,51 @@ private:
 };
 
 
+/// Convert a batch of geographic coordinates into local coordinates
+/**
+ * Converts WGS84 longitude (deg), latitude (deg), and altitude (m) samples
+ * into the local coordinate system.  The UTM projection of the origin zone
+ * is set up once for the whole batch rather than once per point, and large
+ * batches are converted in parallel.  Origins in a polar (UPS) zone are
+ * converted one point at a time through geo_point, as is the whole batch if
+ * the native projection does not agree with geo_point at the first point.
+ *
+ * \param [in]  lgcs         The local geographic coordinate system.  It must
+ *                           have a valid origin.
+ * \param [in]  lon_lat_alt  Interleaved longitude, latitude, and altitude,
+ *                           three values per point.
+ * \param [in]  num_points   The number of points to convert.
+ * \param [out] local        Interleaved local x, y, and z, three values per
+ *                           point.
+ */
+MAPTK_EXPORT
+void
+geographic_to_local(local_geo_cs const& lgcs,
+                    double const* lon_lat_alt,
+                    size_t num_points,
+                    double* local);
+
+
+/// Convert a batch of local coordinates into geographic coordinates
+/**
+ * This is the inverse of geographic_to_local.
+ *
+ * \param [in]  lgcs         The local geographic coordinate system.  It must
+ *                           have a valid origin.
+ * \param [in]  local        Interleaved local x, y, and z, three values per
+ *                           point.
+ * \param [in]  num_points   The number of points to convert.
+ * \param [out] lon_lat_alt  Interleaved WGS84 longitude (deg), latitude (deg),
+ *                           and altitude (m), three values per point.
+ */
+MAPTK_EXPORT
+void
+local_to_geographic(local_geo_cs const& lgcs,
+                    double const* local,
+                    size_t num_points,
+                    double* lon_lat_alt);
+
+
 /// Read a local_geo_cs from a text file
 /**
  * The file format is the geographic origin in latitude (deg), longitude (deg),
@@ -162,6 +207,10 @@ initialize_cameras_with_metadata(std::map<vital::frame_id_t,
  *                            to update.  If no metadata object is found for
  *                            a frame, a new one is created.
  * \note the supplied lgcs must have a valid utm_origin_zone()
+ *
+ * Sensor locations are written in the CRS of the lgcs origin, as by
+ * local_geo_cs::update_metadata.  Any type of camera is used, not only
+ * vital::simple_camera.
  */
 MAPTK_EXPORT
 void
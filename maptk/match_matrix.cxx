@@ -0,0 +1,363 @@
+/*ckwg +29
+ * Copyright 2017 by Kitware, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ *  * Neither name of Kitware, Inc. nor the names of any contributors may be used
+ *    to endorse or promote products derived from this software without specific
+ *    prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * \brief Implementation of parallel and incremental match matrix computation
+ */
+
+#include "match_matrix.h"
+
+#include <vital/util/thread_pool.h>
+
+#include <algorithm>
+#include <future>
+#include <unordered_map>
+#include <utility>
+
+
+namespace kwiver {
+namespace maptk {
+
+namespace {
+
+/// A pair of frames (first <= second) identifying an upper triangle entry
+typedef std::pair<vital::frame_id_t, vital::frame_id_t> frame_pair_t;
+
+/// Hash function for frame pairs
+struct frame_pair_hash
+{
+  size_t operator()(frame_pair_t const& p) const
+  {
+    std::hash<vital::frame_id_t> h;
+    return h(p.first) * 1000003u ^ h(p.second);
+  }
+};
+
+/// Sparse accumulation buffer of match counts
+typedef std::unordered_map<frame_pair_t, long long, frame_pair_hash> count_map_t;
+
+
+/// Add the pairs of frames involving frames [begin, end) of a track
+/**
+ * Every frame in [begin, end) is paired with itself and with every earlier
+ * frame of the track.
+ */
+void
+accumulate_pairs(std::vector<vital::frame_id_t> const& frames,
+                 size_t begin, size_t end, long long delta,
+                 count_map_t& counts)
+{
+  for (size_t j = begin; j < end; ++j)
+  {
+    for (size_t i = 0; i <= j; ++i)
+    {
+      counts[frame_pair_t(frames[i], frames[j])] += delta;
+    }
+  }
+}
+
+
+/// Add a buffer of count changes to the match counts
+/**
+ * Entries whose count drops to zero are removed so that they do not
+ * accumulate as tracks change.
+ */
+void
+merge_counts(count_map_t const& delta, count_map_t& counts)
+{
+  for (auto const& c : delta)
+  {
+    long long& count = counts[c.first];
+    count += c.second;
+    if (count == 0)
+    {
+      counts.erase(c.first);
+    }
+  }
+}
+
+} // end anonymous namespace
+
+
+/// Private implementation class
+class match_matrix_builder::priv
+{
+public:
+  /// The sorted frames of each track accounted for
+  std::unordered_map<vital::track_id_t, std::vector<vital::frame_id_t> > track_frames;
+
+  /// Match counts of the upper triangle of the matrix
+  count_map_t counts;
+};
+
+
+/// Constructor
+match_matrix_builder
+::match_matrix_builder()
+  : d_(new priv)
+{
+}
+
+
+/// Destructor
+match_matrix_builder
+::~match_matrix_builder()
+{
+}
+
+
+/// Update the match matrix to reflect the given set of tracks
+void
+match_matrix_builder
+::update(vital::track_set_sptr tracks)
+{
+  std::vector<vital::track_sptr> const all_tracks =
+    tracks ? tracks->tracks() : std::vector<vital::track_sptr>();
+
+  // Results of one task: changed track frames and the count changes
+  struct task_result
+  {
+    std::vector<std::pair<vital::track_id_t,
+                          std::vector<vital::frame_id_t> > > changed;
+    count_map_t counts;
+  };
+
+  auto process = [this, &all_tracks](size_t begin, size_t end,
+                                     task_result& result)
+  {
+    static const std::vector<vital::frame_id_t> no_frames;
+    for (size_t t = begin; t < end; ++t)
+    {
+      auto const& trk = all_tracks[t];
+      if (!trk)
+      {
+        continue;
+      }
+
+      auto const itr = d_->track_frames.find(trk->id());
+
+      // tracks are changed by extending them, so a track with the same
+      // number of states and extent as before is unchanged; this avoids
+      // visiting its states
+      if (itr != d_->track_frames.end() &&
+          itr->second.size() == trk->size() &&
+          (trk->empty() ||
+           (itr->second.front() == trk->first_frame() &&
+            itr->second.back() == trk->last_frame())))
+      {
+        continue;
+      }
+
+      std::vector<vital::frame_id_t> frames;
+      frames.reserve(trk->size());
+      for (auto const& ts : *trk)
+      {
+        frames.push_back(ts->frame());
+      }
+
+      auto const& old_frames =
+        itr == d_->track_frames.end() ? no_frames : itr->second;
+
+      // length of the common prefix of the old and new frames
+      size_t prefix = 0;
+      size_t const max_prefix = std::min(old_frames.size(), frames.size());
+      while (prefix < max_prefix && old_frames[prefix] == frames[prefix])
+      {
+        ++prefix;
+      }
+      if (prefix == old_frames.size() && prefix == frames.size())
+      {
+        continue;
+      }
+
+      if (prefix == old_frames.size())
+      {
+        // the track was extended; add only pairs with the new frames
+        accumulate_pairs(frames, prefix, frames.size(), 1, result.counts);
+      }
+      else
+      {
+        accumulate_pairs(old_frames, 0, old_frames.size(), -1, result.counts);
+        accumulate_pairs(frames, 0, frames.size(), 1, result.counts);
+      }
+      result.changed.emplace_back(trk->id(), std::move(frames));
+    }
+  };
+
+  // partition the tracks across the thread pool
+  static const size_t min_tracks_per_task = 256;
+  auto& pool = vital::thread_pool::instance();
+  size_t const num_tasks = std::max<size_t>(1,
+    std::min(all_tracks.size() / min_tracks_per_task, pool.num_threads()));
+  size_t const per_task = (all_tracks.size() + num_tasks - 1) / num_tasks;
+  std::vector<task_result> results(num_tasks);
+  if (num_tasks == 1)
+  {
+    process(0, all_tracks.size(), results[0]);
+  }
+  else
+  {
+    std::vector<std::future<void> > jobs;
+    for (size_t i = 0; i < num_tasks; ++i)
+    {
+      size_t const begin = std::min(i * per_task, all_tracks.size());
+      size_t const end = std::min(begin + per_task, all_tracks.size());
+      jobs.push_back(pool.enqueue([&process, &results, i, begin, end]()
+      {
+        process(begin, end, results[i]);
+      }));
+    }
+    for (auto& j : jobs)
+    {
+      j.get();
+    }
+  }
+
+  // subtract tracks that are no longer present
+  if (d_->track_frames.size() > 0)
+  {
+    std::unordered_map<vital::track_id_t, bool> present;
+    present.reserve(all_tracks.size());
+    for (auto const& trk : all_tracks)
+    {
+      if (trk)
+      {
+        present[trk->id()] = true;
+      }
+    }
+    count_map_t removed;
+    for (auto itr = d_->track_frames.begin(); itr != d_->track_frames.end(); )
+    {
+      if (present.count(itr->first) == 0)
+      {
+        accumulate_pairs(itr->second, 0, itr->second.size(), -1, removed);
+        itr = d_->track_frames.erase(itr);
+      }
+      else
+      {
+        ++itr;
+      }
+    }
+    merge_counts(removed, d_->counts);
+  }
+
+  // merge the per-task buffers
+  for (auto& r : results)
+  {
+    merge_counts(r.counts, d_->counts);
+    for (auto& c : r.changed)
+    {
+      d_->track_frames[c.first] = std::move(c.second);
+    }
+  }
+}
+
+
+/// Remove all tracks from the match matrix
+void
+match_matrix_builder
+::clear()
+{
+  d_->track_frames.clear();
+  d_->counts.clear();
+}
+
+
+/// Return the number of tracks currently accounted for
+size_t
+match_matrix_builder
+::num_tracks() const
+{
+  return d_->track_frames.size();
+}
+
+
+/// Return the match matrix
+Eigen::SparseMatrix<unsigned int>
+match_matrix_builder
+::matrix(std::vector<vital::frame_id_t>& frames) const
+{
+  // every frame with a track state has a diagonal entry
+  frames.clear();
+  for (auto const& c : d_->counts)
+  {
+    if (c.first.first == c.first.second && c.second > 0)
+    {
+      frames.push_back(c.first.first);
+    }
+  }
+  std::sort(frames.begin(), frames.end());
+
+  auto index_of = [&frames](vital::frame_id_t f)
+  {
+    return static_cast<int>(std::lower_bound(frames.begin(), frames.end(), f)
+                            - frames.begin());
+  };
+
+  typedef Eigen::Triplet<unsigned int> triplet_t;
+  std::vector<triplet_t> triplets;
+  triplets.reserve(2 * d_->counts.size());
+  for (auto const& c : d_->counts)
+  {
+    if (c.second <= 0)
+    {
+      continue;
+    }
+    int const i = index_of(c.first.first);
+    int const j = index_of(c.first.second);
+    unsigned int const value = static_cast<unsigned int>(c.second);
+    triplets.push_back(triplet_t(i, j, value));
+    if (i != j)
+    {
+      triplets.push_back(triplet_t(j, i, value));
+    }
+  }
+
+  Eigen::SparseMatrix<unsigned int> mm(static_cast<int>(frames.size()),
+                                       static_cast<int>(frames.size()));
+  mm.setFromTriplets(triplets.begin(), triplets.end());
+  return mm;
+}
+
+
+/// Compute the match matrix of a set of tracks in parallel
+Eigen::SparseMatrix<unsigned int>
+match_matrix(vital::track_set_sptr tracks,
+             std::vector<vital::frame_id_t>& frames)
+{
+  match_matrix_builder builder;
+  builder.update(tracks);
+  return builder.matrix(frames);
+}
+
+
+} // end namespace maptk
+} // end namespace kwiver
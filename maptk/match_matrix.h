@@ -0,0 +1,115 @@
+/*ckwg +29
+ * Copyright 2017 by Kitware, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ *  * Neither name of Kitware, Inc. nor the names of any contributors may be used
+ *    to endorse or promote products derived from this software without specific
+ *    prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * \brief Header for parallel and incremental match matrix computation
+ */
+
+#ifndef MAPTK_MATCH_MATRIX_H_
+#define MAPTK_MATCH_MATRIX_H_
+
+#include <maptk/maptk_export.h>
+
+#include <vital/types/track_set.h>
+#include <vital/vital_types.h>
+
+#include <Eigen/Sparse>
+
+#include <memory>
+#include <vector>
+
+
+namespace kwiver {
+namespace maptk {
+
+/// Accumulates a match matrix from tracks and updates it incrementally
+/**
+ * The match matrix has one row and column per frame.  Entry (i, j) is the
+ * number of tracks with states on both frame i and frame j, so the diagonal
+ * holds the number of tracks on each frame.  This matches
+ * kwiver::arrows::match_matrix.
+ *
+ * The builder remembers the frames of each track it has seen.  Each call to
+ * update() visits every track, but only processes the states of tracks that
+ * are new, changed, or removed since the previous call, and tracks that were
+ * only extended contribute just the pairs involving their new frames.  A
+ * track with the same number of states, first frame, and last frame as
+ * before is assumed to be unchanged.  The work is partitioned across the vital
+ * thread pool, with each task accumulating into its own sparse buffer before
+ * the buffers are merged.
+ */
+class MAPTK_EXPORT match_matrix_builder
+{
+public:
+  /// Constructor
+  match_matrix_builder();
+
+  /// Destructor
+  ~match_matrix_builder();
+
+  /// Update the match matrix to reflect the given set of tracks
+  void update(vital::track_set_sptr tracks);
+
+  /// Remove all tracks from the match matrix
+  void clear();
+
+  /// Return the number of tracks currently accounted for
+  size_t num_tracks() const;
+
+  /// Return the match matrix
+  /**
+   * \param [out] frames the frame number of each row and column, in
+   *                     increasing order
+   */
+  Eigen::SparseMatrix<unsigned int>
+  matrix(std::vector<vital::frame_id_t>& frames) const;
+
+private:
+  class priv;
+  const std::unique_ptr<priv> d_;
+};
+
+
+/// Compute the match matrix of a set of tracks in parallel
+/**
+ * \param [in]  tracks the tracks from which to compute the match matrix
+ * \param [out] frames the frame number of each row and column
+ */
+MAPTK_EXPORT
+Eigen::SparseMatrix<unsigned int>
+match_matrix(vital::track_set_sptr tracks,
+             std::vector<vital::frame_id_t>& frames);
+
+
+} // end namespace maptk
+} // end namespace kwiver
+
+#endif // MAPTK_MATCH_MATRIX_H_
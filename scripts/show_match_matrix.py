@@ -37,9 +37,72 @@ from optparse import OptionParser
 import matplotlib.pyplot as plt
 import numpy as np
 import scipy.io as sio
+import scipy.sparse as sp
 import os
 
 
+# Signature at the start of binary CSR match matrix files
+CSR_MAGIC = b"MAPTKMM\n"
+
+# First line of COO match matrix files
+COO_HEADER = "# maptk match matrix coo v1"
+
+# Largest matrix to convert to a dense image; larger ones use a spy plot
+MAX_DENSE_SIZE = 4096
+
+
+def read_csr(filename):
+    """Read a binary CSR match matrix written by maptk_match_matrix"""
+    with open(filename, "rb") as f:
+        if f.read(8) != CSR_MAGIC:
+            raise ValueError("%s is not a CSR match matrix file" % filename)
+        dtype_order = "<"
+        byte_order, version = np.fromfile(f, dtype="<u4", count=2)
+        if byte_order != 0x01020304:
+            dtype_order = ">"
+            version = version.byteswap()
+        if version != 1:
+            raise ValueError("unsupported CSR match matrix version %d"
+                             % version)
+        rows, cols, nnz = [int(v) for v in
+                           np.fromfile(f, dtype=dtype_order + "u8", count=3)]
+        indptr = np.fromfile(f, dtype=dtype_order + "u8", count=rows + 1)
+        indices = np.fromfile(f, dtype=dtype_order + "u4", count=nnz)
+        data = np.fromfile(f, dtype=dtype_order + "u4", count=nnz)
+    return sp.csr_matrix((data, indices, indptr), shape=(rows, cols))
+
+
+def read_coo(filename):
+    """Read a COO triplet text match matrix written by maptk_match_matrix"""
+    with open(filename) as f:
+        if f.readline().strip() != COO_HEADER:
+            raise ValueError("%s is not a COO match matrix file" % filename)
+        rows, cols, nnz = [int(v) for v in f.readline().split()]
+        if nnz > 0:
+            triplets = np.loadtxt(f, dtype=np.int64, ndmin=2)
+        else:
+            triplets = np.zeros((0, 3), dtype=np.int64)
+    return sp.coo_matrix((triplets[:, 2], (triplets[:, 0], triplets[:, 1])),
+                         shape=(rows, cols))
+
+
+def read_match_matrix(filename):
+    """Read a match matrix in any format written by maptk_match_matrix
+
+    Sparse formats are returned as scipy sparse matrices and the dense text
+    format as a numpy array.
+    """
+    with open(filename, "rb") as f:
+        start = f.read(len(COO_HEADER))
+    if start.startswith(CSR_MAGIC):
+        return read_csr(filename)
+    if start == COO_HEADER.encode("ascii"):
+        return read_coo(filename)
+    if filename.endswith(".mtx") or filename.endswith(".mtx.gz"):
+        return sio.mmread(filename)
+    return np.loadtxt(filename)
+
+
 def main():
     usage = "usage: %prog [options] match_matrix_file [saved_plot]"
     description = "Read and display a match matrix file"
@@ -49,12 +112,14 @@ def main():
 
     matrix_filename = args[0]
 
-    ext = os.path.splitext(matrix_filename)[1]
-    if ext == ".mtx" or ext == "mtx.gz":
-        MM = sio.mmread(matrix_filename).toarray()
+    MM = read_match_matrix(matrix_filename)
+    if sp.issparse(MM):
+        if max(MM.shape) <= MAX_DENSE_SIZE:
+            plt.imshow(MM.toarray())
+        else:
+            plt.spy(MM, markersize=1)
     else:
-        MM = np.loadtxt(matrix_filename)
-    plt.imshow(MM)
+        plt.imshow(MM)
 
     output_filename = None
     if len(args) >= 2:
@@ -56,6 +56,7 @@
 #include <kwiversys/CommandLineArguments.hxx>
 
 #include <arrows/core/projected_track_set.h>
+#include <maptk/feature_track_io.h>
 #include <maptk/version.h>
 
 typedef kwiversys::SystemTools     ST;
@@ -250,7 +251,7 @@ static int maptk_main(int argc, char const* argv[])
 
   std::cout << std::endl << "Loading main track set file..." << std::endl;
   std::string track_file = config->get_value<std::string>( "track_file" );
-  tracks = kwiver::vital::read_track_file( track_file );
+  tracks = kwiver::maptk::read_feature_track_file( track_file );
 
   // Generate statistics if enabled
   if( analyze_tracks )
@@ -296,7 +297,7 @@ static int maptk_main(int argc, char const* argv[])
 
       std::cout << std::endl << "Loading comparison track set file..." << std::endl;
 
-      comparison_tracks = kwiver::vital::read_track_file( track_file );
+      comparison_tracks = kwiver::maptk::read_feature_track_file( track_file );
     }
     else if( config->has_value( "comparison_landmark_file" ) &&
              !config->get_value<std::string>( "comparison_landmark_file" ).empty() &&
@@ -97,6 +97,12 @@ static kwiver::vital::config_block_sptr default_config()
                     "\n"
                     "This is optional, leave blank to ignore.");
 
+  config->set_value("input_krtd_cache", false,
+                    "If true, keep a binary cache of the cameras read from "
+                    "input_krtd_files in that directory (as "
+                    "\".maptk_krtd_cache\") so that later runs only parse the "
+                    "KRTD files that changed.");
+
   config->set_value("input_reference_points_file", "",
                     "File containing reference points to use for reprojection "
                     "of results into the geographic coordinate system.\n"
@@ -139,6 +145,12 @@ static kwiver::vital::config_block_sptr default_config()
   config->set_value("output_krtd_dir", "output/krtd",
                     "A directory in which to write the output KRTD files.");
 
+  config->set_value("output_camera_archive", "",
+                    "Path to an optional packed camera archive in which to "
+                    "write all output cameras as a single file.  The archive "
+                    "may be given in place of a KRTD directory when loading "
+                    "cameras in the tools or the GUI.");
+
   auto default_vi = kwiver::vital::algo::video_input::create("image_list");
   kwiver::vital::algo::video_input::get_nested_algo_configuration("video_reader", config, default_vi);
   kwiver::vital::algo::triangulate_landmarks::get_nested_algo_configuration("triangulator", config,
@@ -373,7 +385,8 @@ static int maptk_main(int argc, char const* argv[])
   //
   std::string krtd_dir = config->get_value<std::string>("input_krtd_files");
   kwiver::vital::camera_map::map_camera_t input_cameras =
-    kwiver::maptk::load_input_cameras_krtd(krtd_dir, basename_map);
+    kwiver::maptk::load_input_cameras_krtd(
+      krtd_dir, basename_map, config->get_value<bool>("input_krtd_cache", false));
   if (input_cameras.empty())
   {
     LOG_ERROR(main_logger, "Failed to load input cameras");
@@ -498,6 +511,9 @@ static int maptk_main(int argc, char const* argv[])
     write_ply_file(lm_map, ply_file);
   }
 
+  // POS and KRTD files are written in parallel batches
+  kwiver::maptk::async_output_sink output_sink;
+
   //
   // Write the output POS files
   //
@@ -507,6 +523,8 @@ static int maptk_main(int argc, char const* argv[])
     kwiver::vital::scoped_cpu_timer t( "--> Writing output POS files" );
 
     kwiver::vital::path_t pos_dir = config->get_value<std::string>("output_pos_dir");
+    // create the directory once rather than from every job
+    ST::MakeDirectory(pos_dir);
     // Create updated metadata from adjusted cameras for POS file output.
     typedef std::map<kwiver::vital::frame_id_t, kwiver::vital::video_metadata_sptr> md_map_t;
     md_map_t updated_md_map;
@@ -515,8 +533,12 @@ static int maptk_main(int argc, char const* argv[])
     {
       if (p.second)
       {
+        kwiver::vital::video_metadata_sptr md = p.second;
         kwiver::vital::path_t out_pos_file = pos_dir + "/" + basename_map[p.first] + ".pos";
-        kwiver::vital::write_pos_file( *p.second, out_pos_file);
+        output_sink.add([md, out_pos_file]()
+        {
+          kwiver::vital::write_pos_file( *md, out_pos_file);
+        });
       }
     }
     if (updated_md_map.size() == 0)
@@ -534,17 +556,23 @@ static int maptk_main(int argc, char const* argv[])
     kwiver::vital::scoped_cpu_timer t("--> Writing output KRTD files" );
 
     kwiver::vital::path_t krtd_dir = config->get_value<std::string>("output_krtd_dir");
-    typedef kwiver::vital::camera_map::map_camera_t::value_type cam_map_val_t;
-    for(cam_map_val_t const& p : cam_map->cameras())
-    {
-      if (p.second)
-      {
-        kwiver::vital::path_t out_krtd_file = krtd_dir + "/" + basename_map[p.first] + ".krtd";
-        write_krtd_file( *p.second, out_krtd_file );
-      }
-    }
+    kwiver::maptk::write_output_cameras_krtd(cam_map->cameras(), basename_map,
+                                             krtd_dir, output_sink);
+  }
+
+  if( config->get_value<std::string>("output_camera_archive", "") != "" )
+  {
+    LOG_INFO(main_logger, "Writing output camera archive");
+    kwiver::vital::scoped_cpu_timer t("--> Writing output camera archive" );
+
+    kwiver::vital::path_t archive_file = config->get_value<std::string>("output_camera_archive");
+    kwiver::maptk::write_output_camera_archive(cam_map->cameras(), basename_map,
+                                               archive_file);
   }
 
+  // wait for all of the queued output files to be written
+  output_sink.wait();
+
   return EXIT_SUCCESS;
 }
 
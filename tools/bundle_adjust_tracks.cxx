@@ -35,6 +35,7 @@
 
 #include "tool_common.h"
 
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <sstream>
@@ -72,7 +73,10 @@
 #include <arrows/core/match_matrix.h>
 #include <arrows/core/transform.h>
 
+#include <Eigen/Geometry>
+
 #include <maptk/colorize.h>
+#include <maptk/feature_track_io.h>
 #include <maptk/geo_reference_points_io.h>
 #include <maptk/local_geo_cs.h>
 #include <maptk/version.h>
@@ -113,6 +117,12 @@ static kwiver::vital::config_block_sptr default_config()
                     "option for system initialization, and shadowed by the "
                     "input_reference_points_file when using an st_estimator.");
 
+  config->set_value("input_krtd_cache", false,
+                    "If true, keep a binary cache of the cameras read from "
+                    "input_krtd_files in that directory (as "
+                    "\".maptk_krtd_cache\") so that later runs only parse the "
+                    "KRTD files that changed.");
+
   config->set_value("input_reference_points_file", "",
                     "File containing reference points to use for reprojection "
                     "of results into the geographic coordinate system.\n"
@@ -159,6 +169,12 @@ static kwiver::vital::config_block_sptr default_config()
   config->set_value("output_krtd_dir", "output/krtd",
                     "A directory in which to write the output KRTD files.");
 
+  config->set_value("output_camera_archive", "",
+                    "Path to an optional packed camera archive in which to "
+                    "write all output cameras as a single file.  The archive "
+                    "may be given in place of a KRTD directory when loading "
+                    "cameras in the tools or the GUI.");
+
   config->set_value("camera_sample_rate", "1",
                     "Sub-sample the cameras for by this rate.\n"
                     "Set to 1 to use all cameras, "
@@ -193,6 +209,52 @@ static kwiver::vital::config_block_sptr default_config()
   config->set_value("depthmaps_images_file", "",
                     "An optional file containing paths to depthmaps as image datas.");
 
+  config->set_value("metadata_memory_budget", "0",
+                    "Approximate memory budget in megabytes for video metadata.  "
+                    "When non-zero, video metadata is converted to cameras, "
+                    "and output POS files are generated, in windows of frames "
+                    "sized to fit the budget instead of holding the metadata "
+                    "for every frame at once.  Input cameras are also only "
+                    "copied when needed for the final transform.  This does "
+                    "not bound the memory used by the feature tracks, the "
+                    "cameras, or the bundle adjustment, which are all held in "
+                    "memory as usual.  When initializing cameras from metadata "
+                    "without a geo_origin_file, the origin is computed from "
+                    "the first window rather than from all frames.  "
+                    "Set to 0 to disable.");
+
+  config->set_value("metadata_window_size", "0",
+                    "Number of frames per window when metadata_memory_budget "
+                    "is set.  Set to 0 to derive the window size from "
+                    "metadata_memory_budget.");
+
+  config->set_value("sliding_window:window_size", "0",
+                    "Number of cameras in each local bundle adjustment window.  "
+                    "When non-zero, cameras are added in blocks and only the "
+                    "latest window is initialized and optimized.  The "
+                    "overlapping cameras from earlier windows are optimized "
+                    "with the window, which is then aligned back onto their "
+                    "earlier poses by a similarity transform; those earlier "
+                    "poses are kept.  "
+                    "See sliding_window_bundle_adjust.conf for typical values.  "
+                    "Set to 0 to initialize and optimize all cameras at once.");
+
+  config->set_value("sliding_window:overlap", "10",
+                    "Number of previously optimized cameras included in each "
+                    "window, which tie the window to the earlier ones.  Must "
+                    "be at least 3 and less than window_size.");
+
+  config->set_value("sliding_window:global_refine_interval", "0",
+                    "Run a bundle adjustment over all cameras added so far "
+                    "after this many windows.  Each of these costs as much as "
+                    "a full bundle adjustment of the cameras so far, so the "
+                    "total cost no longer grows linearly with the number of "
+                    "frames.  Set to 0 to disable periodic global refinement.");
+
+  config->set_value("sliding_window:final_global_refine", "false",
+                    "Run a bundle adjustment over all cameras after the last "
+                    "window.  This costs as much as a full bundle adjustment.");
+
   auto default_vi = kwiver::vital::algo::video_input::create("pos");
   kwiver::vital::algo::video_input::get_nested_algo_configuration("video_reader", config, default_vi);
   kwiver::vital::algo::filter_tracks::get_nested_algo_configuration("track_filter", config,
@@ -268,6 +330,24 @@ static bool check_config(kwiver::vital::config_block_sptr config)
   }
 
 
+  if (config->get_value<double>("metadata_memory_budget", 0.0) < 0.0)
+  {
+    MAPTK_CONFIG_FAIL("metadata_memory_budget must be non-negative");
+  }
+  if (config->get_value<size_t>("sliding_window:window_size", 0) > 0 &&
+      config->get_value<size_t>("sliding_window:overlap", 0) >=
+      config->get_value<size_t>("sliding_window:window_size", 0))
+  {
+    MAPTK_CONFIG_FAIL("sliding_window:overlap must be less than sliding_window:window_size");
+  }
+  if (config->get_value<size_t>("sliding_window:window_size", 0) > 0 &&
+      config->get_value<size_t>("sliding_window:overlap", 0) < 3)
+  {
+    MAPTK_CONFIG_FAIL("sliding_window:overlap must be at least 3 to align "
+                      "each window with the previous one");
+  }
+
+
   if (!kwiver::vital::algo::video_input::check_nested_algo_configuration("video_reader", config))
   {
     MAPTK_CONFIG_FAIL("video_reader configuration check failed");
@@ -354,6 +434,297 @@ subsample_cameras(kwiver::vital::camera_map_sptr cameras, unsigned factor)
 }
 
 
+// ------------------------------------------------------------------
+/// Number of frames of metadata to convert or write at once
+/**
+ * Returns zero if the metadata of the whole sequence should be held in
+ * memory.  When only a budget is given, the window size is derived from a
+ * conservative estimate of the memory used by the metadata, basename, and
+ * cameras of one frame.
+ */
+size_t
+metadata_window_size(kwiver::vital::config_block_sptr config)
+{
+  // rough upper bound on the bytes held per frame in a window
+  static const double bytes_per_frame = 16.0 * 1024.0;
+
+  double budget = config->get_value<double>("metadata_memory_budget", 0.0);
+  if (budget <= 0.0)
+  {
+    return 0;
+  }
+  size_t window = config->get_value<size_t>("metadata_window_size", 0);
+  if (window == 0)
+  {
+    window = static_cast<size_t>(budget * 1024.0 * 1024.0 / bytes_per_frame);
+  }
+  return std::max<size_t>(window, 1);
+}
+
+
+// ------------------------------------------------------------------
+/// Copy the parts of tracks that fall within a range of frames
+/**
+ * Tracks with fewer than two states in the range are dropped.
+ */
+kwiver::vital::feature_track_set_sptr
+clip_tracks(std::vector<kwiver::vital::track_sptr> const& tracks,
+            kwiver::vital::frame_id_t first_frame,
+            kwiver::vital::frame_id_t last_frame)
+{
+  std::vector<kwiver::vital::track_sptr> clipped;
+  for (auto const& t : tracks)
+  {
+    if (t->empty() || t->last_frame() < first_frame || t->first_frame() > last_frame)
+    {
+      continue;
+    }
+    auto ct = kwiver::vital::track::create();
+    ct->set_id(t->id());
+    for (auto const& ts : *t)
+    {
+      if (ts->frame() >= first_frame && ts->frame() <= last_frame)
+      {
+        ct->append(ts->clone());
+      }
+    }
+    if (ct->size() > 1)
+    {
+      clipped.push_back(ct);
+    }
+  }
+  return std::make_shared<kwiver::vital::feature_track_set>(clipped);
+}
+
+
+// ------------------------------------------------------------------
+/// Estimate the similarity that maps camera centers onto reference centers
+/**
+ * Returns false if there are fewer than three cameras in common.
+ */
+bool
+align_to_fixed_cameras(kwiver::vital::camera_map::map_camera_t const& cameras,
+                       kwiver::vital::camera_map::map_camera_t const& fixed,
+                       kwiver::vital::similarity_d& sim)
+{
+  std::vector<kwiver::vital::vector_3d> src, dst;
+  for (auto const& p : fixed)
+  {
+    auto itr = cameras.find(p.first);
+    if (itr != cameras.end() && itr->second && p.second)
+    {
+      src.push_back(itr->second->center());
+      dst.push_back(p.second->center());
+    }
+  }
+  if (src.size() < 3)
+  {
+    return false;
+  }
+  Eigen::Matrix<double, 3, Eigen::Dynamic> src_mat(3, src.size());
+  Eigen::Matrix<double, 3, Eigen::Dynamic> dst_mat(3, dst.size());
+  for (size_t i = 0; i < src.size(); ++i)
+  {
+    src_mat.col(i) = src[i];
+    dst_mat.col(i) = dst[i];
+  }
+  sim = kwiver::vital::similarity_d(Eigen::umeyama(src_mat, dst_mat, true));
+  return true;
+}
+
+
+// ------------------------------------------------------------------
+/// Initialize and optimize cameras and landmarks in sliding windows
+/**
+ * Cameras are added in blocks of (window_size - overlap) frames.  Each
+ * window also contains the last \c overlap cameras of the previous window,
+ * which are used to seed the initializer and are optimized with the window.
+ * After optimization the window is aligned back onto the previous poses of
+ * those cameras with a similarity transform, and the previous poses are
+ * kept.  Only tracks observed in the window are used, so the cost of each
+ * window is bounded and the total cost grows roughly linearly with the
+ * sequence length.  The optional periodic and final global refinements are
+ * full bundle adjustments of all cameras solved so far, and are off by
+ * default.
+ *
+ * \returns false if a window could not be aligned with the previous one
+ */
+bool
+sliding_window_bundle_adjust(kwiver::vital::config_block_sptr config,
+                             kwiver::vital::algo::initialize_cameras_landmarks_sptr initializer,
+                             kwiver::vital::algo::bundle_adjust_sptr bundle_adjuster,
+                             kwiver::vital::camera_map_sptr& cam_map,
+                             kwiver::vital::landmark_map_sptr& lm_map,
+                             kwiver::vital::feature_track_set_sptr tracks)
+{
+  typedef kwiver::vital::camera_map::map_camera_t map_camera_t;
+  typedef kwiver::vital::landmark_map::map_landmark_t map_landmark_t;
+
+  size_t const window_size = config->get_value<size_t>("window_size");
+  size_t const overlap = config->get_value<size_t>("overlap");
+  size_t const global_interval = config->get_value<size_t>("global_refine_interval", 0);
+  size_t const step = window_size - overlap;
+
+  // the cameras to solve for, with initial values if any
+  map_camera_t initial_cams;
+  if (cam_map)
+  {
+    initial_cams = cam_map->cameras();
+  }
+  else
+  {
+    for (auto const& id : tracks->all_frame_ids())
+    {
+      initial_cams[id];
+    }
+  }
+  std::vector<kwiver::vital::frame_id_t> frames;
+  frames.reserve(initial_cams.size());
+  for (auto const& p : initial_cams)
+  {
+    frames.push_back(p.first);
+  }
+  if (frames.empty())
+  {
+    return true;
+  }
+
+  // tracks ordered by first frame so that each window only visits the tracks
+  // that may be observed in it
+  std::vector<kwiver::vital::track_sptr> pending = tracks->tracks();
+  pending.erase(std::remove_if(pending.begin(), pending.end(),
+                               [](kwiver::vital::track_sptr const& t)
+                               { return !t || t->empty(); }),
+                pending.end());
+  std::sort(pending.begin(), pending.end(),
+            [](kwiver::vital::track_sptr const& a, kwiver::vital::track_sptr const& b)
+            { return a->first_frame() < b->first_frame(); });
+  auto next_pending = pending.begin();
+  std::vector<kwiver::vital::track_sptr> active;
+
+  map_camera_t solved_cams;
+  map_landmark_t solved_lms;
+  if (lm_map)
+  {
+    solved_lms = lm_map->landmarks();
+  }
+
+  size_t num_windows = 0;
+  for (size_t end = std::min(window_size, frames.size()); ;
+       end = std::min(end + step, frames.size()))
+  {
+    size_t const begin = end > window_size ? end - window_size : 0;
+    kwiver::vital::frame_id_t const first_frame = frames[begin];
+    kwiver::vital::frame_id_t const last_frame = frames[end - 1];
+
+    // update the tracks that overlap this window
+    while (next_pending != pending.end() &&
+           (*next_pending)->first_frame() <= last_frame)
+    {
+      active.push_back(*next_pending++);
+    }
+    active.erase(std::remove_if(active.begin(), active.end(),
+                                [first_frame](kwiver::vital::track_sptr const& t)
+                                { return t->last_frame() < first_frame; }),
+                 active.end());
+    auto win_tracks = clip_tracks(active, first_frame, last_frame);
+
+    // previously solved cameras are fixed, the rest use initial values
+    map_camera_t win_cams, fixed_cams;
+    for (size_t i = begin; i < end; ++i)
+    {
+      auto itr = solved_cams.find(frames[i]);
+      if (itr != solved_cams.end() && itr->second)
+      {
+        fixed_cams[frames[i]] = itr->second;
+        win_cams[frames[i]] = itr->second->clone();
+      }
+      else
+      {
+        win_cams[frames[i]] = initial_cams[frames[i]];
+      }
+    }
+    map_landmark_t win_lms;
+    for (auto const& t : win_tracks->tracks())
+    {
+      auto itr = solved_lms.find(static_cast<kwiver::vital::landmark_id_t>(t->id()));
+      if (itr != solved_lms.end())
+      {
+        win_lms.insert(*itr);
+      }
+    }
+
+    LOG_INFO(main_logger, "Optimizing window of frames " << first_frame
+                          << " to " << last_frame << " with "
+                          << win_tracks->size() << " tracks");
+    kwiver::vital::camera_map_sptr win_cam_map =
+      std::make_shared<kwiver::vital::simple_camera_map>(win_cams);
+    kwiver::vital::landmark_map_sptr win_lm_map =
+      std::make_shared<kwiver::vital::simple_landmark_map>(win_lms);
+    initializer->initialize(win_cam_map, win_lm_map, win_tracks);
+    bundle_adjuster->optimize(win_cam_map, win_lm_map, win_tracks);
+
+    // align the window back onto the earlier poses of the overlapping
+    // cameras; without this the window would be in its own gauge
+    if (!fixed_cams.empty())
+    {
+      kwiver::vital::similarity_d sim;
+      if (!align_to_fixed_cameras(win_cam_map->cameras(), fixed_cams, sim))
+      {
+        LOG_ERROR(main_logger, "Window of frames " << first_frame << " to "
+                               << last_frame << " shares fewer than 3 solved "
+                               "cameras with the previous window");
+        return false;
+      }
+      win_cam_map = kwiver::arrows::transform(win_cam_map, sim);
+      win_lm_map = kwiver::arrows::transform(win_lm_map, sim);
+    }
+    for (auto const& p : win_cam_map->cameras())
+    {
+      if (fixed_cams.count(p.first) == 0)
+      {
+        solved_cams[p.first] = p.second;
+      }
+    }
+    for (auto const& p : win_lm_map->landmarks())
+    {
+      solved_lms[p.first] = p.second;
+    }
+    ++num_windows;
+
+    bool const last_window = end == frames.size();
+    if (!last_window && global_interval > 0 && num_windows % global_interval == 0)
+    {
+      kwiver::vital::scoped_cpu_timer t( "Sliding window global refinement" );
+      // observations on frames without a solved camera yet are ignored by the
+      // bundle adjuster, so the tracks need not be clipped (which would copy
+      // every state seen so far at each refinement)
+      kwiver::vital::camera_map_sptr all_cams =
+        std::make_shared<kwiver::vital::simple_camera_map>(solved_cams);
+      kwiver::vital::landmark_map_sptr all_lms =
+        std::make_shared<kwiver::vital::simple_landmark_map>(solved_lms);
+      bundle_adjuster->optimize(all_cams, all_lms, tracks);
+      solved_cams = all_cams->cameras();
+      solved_lms = all_lms->landmarks();
+    }
+    if (last_window)
+    {
+      break;
+    }
+  }
+
+  cam_map = std::make_shared<kwiver::vital::simple_camera_map>(solved_cams);
+  lm_map = std::make_shared<kwiver::vital::simple_landmark_map>(solved_lms);
+
+  if (config->get_value<bool>("final_global_refine", false))
+  {
+    kwiver::vital::scoped_cpu_timer t( "Sliding window final refinement" );
+    bundle_adjuster->optimize(cam_map, lm_map, tracks);
+  }
+  return true;
+}
+
+
 // Generic configuration based input camera load function.
 //
 // The local_cs and input_cameras objects may or may not be updated based on
@@ -386,7 +757,8 @@ bool load_input_cameras(kwiver::vital::config_block_sptr config,
   else if (config->get_value<std::string>("input_krtd_files", "") != "")
   {
     std::string krtd_dir = config->get_value<std::string>("input_krtd_files");
-    input_cameras = kwiver::maptk::load_input_cameras_krtd(krtd_dir, basename_map);
+    input_cameras = kwiver::maptk::load_input_cameras_krtd(
+      krtd_dir, basename_map, config->get_value<bool>("input_krtd_cache", false));
     if (input_cameras.empty())
     {
       return false;
@@ -511,7 +883,7 @@ static int maptk_main(int argc, char const* argv[])
   //
   std::string track_file = config->get_value<std::string>("input_track_file");
   LOG_INFO(main_logger, "loading track file: " << track_file);
-  kwiver::vital::feature_track_set_sptr tracks = kwiver::vital::read_feature_track_file(track_file);
+  kwiver::vital::feature_track_set_sptr tracks = kwiver::maptk::read_feature_track_file(track_file);
 
   LOG_DEBUG(main_logger, "loaded "<<tracks->size()<<" tracks");
   if( tracks->size() == 0 )
@@ -535,7 +907,7 @@ static int maptk_main(int argc, char const* argv[])
       std::string out_track_file = config->get_value<std::string>("filtered_track_file");
       if( out_track_file != "" )
       {
-        kwiver::vital::write_feature_track_file(tracks, out_track_file);
+        kwiver::maptk::write_feature_track_file(tracks, out_track_file);
       }
     }
 
@@ -548,11 +920,70 @@ static int maptk_main(int argc, char const* argv[])
     }
   }
 
+  //
+  // Create the local coordinate system
+  //
+  kwiver::maptk::local_geo_cs local_cs;
+  bool geo_origin_loaded_from_file = false;
+  if (config->get_value<std::string>("geo_origin_file", "") != "")
+  {
+    kwiver::vital::path_t geo_origin_file = config->get_value<kwiver::vital::path_t>("geo_origin_file");
+    // load the coordinates from a file if it exists
+    if (ST::FileExists(geo_origin_file, true))
+    {
+      read_local_geo_cs_from_file(local_cs, geo_origin_file);
+      LOG_INFO(main_logger, "Loaded origin point from: " << geo_origin_file);
+      geo_origin_loaded_from_file = true;
+    }
+  }
+
   //
   // Read the Video (metadata only, no pixels)
   //
+  // With a metadata window, the metadata is converted into cameras one window
+  // of frames at a time and then released.  Otherwise the metadata for all
+  // frames is kept so cameras can be initialized from the whole sequence.
+  //
+  size_t const frame_window = metadata_window_size(config);
+  bool const init_from_metadata =
+    config->get_value<bool>("init_cameras_with_metadata", false);
   std::map<kwiver::vital::frame_id_t, kwiver::vital::video_metadata_sptr> md_map;
   std::map<kwiver::vital::frame_id_t, std::string> basename_map;
+  kwiver::vital::camera_map::map_camera_t input_cameras;
+
+  // carried between windows so that frames without a pose reuse the pose of
+  // the last camera in the previous window
+  kwiver::vital::simple_camera window_base_camera =
+    base_camera_from_config(config->subblock("base_camera"));
+  kwiver::vital::rotation_d const ins_rot_offset =
+    config->get_value<kwiver::vital::rotation_d>("ins:rotation_offset",
+                                                 kwiver::vital::rotation_d());
+  auto flush_metadata_window = [&]()
+  {
+    if (md_map.empty())
+    {
+      return;
+    }
+    auto window_cams =
+      kwiver::maptk::initialize_cameras_with_metadata(md_map, window_base_camera,
+                                                      local_cs, ins_rot_offset);
+    for (auto const& p : window_cams)
+    {
+      auto cam = std::dynamic_pointer_cast<kwiver::vital::simple_camera>(p.second);
+      if (cam)
+      {
+        window_base_camera = *cam;
+      }
+      input_cameras.insert(p);
+    }
+    md_map.clear();
+  };
+
+  if (frame_window > 0)
+  {
+    LOG_INFO( main_logger, "Converting metadata in windows of "
+                           << frame_window << " frames" );
+  }
 
   LOG_INFO( main_logger, "Reading Video" );
   std::string video_source = config->get_value<std::string>("video_source");
@@ -568,28 +999,18 @@ static int maptk_main(int argc, char const* argv[])
     }
     auto md = md_vec[0];
     auto frame = ts.get_frame();
-    md_map[frame] = md;
     std::string basename = kwiver::vital::basename_from_metadata(md, frame);
     basename_map[frame] = basename;
-  }
-
-  //
-  // Create the local coordinate system
-  //
-  kwiver::maptk::local_geo_cs local_cs;
-  bool geo_origin_loaded_from_file = false;
-  if (config->get_value<std::string>("geo_origin_file", "") != "")
-  {
-    kwiver::vital::path_t geo_origin_file = config->get_value<kwiver::vital::path_t>("geo_origin_file");
-    // load the coordinates from a file if it exists
-    if (ST::FileExists(geo_origin_file, true))
+    if( frame_window == 0 || init_from_metadata )
     {
-      read_local_geo_cs_from_file(local_cs, geo_origin_file);
-      LOG_INFO(main_logger, "Loaded origin point from: " << geo_origin_file);
-      geo_origin_loaded_from_file = true;
+      md_map[frame] = md;
+    }
+    if( frame_window > 0 && init_from_metadata && md_map.size() >= frame_window )
+    {
+      flush_metadata_window();
     }
   }
-
+  video_reader->close();
 
   //
   // Initialize input and main cameras
@@ -599,20 +1020,42 @@ static int maptk_main(int argc, char const* argv[])
   // camera files.
   //
   // Config check above ensures validity + mutual exclusivity of these options
-  kwiver::vital::camera_map::map_camera_t input_cameras;
-  if (!load_input_cameras(config, md_map, basename_map, local_cs, input_cameras))
+  if( frame_window > 0 && init_from_metadata )
+  {
+    flush_metadata_window();
+    if (input_cameras.empty())
+    {
+      LOG_ERROR(main_logger, "Failed to load input cameras");
+      return EXIT_FAILURE;
+    }
+  }
+  else if (!load_input_cameras(config, md_map, basename_map, local_cs, input_cameras))
   {
     LOG_ERROR(main_logger, "Failed to load input cameras");
     return EXIT_FAILURE;
   }
+  // the metadata is no longer needed
+  md_map.clear();
 
   // Copy input cameras into main camera map
   kwiver::vital::camera_map::map_camera_t cameras;
   kwiver::vital::landmark_map_sptr lm_map;
+  // The input cameras are only needed after optimization to estimate a
+  // transform when there are no reference points.  With a metadata window,
+  // avoid cloning them when they will not be used.
+  bool const keep_input_cameras =
+    frame_window == 0 ||
+    (st_estimator &&
+     config->get_value<std::string>("input_reference_points_file", "") == "");
+  if (!keep_input_cameras)
+  {
+    cameras.swap(input_cameras);
+  }
   kwiver::vital::camera_map_sptr input_cam_map(new kwiver::vital::simple_camera_map(input_cameras));
-  if (input_cameras.size() != 0)
+  input_cameras.clear();
+  if (input_cam_map->size() != 0)
   {
-    for(kwiver::vital::camera_map::map_camera_t::value_type &v : input_cameras)
+    for(auto const& v : input_cam_map->cameras())
     {
       cameras[v.first] = v.second->clone();
     }
@@ -717,6 +1160,26 @@ static int maptk_main(int argc, char const* argv[])
   //
   // Initialize cameras and landmarks
   //
+  // The sliding window driver initializes and optimizes in the same pass.
+  //
+  bool const sliding_window =
+    config->get_value<size_t>("sliding_window:window_size", 0) > 0;
+  if (sliding_window)
+  {
+    kwiver::vital::scoped_cpu_timer t( "Sliding window bundle adjustment" );
+    if (!sliding_window_bundle_adjust(config->subblock("sliding_window"),
+                                      initializer, bundle_adjuster,
+                                      cam_map, lm_map, tracks))
+    {
+      return EXIT_FAILURE;
+    }
+
+    double end_rmse = kwiver::arrows::reprojection_rmse(cam_map->cameras(),
+                                                       lm_map->landmarks(),
+                                                       tracks->tracks());
+    LOG_DEBUG(main_logger, "final reprojection RMSE: " << end_rmse);
+  }
+  else
   {
     kwiver::vital::scoped_cpu_timer t( "Initializing cameras and landmarks" );
     initializer->initialize(cam_map, lm_map, tracks);
@@ -725,7 +1188,8 @@ static int maptk_main(int argc, char const* argv[])
   //
   // Run bundle adjustment
   //
-  { // scope block
+  if (!sliding_window)
+  {
     kwiver::vital::scoped_cpu_timer t( "Tool-level SBA algorithm" );
 
     double init_rmse = kwiver::arrows::reprojection_rmse(cam_map->cameras(),
@@ -828,6 +1292,9 @@ static int maptk_main(int argc, char const* argv[])
     write_ply_file(lm_map, ply_file);
   }
 
+  // POS and KRTD files are written in parallel batches
+  kwiver::maptk::async_output_sink output_sink;
+
   //
   // Write the output POS files
   //
@@ -837,19 +1304,38 @@ static int maptk_main(int argc, char const* argv[])
     kwiver::vital::scoped_cpu_timer t( "--> Writing output POS files" );
 
     kwiver::vital::path_t pos_dir = config->get_value<std::string>("output_pos_dir");
+    // create the directory once rather than from every job
+    ST::MakeDirectory(pos_dir);
     // Create updated metadata from adjusted cameras for POS file output.
+    // With a metadata window this is done one window of cameras at a time.
     typedef std::map<kwiver::vital::frame_id_t, kwiver::vital::video_metadata_sptr> md_map_t;
-    md_map_t updated_md_map;
-    update_metadata_from_cameras(cam_map->cameras(), local_cs, updated_md_map);
-    for(auto const& p : updated_md_map)
+    auto const all_cams = cam_map->cameras();
+    size_t num_written = 0;
+    for(auto itr = all_cams.begin(); itr != all_cams.end(); )
     {
-      if (p.second)
+      kwiver::vital::camera_map::map_camera_t window_cams;
+      while( itr != all_cams.end() &&
+             (frame_window == 0 || window_cams.size() < frame_window) )
       {
-        kwiver::vital::path_t out_pos_file = pos_dir + "/" + basename_map[p.first] + ".pos";
-        kwiver::vital::write_pos_file( *p.second, out_pos_file);
+        window_cams.insert(*itr++);
       }
+      md_map_t updated_md_map;
+      update_metadata_from_cameras(window_cams, local_cs, updated_md_map);
+      for(auto const& p : updated_md_map)
+      {
+        if (p.second)
+        {
+          kwiver::vital::video_metadata_sptr md = p.second;
+          kwiver::vital::path_t out_pos_file = pos_dir + "/" + basename_map[p.first] + ".pos";
+          output_sink.add([md, out_pos_file]()
+          {
+            kwiver::vital::write_pos_file( *md, out_pos_file);
+          });
+        }
+      }
+      num_written += updated_md_map.size();
     }
-    if (updated_md_map.size() == 0)
+    if (num_written == 0)
     {
       LOG_WARN(main_logger, "INS map empty, no output POS files written");
     }
@@ -872,10 +1358,11 @@ static int maptk_main(int argc, char const* argv[])
     {
       if (ST::GetFilenameLastExtension(files[i]) == ".krtd")
       {
-        ST::RemoveFile(files[i]);
+        output_sink.remove_file(files[i]);
       }
     }
-
+    // finish removing files before writing any new ones
+    output_sink.wait();
   }
 
   if( config->has_value("output_krtd_dir") )
@@ -884,17 +1371,23 @@ static int maptk_main(int argc, char const* argv[])
     kwiver::vital::scoped_cpu_timer t("--> Writing output KRTD files" );
 
     kwiver::vital::path_t krtd_dir = config->get_value<std::string>("output_krtd_dir");
-    typedef kwiver::vital::camera_map::map_camera_t::value_type cam_map_val_t;
-    for(cam_map_val_t const& p : cam_map->cameras())
-    {
-      if (p.second)
-      {
-        kwiver::vital::path_t out_krtd_file = krtd_dir + "/" + basename_map[p.first] + ".krtd";
-        write_krtd_file( *p.second, out_krtd_file );
-      }
-    }
+    kwiver::maptk::write_output_cameras_krtd(cam_map->cameras(), basename_map,
+                                             krtd_dir, output_sink);
+  }
+
+  if( config->get_value<std::string>("output_camera_archive", "") != "" )
+  {
+    LOG_INFO(main_logger, "Writing output camera archive");
+    kwiver::vital::scoped_cpu_timer t("--> Writing output camera archive" );
+
+    kwiver::vital::path_t archive_file = config->get_value<std::string>("output_camera_archive");
+    kwiver::maptk::write_output_camera_archive(cam_map->cameras(), basename_map,
+                                               archive_file);
   }
 
+  // wait for all of the queued output files to be written
+  output_sink.wait();
+
   return EXIT_SUCCESS;
 }
 
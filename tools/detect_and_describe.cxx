@@ -36,6 +36,7 @@
 
 #include "tool_common.h"
 
+#include <atomic>
 #include <deque>
 #include <iostream>
 #include <fstream>
@@ -61,7 +62,6 @@
 #include <vital/plugin_loader/plugin_manager.h>
 #include <vital/util/get_paths.h>
 #include <vital/util/thread_pool.h>
-#include <vital/util/transform_image.h>
 #include <vital/video_metadata/video_metadata_util.h>
 
 #include <kwiversys/SystemTools.hxx>
@@ -105,6 +105,15 @@ static kwiver::vital::config_block_sptr default_config()
                     "warning when a single-channel mask is provided. If this "
                     "is false we error upon seeing a multi-channel mask "
                     "image.");
+  config->set_value("frame_index_file", "",
+                    "Optional path to a cache of the timestamps of every "
+                    "frame in ``video_source``. If this file exists and is "
+                    "newer than the video it provides the frame count up "
+                    "front, so the mask list can be validated before "
+                    "processing begins. Otherwise the video is read in a "
+                    "single streaming pass, mask images are validated as "
+                    "frames arrive, and the index is written here for later "
+                    "runs. Leave blank to disable the cache.");
   config->set_value("features_dir", "",
                     "Path to a directory in which to write the output feature "
                     "detection and description files");
@@ -158,6 +167,25 @@ static bool check_config(kwiver::vital::config_block_sptr config)
     }
   }
 
+  // A given frame index file is invalid if it names a directory, or if its
+  // parent path does not exist.
+  if ( config->has_value("frame_index_file")
+    && config->get_value<std::string>("frame_index_file") != "" )
+  {
+    kwiver::vital::config_path_t fp = config->get_value<kwiver::vital::config_path_t>("frame_index_file");
+    if ( ST::FileIsDirectory( fp ) )
+    {
+      MAPTK_CONFIG_FAIL("Given frame index file is a directory! "
+                        << "(Given: " << fp << ")");
+    }
+    else if ( ST::GetFilenamePath( fp ) != "" &&
+              ! ST::FileIsDirectory( ST::GetFilenamePath( fp ) ))
+    {
+      MAPTK_CONFIG_FAIL("Given frame index file does not have a valid "
+                        << "parent path! (Given: " << fp << ")");
+    }
+  }
+
   if ( ! config->has_value("video_source") ||
       config->get_value<std::string>("video_source") == "")
   {
@@ -254,42 +282,6 @@ bool valid_feature_file_exists( std::string const& filepath,
 }
 
 
-/// Extract the mask image from the container, invert, and repackage
-kwiver::vital::image_container_sptr
-invert_mask_image(kwiver::vital::image_container_sptr mask)
-{
-  LOG_DEBUG( main_logger,
-             "Inverting mask image pixels" );
-  kwiver::vital::image_of<bool> mask_image;
-  kwiver::vital::cast_image( mask->get_image(), mask_image );
-  kwiver::vital::transform_image( mask_image, [] (bool b) { return !b; } );
-  LOG_DEBUG( main_logger,
-             "Inverting mask image pixels -- Done" );
-  return std::make_shared<kwiver::vital::simple_image_container>( mask_image );
-}
-
-
-/// Validate a mask image according to the expected number of channels.
-bool validate_mask_image( kwiver::vital::image_container_sptr mask,
-                          bool expect_multichannel_masks=false )
-{
-  // error out if we are not expecting a multi-channel mask
-  if( !expect_multichannel_masks && mask->depth() > 1 )
-  {
-    LOG_ERROR( main_logger,
-               "Encounted multi-channel mask image!" );
-    return false;
-  }
-  else if( expect_multichannel_masks && mask->depth() == 1 )
-  {
-    LOG_WARN( main_logger,
-              "Expecting multi-channel masks but received one that was "
-              "single-channel." );
-  }
-  return true;
-}
-
-
 // ------------------------------------------------------------------
 static int maptk_main(int argc, char const* argv[])
 {
@@ -405,6 +397,7 @@ static int maptk_main(int argc, char const* argv[])
   //  - filepath validity checked above
   std::string video_source = config->get_value<std::string>("video_source");
   std::string mask_list_file = config->get_value<std::string>("mask_list_file");
+  std::string frame_index_file = config->get_value<std::string>("frame_index_file");
   bool invert_masks = config->get_value<bool>("invert_masks");
   bool expect_multichannel_masks = config->get_value<bool>("expect_multichannel_masks");
   std::string features_dir = config->get_value<std::string>("features_dir");
@@ -414,17 +407,13 @@ static int maptk_main(int argc, char const* argv[])
   LOG_INFO( main_logger, "Reading Video" );
   video_reader->open(video_source);
 
-  // Pre-scan the video to get an accurate frame count
-  // We may wish to remove this later if we start operating on live streams
-  kwiver::vital::timestamp ts;
+  // Use a cached frame index, if available, to get an accurate frame count.
+  // Otherwise the video is read in a single pass, which also allows
+  // operating on live streams, and the frame timestamps are collected
+  // along the way to build the index.
   std::vector<kwiver::vital::timestamp> timestamps;
-  while( video_reader->next_frame(ts) )
-  {
-    timestamps.push_back(ts);
-  }
-  // close and re-open to return to the video start
-  video_reader->close();
-  video_reader->open(video_source);
+  bool const have_frame_index =
+    kwiver::maptk::read_frame_index(frame_index_file, video_source, timestamps);
 
 
   // Create mask image list if a list file was given, else fill list with empty
@@ -451,8 +440,9 @@ static int maptk_main(int argc, char const* argv[])
         throw kwiver::vital::path_not_exists( mask_files[mask_files.size()-1] );
       }
     }
-    // Check that image/mask list sizes are the same
-    if( timestamps.size() != mask_files.size() )
+    // Check that image/mask list sizes are the same.  Without a frame index
+    // this is checked lazily as frames are read.
+    if( have_frame_index && timestamps.size() != mask_files.size() )
     {
       throw kwiver::vital::invalid_value("video and mask file lists have "
                                          "different frame counts");
@@ -481,6 +471,9 @@ static int maptk_main(int argc, char const* argv[])
 
   std::mutex video_mutex;
 
+  // Set when a frame fails to process, as opposed to the video ending
+  std::atomic<bool> frame_failed(false);
+
   // This lambda function runs in a thread to read the video and launch processing jobs
   auto handle_frame = [&] ()
   {
@@ -498,6 +491,10 @@ static int maptk_main(int argc, char const* argv[])
       // get the frame now even though we do not yet know if it will be needed.
       // This way we can release the lock and let another thread increment the video.
       image = video_reader->frame_image();
+      if( !have_frame_index )
+      {
+        timestamps.push_back(ts);
+      }
     }
 
     kwiver::vital::video_metadata_sptr md;
@@ -523,16 +520,23 @@ static int maptk_main(int argc, char const* argv[])
     kwiver::vital::image_container_sptr mask, converted_mask;
     if( use_masks )
     {
+      if( ts.get_frame() >= static_cast<kwiver::vital::frame_id_t>(mask_files.size()) )
+      {
+        LOG_ERROR( main_logger, "Video has more frames than the mask file list" );
+        frame_failed = true;
+        return false;
+      }
       mask = image_reader->load( mask_files[ts.get_frame()] );
 
-      if( !validate_mask_image( mask, expect_multichannel_masks ) )
+      if( !kwiver::maptk::validate_mask_image( mask, expect_multichannel_masks ) )
       {
+        frame_failed = true;
         return false;
       }
 
       if( invert_masks )
       {
-        mask = invert_mask_image( mask );
+        mask = kwiver::maptk::invert_mask_image( mask );
       }
 
       converted_mask = image_converter->convert( mask );
@@ -562,6 +566,7 @@ static int maptk_main(int argc, char const* argv[])
       if( !ST::MakeDirectory( fd_dir ) )
       {
         LOG_ERROR( main_logger, "Unable to create directory: " << fd_dir );
+        frame_failed = true;
         return false;
       }
     }
@@ -603,6 +608,26 @@ static int maptk_main(int argc, char const* argv[])
     frame_status_queue.pop_front();
   }
 
+  // Do not write a frame index from a partial read of the video
+  if( frame_failed )
+  {
+    LOG_ERROR( main_logger, "Feature detection failed" );
+    return EXIT_FAILURE;
+  }
+
+  if( !have_frame_index )
+  {
+    if( use_masks && timestamps.size() != mask_files.size() )
+    {
+      throw kwiver::vital::invalid_value("video and mask file lists have "
+                                         "different frame counts");
+    }
+    if( !frame_index_file.empty() )
+    {
+      kwiver::maptk::write_frame_index(frame_index_file, timestamps);
+    }
+  }
+
   return EXIT_SUCCESS;
 }
 
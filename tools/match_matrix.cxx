@@ -33,6 +33,8 @@
  * \brief compute a match matrix from a track file
  */
 
+#include <cstdint>
+#include <cstdlib>
 #include <iostream>
 #include <fstream>
 #include <exception>
@@ -41,7 +43,8 @@
 
 #include <unsupported/Eigen/SparseExtra>
 
-#include <arrows/core/match_matrix.h>
+#include <maptk/feature_track_io.h>
+#include <maptk/match_matrix.h>
 #include <vital/exceptions.h>
 #include <vital/io/track_set_io.h>
 
@@ -79,12 +82,147 @@ write_frame_numbers(std::ostream& os,
 
 
 // ------------------------------------------------------------------
+/// The match matrix in row major order for writing one row at a time
+typedef Eigen::SparseMatrix<unsigned int, Eigen::RowMajor> row_matrix_t;
+
+
+// ------------------------------------------------------------------
+/// Return true if entry (i, j) should be written for the given band width
+inline bool
+in_band(Eigen::Index i, Eigen::Index j, unsigned band)
+{
+  return band == 0 || std::abs(static_cast<long long>(i - j)) <= band;
+}
+
+
+// ------------------------------------------------------------------
+/// Write the match matrix as dense text, one row per line
+/**
+ * Rows are expanded one at a time so the dense matrix is never held in
+ * memory.  Entries outside the band are written as zero.
+ */
 void
 write_match_matrix(std::ostream& os,
-                   const Eigen::SparseMatrix<unsigned int>& mm)
+                   const row_matrix_t& mm,
+                   unsigned band = 0)
+{
+  std::vector<unsigned int> row(mm.cols());
+  for( Eigen::Index i = 0; i < mm.outerSize(); ++i )
+  {
+    std::fill(row.begin(), row.end(), 0);
+    for( row_matrix_t::InnerIterator it(mm, i); it; ++it )
+    {
+      if( in_band(i, it.col(), band) )
+      {
+        row[it.col()] = it.value();
+      }
+    }
+    for( Eigen::Index j = 0; j < mm.cols(); ++j )
+    {
+      os << (j ? " " : "") << row[j];
+    }
+    os << "\n";
+  }
+  os.flush();
+}
+
+
+// ------------------------------------------------------------------
+/// Count the non-zero entries of each row that fall within the band
+std::vector<uint64_t>
+band_row_offsets(const row_matrix_t& mm, unsigned band)
 {
-  // TODO write out the matrix in a more memory efficient way
-  os << Eigen::MatrixXd(mm) << std::endl;
+  std::vector<uint64_t> offsets(mm.outerSize() + 1, 0);
+  for( Eigen::Index i = 0; i < mm.outerSize(); ++i )
+  {
+    uint64_t count = 0;
+    for( row_matrix_t::InnerIterator it(mm, i); it; ++it )
+    {
+      count += in_band(i, it.col(), band) ? 1 : 0;
+    }
+    offsets[i + 1] = offsets[i] + count;
+  }
+  return offsets;
+}
+
+
+// ------------------------------------------------------------------
+/// Write the match matrix as COO triplet text
+/**
+ * The format is a header line, a line with the number of rows, columns,
+ * and non-zero entries, followed by one "row col value" line per non-zero
+ * entry with zero-based indices, in row major order.
+ */
+void
+write_match_matrix_coo(std::ostream& os,
+                       const row_matrix_t& mm,
+                       unsigned band = 0)
+{
+  auto const offsets = band_row_offsets(mm, band);
+  os << "# maptk match matrix coo v1\n"
+     << mm.rows() << " " << mm.cols() << " " << offsets.back() << "\n";
+  for( Eigen::Index i = 0; i < mm.outerSize(); ++i )
+  {
+    for( row_matrix_t::InnerIterator it(mm, i); it; ++it )
+    {
+      if( in_band(i, it.col(), band) )
+      {
+        os << i << " " << it.col() << " " << it.value() << "\n";
+      }
+    }
+  }
+  os.flush();
+}
+
+
+// ------------------------------------------------------------------
+/// Write the match matrix in a compact binary CSR format
+/**
+ * The format, in native byte order, is:
+ *  - 8 byte signature "MAPTKMM\n"
+ *  - uint32 byte order mark 0x01020304 and uint32 version 1
+ *  - uint64 number of rows, columns, and non-zero entries
+ *  - uint64 row offsets (rows + 1 values)
+ *  - uint32 column indices (one per non-zero entry)
+ *  - uint32 values (one per non-zero entry)
+ */
+void
+write_match_matrix_csr(std::ostream& os,
+                       const row_matrix_t& mm,
+                       unsigned band = 0)
+{
+  static const char magic[8] = { 'M', 'A', 'P', 'T', 'K', 'M', 'M', '\n' };
+  const uint32_t header[2] = { 0x01020304, 1 };
+
+  auto const offsets = band_row_offsets(mm, band);
+  const uint64_t sizes[3] = { static_cast<uint64_t>(mm.rows()),
+                              static_cast<uint64_t>(mm.cols()),
+                              offsets.back() };
+  os.write(magic, sizeof(magic));
+  os.write(reinterpret_cast<char const*>(header), sizeof(header));
+  os.write(reinterpret_cast<char const*>(sizes), sizeof(sizes));
+  os.write(reinterpret_cast<char const*>(offsets.data()),
+           offsets.size() * sizeof(uint64_t));
+
+  std::vector<uint32_t> cols, values;
+  cols.reserve(offsets.back());
+  values.reserve(offsets.back());
+  for( Eigen::Index i = 0; i < mm.outerSize(); ++i )
+  {
+    for( row_matrix_t::InnerIterator it(mm, i); it; ++it )
+    {
+      if( in_band(i, it.col(), band) )
+      {
+        cols.push_back(static_cast<uint32_t>(it.col()));
+        values.push_back(it.value());
+      }
+    }
+  }
+  os.write(reinterpret_cast<char const*>(cols.data()),
+           cols.size() * sizeof(uint32_t));
+  os.write(reinterpret_cast<char const*>(values.data()),
+           values.size() * sizeof(uint32_t));
+  os.flush();
 }
 
 
@@ -126,6 +264,8 @@ static int maptk_main(int argc, char const* argv[])
   static std::string opt_in_tracks;
   static std::string opt_out_matrix;
   static std::string opt_out_frames;
+  static std::string opt_format;
+  static unsigned    opt_band( 0 );
 
 
   kwiversys::CommandLineArguments arg;
@@ -136,6 +276,13 @@ static int maptk_main(int argc, char const* argv[])
   arg.AddArgument( "--input-tracks",   argT::SPACE_ARGUMENT, &opt_in_tracks, "Input track file." );
   arg.AddArgument( "--output-matrix",  argT::SPACE_ARGUMENT, &opt_out_matrix, "Output match matrix file" );
   arg.AddArgument( "--output-frames",  argT::SPACE_ARGUMENT, &opt_out_frames, "Output frame number file" );
+  arg.AddArgument( "--format",         argT::SPACE_ARGUMENT, &opt_format,
+                   "Output matrix format: dense, coo, csr, or mtx.  "
+                   "By default the format is chosen from the output file "
+                   "extension (.coo, .csr, .mtx) and is otherwise dense." );
+  arg.AddArgument( "--band",           argT::SPACE_ARGUMENT, &opt_band,
+                   "Only write entries within this many frames of the "
+                   "diagonal (0 writes all entries)" );
 
   if ( ! arg.Parse() )
   {
@@ -155,6 +302,26 @@ static int maptk_main(int argc, char const* argv[])
     return EXIT_FAILURE;
   }
 
+  // determine the output format
+  std::string format = opt_format;
+  if( format.empty() )
+  {
+    std::string const ext = opt_out_matrix.empty() ? std::string()
+      : ST::GetFilenameLastExtension( opt_out_matrix );
+    format = ( ext == ".coo" || ext == ".csr" || ext == ".mtx" )
+             ? ext.substr(1) : "dense";
+  }
+  if( format != "dense" && format != "coo" && format != "csr" && format != "mtx" )
+  {
+    std::cerr << "Unknown match matrix format: " << format << std::endl;
+    return EXIT_FAILURE;
+  }
+  if( format == "csr" && opt_out_matrix.empty() )
+  {
+    std::cerr << "The csr format requires an output matrix file" << std::endl;
+    return EXIT_FAILURE;
+  }
+
   // test the output files
   if( ! opt_out_matrix.empty() )
   {
@@ -171,32 +338,58 @@ static int maptk_main(int argc, char const* argv[])
   // load the tracks
   std::string infile = opt_in_tracks;
   std::cout << "loading: "<< infile << std::endl;
-  vital::track_set_sptr tracks = vital::read_track_file(infile);
+  vital::track_set_sptr tracks = maptk::read_feature_track_file(infile);
 
   // compute the match matrix
   std::cout << "computing matching matrix" <<std::endl;
   std::vector<vital::frame_id_t> frames;
-  Eigen::SparseMatrix<unsigned int> mm = kwiver::arrows::match_matrix(tracks, frames);
+  Eigen::SparseMatrix<unsigned int> mm = maptk::match_matrix(tracks, frames);
+
+  // apply the band to the Matrix Market output, other formats filter
+  // entries as they are written
+  if( format == "mtx" && opt_band > 0 )
+  {
+    mm.prune([](Eigen::Index i, Eigen::Index j, unsigned int)
+             { return in_band(i, j, opt_band); });
+  }
 
   // write output
+  row_matrix_t const rm = mm;
   if( ! opt_out_matrix.empty() )
   {
     vital::path_t outfile( opt_out_matrix );
     std::cout << "writing matrix to: "<< outfile << std::endl;
-    if( ST::GetFilenameExtension( outfile ) == ".mtx" )
+    if( format == "mtx" )
     {
       Eigen::saveMarket(mm, outfile);
     }
+    else if( format == "csr" )
+    {
+      std::ofstream ofs(outfile.c_str(), std::ios::out | std::ios::binary);
+      write_match_matrix_csr(ofs, rm, opt_band);
+    }
+    else if( format == "coo" )
+    {
+      std::ofstream ofs(outfile.c_str());
+      write_match_matrix_coo(ofs, rm, opt_band);
+    }
     else
     {
       std::ofstream ofs(outfile.c_str());
-      write_match_matrix(ofs, mm);
+      write_match_matrix(ofs, rm, opt_band);
     }
   }
   else
   {
     write_frame_numbers(std::cout, frames);
-    write_match_matrix(std::cout, mm);
+    if( format == "coo" )
+    {
+      write_match_matrix_coo(std::cout, rm, opt_band);
+    }
+    else
+    {
+      write_match_matrix(std::cout, rm, opt_band);
+    }
   }
 
   if( ! opt_out_frames.empty() )
@@ -37,17 +37,26 @@
 #define MAPTK_TOOL_COMMON_H_
 
 #include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
 
 #include <vital/exceptions.h>
 #include <vital/io/camera_io.h>
 #include <vital/logger/logger.h>
 #include <vital/types/camera_map.h>
+#include <vital/types/image_container.h>
+#include <vital/types/timestamp.h>
+#include <vital/util/transform_image.h>
 #include <vital/video_metadata/video_metadata.h>
 #include <vital/vital_types.h>
 
 #include <kwiversys/Directory.hxx>
 #include <kwiversys/SystemTools.hxx>
 
+#include <maptk/async_output_sink.h>
+#include <maptk/camera_io.h>
+
 namespace kwiver {
 namespace maptk {
 
@@ -79,22 +88,46 @@ files_in_dir(kwiver::vital::path_t const& vdir)
 
 
 // Load input KRTD cameras from a directory, matching against the given image
-// filename map.
+// filename map.  The path may also be a packed camera archive file.  If
+// use_cache is true, a binary cache of the cameras is kept in the directory
+// as ".maptk_krtd_cache".
 kwiver::vital::camera_map::map_camera_t
 load_input_cameras_krtd(std::string const& krtd_dir,
-                        std::map<kwiver::vital::frame_id_t, std::string> const& basename_map)
+                        std::map<kwiver::vital::frame_id_t, std::string> const& basename_map,
+                        bool use_cache = false)
 {
   kwiver::vital::camera_map::map_camera_t krtd_cams;
-  for (auto p : basename_map)
+  if (kwiversys::SystemTools::FileExists(krtd_dir, true) &&
+      is_camera_archive(krtd_dir))
+  {
+    auto const archive = read_camera_archive(krtd_dir);
+    for (auto const& p : basename_map)
+    {
+      auto itr = archive.find(p.second);
+      if (itr != archive.end())
+      {
+        krtd_cams[p.first] = itr->second;
+      }
+    }
+  }
+  else
   {
-    std::string krtd_filename = krtd_dir + '/' + p.second + ".krtd";
-    try
+    std::vector<std::string> names;
+    names.reserve(basename_map.size());
+    for (auto const& p : basename_map)
     {
-      kwiver::vital::camera_sptr cam = kwiver::vital::read_krtd_file(krtd_filename);
-      krtd_cams[p.first] = cam;
+      names.push_back(p.second);
     }
-    catch(kwiver::vital::file_not_found_exception)
+    auto const dir_cams = read_krtd_directory(
+      krtd_dir, names,
+      use_cache ? krtd_dir + "/.maptk_krtd_cache" : std::string());
+    for (auto const& p : basename_map)
     {
+      auto itr = dir_cams.find(p.second);
+      if (itr != dir_cams.end())
+      {
+        krtd_cams[p.first] = itr->second;
+      }
     }
   }
 
@@ -122,6 +155,180 @@ load_input_cameras_krtd(std::string const& krtd_dir,
 
 
 
+// Write one KRTD file per camera, named by the frame basename, in parallel
+// through the given output sink.
+void
+write_output_cameras_krtd(kwiver::vital::camera_map::map_camera_t const& cameras,
+                          std::map<kwiver::vital::frame_id_t, std::string> const& basename_map,
+                          kwiver::vital::path_t const& krtd_dir,
+                          async_output_sink& sink)
+{
+  // create the directory once rather than from every job
+  kwiversys::SystemTools::MakeDirectory(krtd_dir);
+  for (auto const& p : cameras)
+  {
+    auto const bn = basename_map.find(p.first);
+    if (p.second && bn != basename_map.end())
+    {
+      kwiver::vital::camera_sptr cam = p.second;
+      kwiver::vital::path_t out_krtd_file = krtd_dir + "/" + bn->second + ".krtd";
+      sink.add([cam, out_krtd_file]()
+      {
+        kwiver::vital::write_krtd_file( *cam, out_krtd_file );
+      });
+    }
+  }
+}
+
+
+// Write all cameras into a single packed camera archive, named by the frame
+// basename.
+void
+write_output_camera_archive(kwiver::vital::camera_map::map_camera_t const& cameras,
+                            std::map<kwiver::vital::frame_id_t, std::string> const& basename_map,
+                            kwiver::vital::path_t const& archive_file)
+{
+  std::map<std::string, kwiver::vital::camera_sptr> named_cams;
+  for (auto const& p : cameras)
+  {
+    auto const bn = basename_map.find(p.first);
+    if (p.second && bn != basename_map.end())
+    {
+      named_cams[bn->second] = p.second;
+    }
+  }
+  write_camera_archive(named_cams, archive_file);
+}
+
+
+/// Extract the mask image from the container, invert, and repackage
+kwiver::vital::image_container_sptr
+invert_mask_image(kwiver::vital::image_container_sptr mask)
+{
+  vital::logger_handle_t logger( vital::get_logger( "invert_mask_image" ) );
+  LOG_DEBUG( logger,
+             "Inverting mask image pixels" );
+  kwiver::vital::image_of<bool> mask_image;
+  kwiver::vital::cast_image( mask->get_image(), mask_image );
+  kwiver::vital::transform_image( mask_image, [] (bool b) { return !b; } );
+  LOG_DEBUG( logger,
+             "Inverting mask image pixels -- Done" );
+  return std::make_shared<kwiver::vital::simple_image_container>( mask_image );
+}
+
+
+/// Validate a mask image according to the expected number of channels.
+bool validate_mask_image( kwiver::vital::image_container_sptr mask,
+                          bool expect_multichannel_masks=false )
+{
+  vital::logger_handle_t logger( vital::get_logger( "validate_mask_image" ) );
+  // error out if we are not expecting a multi-channel mask
+  if( !expect_multichannel_masks && mask->depth() > 1 )
+  {
+    LOG_ERROR( logger,
+               "Encounted multi-channel mask image!" );
+    return false;
+  }
+  else if( expect_multichannel_masks && mask->depth() == 1 )
+  {
+    LOG_WARN( logger,
+              "Expecting multi-channel masks but received one that was "
+              "single-channel." );
+  }
+  return true;
+}
+
+
+/// Read a frame index previously written with write_frame_index
+/**
+ * A frame index caches the timestamp of every frame in a video so that tools
+ * can learn the frame count without scanning the whole video first.  The
+ * index is only considered valid if it is newer than the video source.
+ *
+ * \param index_file the path to the frame index file
+ * \param video_source the path to the video described by the index
+ * \param [out] timestamps the timestamps of every frame in the video
+ * \returns true if a valid index was read
+ */
+bool
+read_frame_index(kwiver::vital::path_t const& index_file,
+                 kwiver::vital::path_t const& video_source,
+                 std::vector<kwiver::vital::timestamp>& timestamps)
+{
+  typedef kwiversys::SystemTools ST;
+  vital::logger_handle_t logger( vital::get_logger( "read_frame_index" ) );
+
+  timestamps.clear();
+  int cmp = 0;
+  if ( index_file.empty() || !ST::FileExists( index_file, true ) ||
+       !ST::FileTimeCompare( index_file, video_source, &cmp ) || cmp < 0 )
+  {
+    return false;
+  }
+
+  std::ifstream ifs( index_file.c_str() );
+  std::string header;
+  size_t num_frames = 0;
+  if ( !std::getline( ifs, header ) || header != "# maptk frame index v1" ||
+       !( ifs >> num_frames ) )
+  {
+    LOG_WARN( logger, "Ignoring invalid frame index: " << index_file );
+    return false;
+  }
+
+  timestamps.reserve( num_frames );
+  kwiver::vital::frame_id_t frame;
+  kwiver::vital::time_us_t time;
+  while ( timestamps.size() < num_frames && ifs >> frame >> time )
+  {
+    kwiver::vital::timestamp ts;
+    ts.set_frame( frame );
+    if ( time >= 0 )
+    {
+      ts.set_time_usec( time );
+    }
+    timestamps.push_back( ts );
+  }
+
+  if ( timestamps.size() != num_frames )
+  {
+    LOG_WARN( logger, "Ignoring truncated frame index: " << index_file );
+    timestamps.clear();
+    return false;
+  }
+  LOG_DEBUG( logger, "Read index of " << num_frames << " frames from "
+                     << index_file );
+  return true;
+}
+
+
+/// Write a frame index of the timestamps of every frame in a video
+/**
+ * \param index_file the path to the frame index file to write
+ * \param timestamps the timestamps of every frame in the video, in order
+ */
+void
+write_frame_index(kwiver::vital::path_t const& index_file,
+                  std::vector<kwiver::vital::timestamp> const& timestamps)
+{
+  std::ofstream ofs( index_file.c_str() );
+  if ( !ofs )
+  {
+    vital::logger_handle_t logger( vital::get_logger( "write_frame_index" ) );
+    LOG_WARN( logger, "Could not open frame index for writing: "
+                      << index_file );
+    return;
+  }
+
+  ofs << "# maptk frame index v1\n" << timestamps.size() << "\n";
+  for ( auto const& ts : timestamps )
+  {
+    ofs << ts.get_frame() << " "
+        << ( ts.has_valid_time() ? ts.get_time_usec() : -1 ) << "\n";
+  }
+}
+
+
 } // end namespace maptk
 } // end namespace kwiver
 
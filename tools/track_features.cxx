@@ -33,13 +33,23 @@
  * \brief Feature tracker utility
  */
 
+#include "tool_common.h"
+
+#include <algorithm>
+#include <deque>
 #include <iostream>
 #include <fstream>
 #include <exception>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
 #include <string>
 #include <vector>
 
 #include <maptk/colorize.h>
+#include <maptk/feature_track_io.h>
 
 #include <vital/config/config_block.h>
 #include <vital/config/config_block_io.h>
@@ -50,12 +60,15 @@
 #include <vital/vital_types.h>
 #include <vital/algo/image_io.h>
 #include <vital/algo/convert_image.h>
+#include <vital/algo/feature_descriptor_io.h>
 #include <vital/algo/track_features.h>
 #include <vital/algo/compute_ref_homography.h>
 #include <vital/algo/video_input.h>
+#include <vital/types/descriptor_set.h>
+#include <vital/types/feature_set.h>
 #include <vital/plugin_loader/plugin_manager.h>
 #include <vital/util/get_paths.h>
-#include <vital/util/transform_image.h>
+#include <vital/util/thread_pool.h>
 
 #include <kwiversys/SystemTools.hxx>
 #include <kwiversys/CommandLineArguments.hxx>
@@ -67,6 +80,24 @@ typedef kwiversys::CommandLineArguments argT;
 
 static kwiver::vital::logger_handle_t main_logger( kwiver::vital::get_logger( "track_features_tool" ) );
 
+/// A frame read and prepared by the prefetch stage, ready for tracking
+struct prefetched_frame
+{
+  /// The order in which this frame was read from the video
+  size_t index;
+  /// The timestamp of the frame
+  kwiver::vital::timestamp ts;
+  /// The original image, used for colorizing features
+  kwiver::vital::image_container_sptr image;
+  /// The converted image, with metadata attached, given to the tracker
+  kwiver::vital::image_container_sptr converted_image;
+  /// The converted mask image, if masks are in use
+  kwiver::vital::image_container_sptr converted_mask;
+};
+
+typedef std::shared_ptr<prefetched_frame> prefetched_frame_sptr;
+
+
 // ------------------------------------------------------------------
 static kwiver::vital::config_block_sptr default_config()
 {
@@ -98,15 +129,35 @@ static kwiver::vital::config_block_sptr default_config()
                     "warning when a single-channel mask is provided. If this "
                     "is false we error upon seeing a multi-channel mask "
                     "image.");
+  config->set_value("frame_index_file", "",
+                    "Optional path to a cache of the timestamps of every "
+                    "frame in ``video_source``. If this file exists and is "
+                    "newer than the video it provides the frame count up "
+                    "front, so the mask list can be validated before "
+                    "processing begins. Otherwise the video is read in a "
+                    "single streaming pass, mask images are validated as "
+                    "frames arrive, and the index is written here for later "
+                    "runs. Leave blank to disable the cache.");
   config->set_value("output_tracks_file", "",
                     "Path to a file to write output tracks to. If this "
-                    "file exists, it will be overwritten.");
+                    "file exists, it will be overwritten. Tracks are "
+                    "written in the binary track format if the file "
+                    "extension is \".kwbt\".");
   config->set_value("output_homography_file", "",
                     "Optional path to a file to write source-to-reference "
                     "homographies for each frame. Leave blank to disable this "
                     "output. The output_homography_generator algorithm type "
                     "only needs to be set if this is set.");
 
+  config->set_value("checkpoint_interval", 0,
+                    "Number of frames between checkpoints of the tracking "
+                    "results. Each checkpoint appends the track states of the "
+                    "newly tracked frames to ``output_tracks_file`` with a "
+                    "\".ckpt\" extension, and the --resume option continues "
+                    "tracking from the last checkpoint. The checkpoint is "
+                    "removed when tracking completes. Set to 0 to disable "
+                    "checkpoints.");
+
   kwiver::vital::algo::video_input::get_nested_algo_configuration("video_reader", config,
                                       kwiver::vital::algo::video_input_sptr());
   kwiver::vital::algo::track_features::get_nested_algo_configuration("feature_tracker", config,
@@ -117,6 +168,8 @@ static kwiver::vital::config_block_sptr default_config()
                                       kwiver::vital::algo::convert_image_sptr());
   kwiver::vital::algo::compute_ref_homography::get_nested_algo_configuration("output_homography_generator",
                               config, kwiver::vital::algo::compute_ref_homography_sptr());
+  kwiver::vital::algo::feature_descriptor_io::get_nested_algo_configuration("checkpoint_fd_io",
+                              config, kwiver::vital::algo::feature_descriptor_io_sptr());
   return config;
 }
 
@@ -157,6 +210,25 @@ static bool check_config(kwiver::vital::config_block_sptr config)
     }
   }
 
+  // A given frame index file is invalid if it names a directory, or if its
+  // parent path does not exist.
+  if ( config->has_value("frame_index_file")
+    && config->get_value<std::string>("frame_index_file") != "" )
+  {
+    kwiver::vital::config_path_t fp = config->get_value<kwiver::vital::config_path_t>("frame_index_file");
+    if ( ST::FileIsDirectory( fp ) )
+    {
+      MAPTK_CONFIG_FAIL("Given frame index file is a directory! "
+                        << "(Given: " << fp << ")");
+    }
+    else if ( ST::GetFilenamePath( fp ) != "" &&
+              ! ST::FileIsDirectory( ST::GetFilenamePath( fp ) ))
+    {
+      MAPTK_CONFIG_FAIL("Given frame index file does not have a valid "
+                        << "parent path! (Given: " << fp << ")");
+    }
+  }
+
   if ( ! config->has_value("video_source") ||
       config->get_value<std::string>("video_source") == "")
   {
@@ -212,18 +284,282 @@ static bool check_config(kwiver::vital::config_block_sptr config)
     MAPTK_CONFIG_FAIL("convert_image configuration check failed");
   }
 
+  // Check that the checkpoint fd_io algo is correctly configured, if used
+  if ( config->get_value<unsigned>("checkpoint_interval", 0) > 0 &&
+       config->has_value("checkpoint_fd_io:type") &&
+       config->get_value<std::string>("checkpoint_fd_io:type") != "" &&
+       !kwiver::vital::algo::feature_descriptor_io
+          ::check_nested_algo_configuration("checkpoint_fd_io", config) )
+  {
+    MAPTK_CONFIG_FAIL("checkpoint_fd_io configuration check failed");
+  }
+
 #undef MAPTK_CONFIG_FAIL
 
   return config_valid;
 }
 
 
+// ------------------------------------------------------------------
+/// Return the path of the features file saved with a checkpoint
+static kwiver::vital::path_t
+checkpoint_features_file(kwiver::vital::path_t const& checkpoint_file,
+                         kwiver::vital::frame_id_t frame)
+{
+  return checkpoint_file + "." + std::to_string(frame) + ".kwfd";
+}
+
+
+// ------------------------------------------------------------------
+/// Truncate a file to at most the given number of bytes
+static void
+truncate_file(kwiver::vital::path_t const& filepath, std::streamoff size)
+{
+  std::string contents(static_cast<size_t>(size), '\0');
+  {
+    std::ifstream ifs(filepath.c_str(), std::ios::binary);
+    ifs.read(&contents[0], size);
+    contents.resize(static_cast<size_t>(ifs.gcount()));
+  }
+  std::ofstream ofs(filepath.c_str(), std::ios::binary | std::ios::trunc);
+  ofs.write(contents.data(), contents.size());
+}
+
+
+// ------------------------------------------------------------------
+/// Append the track states of newly tracked frames to a checkpoint
+/**
+ * A checkpoint is a text file with one "s" line per track state, giving the
+ * frame, track ID, and feature.  Each checkpoint ends with a "d" line listing
+ * the IDs of the tracks whose descriptors were saved for the last frame,
+ * in the order saved, and a "c" line that commits the preceding states and
+ * records the last frame and the size of the homography output.  Only data
+ * followed by a commit is used when resuming.
+ *
+ * If \p fd_io is given, the features and descriptors of the last frame are
+ * saved with it so that the tracker can match against them after resuming.
+ */
+static void
+write_checkpoint(std::ostream& ckpt_os,
+                 kwiver::vital::path_t const& checkpoint_file,
+                 kwiver::vital::feature_track_set const& tracks,
+                 std::vector<kwiver::vital::frame_id_t> const& frames,
+                 std::streamoff homog_offset,
+                 kwiver::vital::algo::feature_descriptor_io_sptr fd_io)
+{
+  using namespace kwiver;
+
+  if( frames.empty() )
+  {
+    return;
+  }
+  vital::frame_id_t const last_frame = frames.back();
+
+  std::vector<vital::track_id_t> desc_ids;
+  std::vector<vital::feature_sptr> last_features;
+  std::vector<vital::descriptor_sptr> last_descriptors;
+  for( auto const frame : frames )
+  {
+    for( auto const& track : tracks.active_tracks(frame) )
+    {
+      auto const it = track->find(frame);
+      if( it == track->end() )
+      {
+        continue;
+      }
+      auto fts = std::dynamic_pointer_cast<vital::feature_track_state>(*it);
+      if( !fts || !fts->feature )
+      {
+        continue;
+      }
+      ckpt_os << "s " << frame << " " << track->id() << " "
+              << *fts->feature << "\n";
+      if( frame == last_frame && fts->descriptor )
+      {
+        desc_ids.push_back(track->id());
+        last_features.push_back(fts->feature);
+        last_descriptors.push_back(fts->descriptor);
+      }
+    }
+  }
+
+  if( fd_io )
+  {
+    fd_io->save(checkpoint_features_file(checkpoint_file, last_frame),
+                std::make_shared<vital::simple_feature_set>(last_features),
+                std::make_shared<vital::simple_descriptor_set>(last_descriptors));
+  }
+  else
+  {
+    desc_ids.clear();
+  }
+
+  ckpt_os << "d";
+  for( auto const id : desc_ids )
+  {
+    ckpt_os << " " << id;
+  }
+  ckpt_os << "\nc " << last_frame << " " << homog_offset << std::endl;
+}
+
+
+// ------------------------------------------------------------------
+/// Read the track states committed to a checkpoint
+/**
+ * Any partially written data following the last commit is truncated from
+ * the file so that new checkpoints can be appended to it.
+ *
+ * \returns true if at least one committed checkpoint was read
+ */
+static bool
+read_checkpoint(kwiver::vital::path_t const& checkpoint_file,
+                kwiver::vital::algo::feature_descriptor_io_sptr fd_io,
+                kwiver::vital::feature_track_set_sptr& tracks,
+                kwiver::vital::frame_id_t& last_frame,
+                std::streamoff& homog_offset)
+{
+  using namespace kwiver;
+
+  std::ifstream ifs(checkpoint_file.c_str());
+  if( !ifs )
+  {
+    return false;
+  }
+
+  std::map<vital::track_id_t, vital::track_sptr> track_map;
+  std::vector<std::pair<vital::track_id_t, vital::track_state_sptr> > pending;
+  std::vector<vital::track_id_t> pending_desc_ids, desc_ids;
+  std::streamoff committed_size = 0;
+  bool committed = false;
+
+  std::istringstream ss;
+  for( std::string line; std::getline(ifs, line) && !ifs.eof(); )
+  {
+    ss.clear();
+    ss.str(line);
+    char type = '#';
+    ss >> type;
+    if( type == '#' )
+    {
+      continue;
+    }
+    else if( type == 's' )
+    {
+      vital::frame_id_t frame;
+      vital::track_id_t id;
+      auto feat = std::make_shared<vital::feature_d>();
+      if( !(ss >> frame >> id >> *feat) )
+      {
+        break;
+      }
+      pending.push_back(std::make_pair(id,
+        std::make_shared<vital::feature_track_state>(frame, feat,
+                                                     vital::descriptor_sptr())));
+    }
+    else if( type == 'd' )
+    {
+      pending_desc_ids.clear();
+      for( vital::track_id_t id; ss >> id; )
+      {
+        pending_desc_ids.push_back(id);
+      }
+    }
+    else if( type == 'c' )
+    {
+      // Parse the whole commit line before accepting any of it, as a
+      // truncated line may still yield a frame number
+      vital::frame_id_t commit_frame;
+      std::streamoff commit_offset;
+      if( !(ss >> commit_frame >> commit_offset) )
+      {
+        break;
+      }
+      last_frame = commit_frame;
+      homog_offset = commit_offset;
+      for( auto const& p : pending )
+      {
+        auto& t = track_map[p.first];
+        if( !t )
+        {
+          t = vital::track::create();
+          t->set_id(p.first);
+        }
+        t->append(p.second);
+      }
+      pending.clear();
+      desc_ids.swap(pending_desc_ids);
+      pending_desc_ids.clear();
+      committed = true;
+      committed_size = ifs.tellg();
+    }
+    else
+    {
+      break;
+    }
+  }
+  ifs.close();
+
+  truncate_file(checkpoint_file, committed_size);
+  if( !committed )
+  {
+    return false;
+  }
+
+  // restore the descriptors on the last frame so the tracker can match them
+  auto const features_file = checkpoint_features_file(checkpoint_file, last_frame);
+  vital::feature_set_sptr feat;
+  vital::descriptor_set_sptr desc;
+  if( fd_io && !desc_ids.empty() && ST::FileExists(features_file) )
+  {
+    fd_io->load(features_file, feat, desc);
+  }
+  if( desc && desc->size() == desc_ids.size() )
+  {
+    auto const descriptors = desc->descriptors();
+    for( size_t i = 0; i < desc_ids.size(); ++i )
+    {
+      auto const t = track_map.find(desc_ids[i]);
+      if( t == track_map.end() )
+      {
+        continue;
+      }
+      auto const it = t->second->find(last_frame);
+      if( it == t->second->end() )
+      {
+        continue;
+      }
+      auto fts = std::dynamic_pointer_cast<vital::feature_track_state>(*it);
+      if( fts )
+      {
+        fts->descriptor = descriptors[i];
+      }
+    }
+  }
+  else
+  {
+    LOG_WARN(main_logger, "No descriptors found for checkpoint frame "
+                          << last_frame << "; existing tracks will not be "
+                          "extended after resuming");
+  }
+
+  std::vector<vital::track_sptr> track_vec;
+  track_vec.reserve(track_map.size());
+  for( auto const& p : track_map )
+  {
+    track_vec.push_back(p.second);
+  }
+  tracks = std::make_shared<vital::feature_track_set>(track_vec);
+  return true;
+}
+
+
 // ------------------------------------------------------------------
 static int maptk_main(int argc, char const* argv[])
 {
   static bool        opt_help(false);
   static std::string opt_config;
   static std::string opt_out_config;
+  static bool        opt_resume(false);
 
   kwiversys::CommandLineArguments arg;
 
@@ -238,6 +574,8 @@ static int maptk_main(int argc, char const* argv[])
                    "Output a configuration. This may be seeded with a configuration file from -c/--config." );
   arg.AddArgument( "-o",            argT::SPACE_ARGUMENT, &opt_out_config,
                    "Output a configuration. This may be seeded with a configuration file from -c/--config." );
+  arg.AddArgument( "--resume",      argT::NO_ARGUMENT, &opt_resume,
+                   "Resume tracking from the last checkpoint, if one exists." );
 
     if ( ! arg.Parse() )
   {
@@ -273,6 +611,7 @@ static int maptk_main(int argc, char const* argv[])
   kwiver::vital::algo::image_io_sptr image_reader;
   kwiver::vital::algo::convert_image_sptr image_converter;
   kwiver::vital::algo::compute_ref_homography_sptr out_homog_generator;
+  kwiver::vital::algo::feature_descriptor_io_sptr checkpoint_fd_io;
 
   // If -c/--config given, read in confg file, merge in with default just generated
   if( ! opt_config.empty() )
@@ -292,6 +631,8 @@ static int maptk_main(int argc, char const* argv[])
   kwiver::vital::algo::convert_image::get_nested_algo_configuration("convert_image", config, image_converter);
   kwiver::vital::algo::compute_ref_homography::set_nested_algo_configuration("output_homography_generator", config, out_homog_generator);
   kwiver::vital::algo::compute_ref_homography::get_nested_algo_configuration("output_homography_generator", config, out_homog_generator);
+  kwiver::vital::algo::feature_descriptor_io::set_nested_algo_configuration("checkpoint_fd_io", config, checkpoint_fd_io);
+  kwiver::vital::algo::feature_descriptor_io::get_nested_algo_configuration("checkpoint_fd_io", config, checkpoint_fd_io);
 
   bool valid_config = check_config(config);
 
@@ -318,25 +659,24 @@ static int maptk_main(int argc, char const* argv[])
   //  - filepath validity checked above
   std::string video_source = config->get_value<std::string>("video_source");
   std::string mask_list_file = config->get_value<std::string>("mask_list_file");
+  std::string frame_index_file = config->get_value<std::string>("frame_index_file");
   bool invert_masks = config->get_value<bool>("invert_masks");
   bool expect_multichannel_masks = config->get_value<bool>("expect_multichannel_masks");
   std::string output_tracks_file = config->get_value<std::string>("output_tracks_file");
+  unsigned checkpoint_interval = config->get_value<unsigned>("checkpoint_interval");
+  kwiver::vital::path_t checkpoint_file = output_tracks_file + ".ckpt";
 
 
   LOG_INFO( main_logger, "Reading Video" );
   video_reader->open(video_source);
 
-  // Pre-scan the video to get an accurate frame count
-  // We may wish to remove this later if we start operating on live streams
-  kwiver::vital::timestamp ts;
+  // Use a cached frame index, if available, to get an accurate frame count.
+  // Otherwise the video is read in a single pass, which also allows
+  // operating on live streams, and the frame timestamps are collected
+  // along the way to build the index.
   std::vector<kwiver::vital::timestamp> timestamps;
-  while( video_reader->next_frame(ts) )
-  {
-    timestamps.push_back(ts);
-  }
-  // close and re-open to return to the video start
-  video_reader->close();
-  video_reader->open(video_source);
+  bool const have_frame_index =
+    kwiver::maptk::read_frame_index(frame_index_file, video_source, timestamps);
 
 
   // Create mask image list if a list file was given, else fill list with empty
@@ -363,8 +703,9 @@ static int maptk_main(int argc, char const* argv[])
         throw kwiver::vital::path_not_exists( mask_files[mask_files.size()-1] );
       }
     }
-    // Check that image/mask list sizes are the same
-    if( timestamps.size() != mask_files.size() )
+    // Check that image/mask list sizes are the same.  Without a frame index
+    // this is checked lazily as frames are read.
+    if( have_frame_index && timestamps.size() != mask_files.size() )
     {
       throw kwiver::vital::invalid_value("video and mask file lists have "
                                          "different frame counts");
@@ -373,6 +714,26 @@ static int maptk_main(int argc, char const* argv[])
                "Validated " << mask_files.size() << " mask image files." );
   }
 
+  // Reload the tracks from the last checkpoint if resuming
+  kwiver::vital::feature_track_set_sptr tracks;
+  kwiver::vital::frame_id_t resume_frame = -1;
+  std::streamoff homog_offset = 0;
+  if( opt_resume )
+  {
+    if( read_checkpoint(checkpoint_file, checkpoint_fd_io, tracks,
+                        resume_frame, homog_offset) )
+    {
+      LOG_INFO(main_logger, "Resuming from checkpoint at frame " << resume_frame
+                            << " with " << tracks->size() << " tracks");
+    }
+    else
+    {
+      LOG_WARN(main_logger, "No checkpoint found in " << checkpoint_file
+                            << ", starting from the beginning");
+      homog_offset = 0;
+    }
+  }
+
   // verify that we can open the output file for writing
   // so that we don't find a problem only after spending
   // hours of computation time.
@@ -392,7 +753,16 @@ static int maptk_main(int argc, char const* argv[])
        config->get_value<std::string>("output_homography_file") != "" )
   {
     kwiver::vital::path_t homog_fp = config->get_value<kwiver::vital::path_t>("output_homography_file");
-    homog_ofs.open( homog_fp.c_str() );
+    if( resume_frame >= 0 )
+    {
+      // keep only the homographies covered by the checkpoint
+      truncate_file( homog_fp, homog_offset );
+      homog_ofs.open( homog_fp.c_str(), std::ios::app );
+    }
+    else
+    {
+      homog_ofs.open( homog_fp.c_str() );
+    }
     if ( !homog_ofs )
     {
       LOG_ERROR(main_logger, "Could not open homography file for writing: "
@@ -401,60 +771,120 @@ static int maptk_main(int argc, char const* argv[])
     }
   }
 
-  // Track features on each frame sequentially
-  kwiver::vital::feature_track_set_sptr tracks;
-  while( video_reader->next_frame(ts) )
+  // Open the checkpoint for appending new track states
+  std::ofstream ckpt_ofs;
+  if( checkpoint_interval > 0 )
   {
-    LOG_INFO(main_logger, "processing frame "<<ts.get_frame() );
+    if( resume_frame >= 0 )
+    {
+      ckpt_ofs.open( checkpoint_file.c_str(), std::ios::app );
+    }
+    else
+    {
+      ckpt_ofs.open( checkpoint_file.c_str() );
+      ckpt_ofs << "# maptk track checkpoint v1" << std::endl;
+    }
+    if( !ckpt_ofs )
+    {
+      LOG_ERROR(main_logger, "Could not open checkpoint file for writing: "
+                             << checkpoint_file);
+      return EXIT_FAILURE;
+    }
+  }
+
+  // Skip over the frames already covered by the checkpoint
+  if( resume_frame >= 0 )
+  {
+    kwiver::vital::timestamp ts;
+    while( video_reader->next_frame(ts) )
+    {
+      if( !have_frame_index )
+      {
+        timestamps.push_back(ts);
+      }
+      if( ts.get_frame() >= resume_frame )
+      {
+        break;
+      }
+    }
+  }
+
+  // Frames are processed in two stages.  The prefetch stage runs on the
+  // thread pool and reads, converts, and masks frames ahead of the tracker.
+  // The tracking stage runs on this thread and consumes prefetched frames
+  // strictly in the order they were read from the video.
+  std::mutex video_mutex;
+  size_t frames_read = 0;
 
-    auto const image = video_reader->frame_image();
-    auto const mdv = video_reader->frame_metadata();
-    auto converted_image = image_converter->convert( image );
+  // This lambda function runs in a thread to read and prepare the next frame.
+  // It returns nullptr when the end of the video is reached.
+  auto prefetch_frame = [&] () -> prefetched_frame_sptr
+  {
+    auto frame = std::make_shared<prefetched_frame>();
+    kwiver::vital::video_metadata_vector mdv;
+    {
+      // lock the video mutex while incrementing the video and getting a frame
+      std::lock_guard<std::mutex> vlock(video_mutex);
+      if( !video_reader->next_frame(frame->ts) )
+      {
+        return nullptr;
+      }
+      frame->index = frames_read++;
+      frame->image = video_reader->frame_image();
+      mdv = video_reader->frame_metadata();
+      if( !have_frame_index )
+      {
+        timestamps.push_back(frame->ts);
+      }
+    }
+
+    frame->converted_image = image_converter->convert( frame->image );
     if( !mdv.empty() )
     {
-      converted_image->set_metadata( mdv[0] );
+      frame->converted_image->set_metadata( mdv[0] );
     }
 
     // Load the mask for this image if we were given a mask image list
-    kwiver::vital::image_container_sptr mask, converted_mask;
     if( use_masks )
     {
-      mask = image_reader->load( mask_files[ts.get_frame()] );
-
-      // error out if we are not expecting a multi-channel mask
-      if( !expect_multichannel_masks && mask->depth() > 1 )
+      if( frame->ts.get_frame() >= static_cast<kwiver::vital::frame_id_t>(mask_files.size()) )
       {
-        LOG_ERROR( main_logger,
-                   "Encounted multi-channel mask image!" );
-        return EXIT_FAILURE;
+        throw kwiver::vital::invalid_value("video has more frames than the "
+                                           "mask file list");
       }
-      else if( expect_multichannel_masks && mask->depth() == 1 )
+      auto mask = image_reader->load( mask_files[frame->ts.get_frame()] );
+
+      if( !kwiver::maptk::validate_mask_image( mask, expect_multichannel_masks ) )
       {
-        LOG_WARN( main_logger,
-                  "Expecting multi-channel masks but received one that was "
-                  "single-channel." );
+        throw kwiver::vital::invalid_value("mask image has an unexpected "
+                                           "number of channels");
       }
 
       if( invert_masks )
       {
-        LOG_DEBUG( main_logger,
-                   "Inverting mask image pixels" );
-        kwiver::vital::image_of<bool> mask_image;
-        kwiver::vital::cast_image( mask->get_image(), mask_image );
-        kwiver::vital::transform_image( mask_image, [] (bool b) { return !b; } );
-        LOG_DEBUG( main_logger,
-                   "Inverting mask image pixels -- Done" );
-        mask = std::make_shared<kwiver::vital::simple_image_container>( mask_image );
+        mask = kwiver::maptk::invert_mask_image( mask );
       }
 
-      converted_mask = image_converter->convert( mask );
+      frame->converted_mask = image_converter->convert( mask );
     }
+    return frame;
+  };
+
+  // Track features on each prefetched frame sequentially
+  std::vector<kwiver::vital::frame_id_t> checkpoint_frames;
+  kwiver::vital::frame_id_t last_checkpoint_frame = resume_frame;
+  auto track_frame = [&] (prefetched_frame const& frame)
+  {
+    auto const& ts = frame.ts;
+    LOG_INFO(main_logger, "processing frame "<<ts.get_frame() );
 
     tracks = feature_tracker->track(tracks, ts.get_frame(),
-                                    converted_image, converted_mask);
+                                    frame.converted_image,
+                                    frame.converted_mask);
     if (tracks)
     {
-      tracks = kwiver::maptk::extract_feature_colors(tracks, *image, ts.get_frame());
+      tracks = kwiver::maptk::extract_feature_colors(tracks, *frame.image,
+                                                     ts.get_frame());
     }
 
     // Compute ref homography for current frame with current track set + write to file
@@ -464,6 +894,81 @@ static int maptk_main(int argc, char const* argv[])
       LOG_DEBUG(main_logger, "writing homography");
       homog_ofs << *(out_homog_generator->estimate(ts.get_frame(), tracks)) << std::endl;
     }
+
+    // Periodically append the newly tracked frames to the checkpoint
+    if ( ckpt_ofs.is_open() && tracks )
+    {
+      checkpoint_frames.push_back(ts.get_frame());
+      if( checkpoint_frames.size() >= checkpoint_interval )
+      {
+        LOG_DEBUG(main_logger, "writing checkpoint");
+        std::streamoff const offset = homog_ofs.is_open() ? homog_ofs.tellp()
+                                                          : std::streamoff(0);
+        write_checkpoint(ckpt_ofs, checkpoint_file, *tracks, checkpoint_frames,
+                         offset, checkpoint_fd_io);
+        // the previous features file is superseded by the new one
+        if( last_checkpoint_frame >= 0 )
+        {
+          ST::RemoveFile(checkpoint_features_file(checkpoint_file,
+                                                  last_checkpoint_frame));
+        }
+        last_checkpoint_frame = checkpoint_frames.back();
+        checkpoint_frames.clear();
+      }
+    }
+  };
+
+  // access the thread pool
+  auto& pool = kwiver::vital::thread_pool::instance();
+
+  // queue of future returns from prefetch jobs
+  std::deque<std::future<prefetched_frame_sptr> > prefetch_queue;
+
+  // prefetched frames that completed ahead of the next frame to track
+  std::map<size_t, prefetched_frame_sptr> ready_frames;
+
+  // number of jobs to keep in the queue
+  // this bounds the number of decoded frames held in memory at once
+  size_t const buffer = std::max<size_t>(pool.num_threads() * 3 / 2, 2);
+  size_t next_index = 0;
+  bool end_of_video = false;
+  try
+  {
+    while( !end_of_video || !prefetch_queue.empty() )
+    {
+      // keep the prefetch stage filled up to the buffer size
+      while( !end_of_video && prefetch_queue.size() < buffer )
+      {
+        prefetch_queue.push_back(pool.enqueue(prefetch_frame));
+      }
+
+      // wait for the oldest job to complete
+      auto frame = prefetch_queue.front().get();
+      prefetch_queue.pop_front();
+      if( !frame )
+      {
+        end_of_video = true;
+        continue;
+      }
+      ready_frames[frame->index] = frame;
+
+      // track all frames that are ready, in the order they were read
+      for( auto it = ready_frames.find(next_index); it != ready_frames.end();
+           it = ready_frames.find(++next_index) )
+      {
+        track_frame(*it->second);
+        ready_frames.erase(it);
+      }
+    }
+  }
+  catch(...)
+  {
+    // the jobs reference local state, so let them finish before unwinding
+    for( auto& f : prefetch_queue )
+    {
+      f.wait();
+    }
+    throw;
   }
 
   if ( homog_ofs.is_open() )
@@ -471,8 +976,34 @@ static int maptk_main(int argc, char const* argv[])
     homog_ofs.close();
   }
 
+  if( !have_frame_index )
+  {
+    // Check this before writing the index, so that a bad run leaves none
+    if( use_masks && timestamps.size() != mask_files.size() )
+    {
+      throw kwiver::vital::invalid_value("video and mask file lists have "
+                                         "different frame counts");
+    }
+    if( !frame_index_file.empty() )
+    {
+      kwiver::maptk::write_frame_index(frame_index_file, timestamps);
+    }
+  }
+
   // Writing out tracks to file
-  kwiver::vital::write_feature_track_file(tracks, output_tracks_file);
+  kwiver::maptk::write_feature_track_file(tracks, output_tracks_file);
+
+  // The checkpoint is no longer needed once the full output is written
+  if( ckpt_ofs.is_open() )
+  {
+    ckpt_ofs.close();
+    ST::RemoveFile(checkpoint_file);
+    if( last_checkpoint_frame >= 0 )
+    {
+      ST::RemoveFile(checkpoint_features_file(checkpoint_file,
+                                              last_checkpoint_frame));
+    }
+  }
 
   return EXIT_SUCCESS;
 }